@@ -0,0 +1,84 @@
+/* Frustum culling microbenchmark: batched sphere and AABB tests.
+ * Build with -DENGINE_BUILD_BENCHMARKS=ON. */
+#include "engine/renderer/culling.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static f64 now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+static f32 random_range(f32 lo, f32 hi) {
+    return lo + (f32)rand() / (f32)RAND_MAX * (hi - lo);
+}
+
+static void bench_size(const Frustum* frustum, u32 count) {
+    Vec3Stream centers, extents;
+    f32* radii = (f32*)malloc(count * sizeof(f32));
+    u32* visible = (u32*)malloc(count * sizeof(u32));
+    if (!radii || !visible || !vec3_stream_init(&centers, count) || !vec3_stream_init(&extents, count)) {
+        fprintf(stderr, "Out of memory at %u\n", count);
+        return;
+    }
+
+    /* Objects scattered around the camera in every direction */
+    for (u32 i = 0; i < count; i++) {
+        vec3_stream_set(&centers, i, vec3_create(random_range(-500, 500), random_range(-20, 50),
+                                                 random_range(-500, 500)));
+        f32 r = random_range(0.5f, 4.0f);
+        radii[i] = r;
+        vec3_stream_set(&extents, i, vec3_create(r, r * 0.5f, r));
+    }
+    centers.count = count;
+    extents.count = count;
+
+    const int runs = 20;
+    u32 sphere_visible = 0, aabb_visible = 0;
+
+    f64 t0 = now_seconds();
+    for (int r = 0; r < runs; r++) {
+        sphere_visible = cull_spheres(frustum, &centers, radii, visible);
+    }
+    f64 sphere_ms = (now_seconds() - t0) * 1000.0 / runs;
+
+    /* Scalar reference for the same input */
+    t0 = now_seconds();
+    u32 reference = 0;
+    for (u32 i = 0; i < count; i++) {
+        reference += frustum_test_sphere(frustum, vec3_stream_get(&centers, i), radii[i]);
+    }
+    f64 scalar_ms = (now_seconds() - t0) * 1000.0;
+
+    t0 = now_seconds();
+    for (int r = 0; r < runs; r++) {
+        aabb_visible = cull_aabbs(frustum, &centers, &extents, visible);
+    }
+    f64 aabb_ms = (now_seconds() - t0) * 1000.0 / runs;
+
+    printf("  %8u objects  spheres %7.3f ms (%u visible, scalar %7.3f ms%s)  aabbs %7.3f ms (%u visible)\n",
+           count, sphere_ms, sphere_visible, scalar_ms,
+           reference == sphere_visible ? "" : ", MISMATCH", aabb_ms, aabb_visible);
+
+    vec3_stream_free(&centers);
+    vec3_stream_free(&extents);
+    free(radii);
+    free(visible);
+}
+
+int main(void) {
+    Mat4 projection = mat4_perspective(45.0f * 3.14159f / 180.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    Mat4 view = mat4_look_at(vec3_create(0, 10, 0), vec3_create(1, 10, 1), vec3_create(0, 1, 0));
+    Mat4 view_projection = mat4_multiply(projection, view);
+    Frustum frustum;
+    frustum_extract(&frustum, &view_projection);
+
+    printf("Culling benchmark\n");
+    const u32 sizes[] = {10000, 100000, 1000000};
+    for (u32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench_size(&frustum, sizes[i]);
+    }
+    return 0;
+}
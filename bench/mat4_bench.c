@@ -0,0 +1,135 @@
+/* Mat4 microbenchmark: scalar reference vs SIMD kernels.
+ * Build with -DENGINE_BUILD_BENCHMARKS=ON (add -DENGINE_ENABLE_AVX2=ON for the AVX path). */
+#include "engine/math/mat4.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static f64 now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1e-9;
+}
+
+static f32 random_float(void) {
+    return (f32)rand() / (f32)RAND_MAX * 2.0f - 1.0f;
+}
+
+/* Keeps the optimizer from discarding results */
+static volatile f32 g_sink;
+
+static void consume(const f32* data, u32 count) {
+    f32 sum = 0.0f;
+    for (u32 i = 0; i < count; i += 16) {
+        sum += data[i];
+    }
+    g_sink += sum;
+}
+
+static void report(const char* name, u32 count, f64 scalar_s, f64 simd_s) {
+    printf("  %-26s %8u  scalar %8.3f ms  simd %8.3f ms  speedup %5.2fx\n",
+           name, count, scalar_s * 1000.0, simd_s * 1000.0, scalar_s / simd_s);
+}
+
+static void bench_size(u32 count) {
+    Mat4* models = (Mat4*)malloc(count * sizeof(Mat4));
+    Mat4* out = (Mat4*)malloc(count * sizeof(Mat4));
+    Vec3* points = (Vec3*)malloc(count * sizeof(Vec3));
+    Vec3* points_out = (Vec3*)malloc(count * sizeof(Vec3));
+    if (!models || !out || !points || !points_out) {
+        fprintf(stderr, "Out of memory at %u\n", count);
+        free(models); free(out); free(points); free(points_out);
+        return;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        Mat4 m = mat4_rotate_y(random_float() * 3.14159f);
+        m.m[12] = random_float() * 100.0f;
+        m.m[13] = random_float() * 10.0f;
+        m.m[14] = random_float() * 100.0f;
+        models[i] = m;
+        points[i] = vec3_create(random_float(), random_float(), random_float());
+    }
+    /* Fault in output pages up front so neither side pays for first touch */
+    memset(out, 0, count * sizeof(Mat4));
+    memset(points_out, 0, count * sizeof(Vec3));
+
+    Mat4 view_proj = mat4_multiply_scalar(mat4_perspective(0.8f, 16.0f / 9.0f, 0.1f, 1000.0f),
+                                          mat4_look_at(vec3_create(0, 5, 10), vec3_create(0, 0, 0),
+                                                       vec3_create(0, 1, 0)));
+    f64 t0, scalar_s, simd_s;
+
+    /* view-projection * model, one call per matrix (previous inline code) */
+    t0 = now_seconds();
+    for (u32 i = 0; i < count; i++) {
+        out[i] = mat4_multiply_scalar(view_proj, models[i]);
+    }
+    scalar_s = now_seconds() - t0;
+    consume(out[0].m, 16);
+
+    t0 = now_seconds();
+    mat4_multiply_batch(out, &view_proj, models, count);
+    simd_s = now_seconds() - t0;
+    consume(out[0].m, 16);
+    report("multiply (batch)", count, scalar_s, simd_s);
+
+    t0 = now_seconds();
+    for (u32 i = 0; i < count; i++) {
+        mat4_mul(&out[i], &view_proj, &models[i]);
+    }
+    simd_s = now_seconds() - t0;
+    consume(out[0].m, 16);
+    report("multiply (single)", count, scalar_s, simd_s);
+
+    /* Point transform */
+    t0 = now_seconds();
+    for (u32 i = 0; i < count; i++) {
+        points_out[i] = mat4_transform_point(view_proj, points[i]);
+    }
+    scalar_s = now_seconds() - t0;
+    consume(&points_out[0].x, 3);
+
+    t0 = now_seconds();
+    mat4_transform_points(points_out, &view_proj, points, count);
+    simd_s = now_seconds() - t0;
+    consume(&points_out[0].x, 3);
+    report("transform points (batch)", count, scalar_s, simd_s);
+
+    /* Inverse */
+    t0 = now_seconds();
+    for (u32 i = 0; i < count; i++) {
+        mat4_invert_scalar(&out[i], &models[i]);
+    }
+    scalar_s = now_seconds() - t0;
+    consume(out[0].m, 16);
+
+    t0 = now_seconds();
+    for (u32 i = 0; i < count; i++) {
+        mat4_invert(&out[i], &models[i]);
+    }
+    simd_s = now_seconds() - t0;
+    consume(out[0].m, 16);
+    report("inverse", count, scalar_s, simd_s);
+
+    free(models);
+    free(out);
+    free(points);
+    free(points_out);
+}
+
+int main(void) {
+#if defined(ENGINE_SIMD_AVX)
+    printf("Mat4 benchmark (AVX)\n");
+#elif defined(ENGINE_SIMD_SSE)
+    printf("Mat4 benchmark (SSE)\n");
+#else
+    printf("Mat4 benchmark (scalar fallback)\n");
+#endif
+
+    const u32 sizes[] = {10000, 100000, 1000000};
+    for (u32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench_size(sizes[i]);
+    }
+    return 0;
+}
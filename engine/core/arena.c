@@ -0,0 +1,127 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Scratch blocks grow past this for larger requests */
+#define SCRATCH_BLOCK_SIZE (1024 * 1024)
+
+struct ArenaBlock {
+    ArenaBlock* next;
+    size_t capacity;
+    size_t used;
+};
+
+static ENGINE_THREAD_LOCAL Arena t_scratch;
+static ENGINE_THREAD_LOCAL bool t_scratch_ready = false;
+
+static u8* block_data(ArenaBlock* block) {
+    return (u8*)(block + 1);
+}
+
+/* Bump within block, or NULL if the request doesn't fit */
+static void* block_alloc(ArenaBlock* block, size_t size, size_t align) {
+    uintptr_t base = (uintptr_t)block_data(block);
+    uintptr_t start = (base + block->used + (align - 1)) & ~(uintptr_t)(align - 1);
+    size_t offset = (size_t)(start - base);
+    if (offset > block->capacity || size > block->capacity - offset) {
+        return NULL;
+    }
+    block->used = offset + size;
+    return (void*)start;
+}
+
+void arena_init(Arena* arena, size_t block_size) {
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->block_size = block_size > 0 ? block_size : 64 * 1024;
+}
+
+void arena_free(Arena* arena) {
+    ArenaBlock* block = arena->first;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+void* arena_alloc(Arena* arena, size_t size, size_t align) {
+    if (align == 0) align = 1;
+
+    if (arena->current) {
+        void* ptr = block_alloc(arena->current, size, align);
+        if (ptr) return ptr;
+    }
+
+    /* Move on to the next retained block, or link in a new one there */
+    ArenaBlock* next = arena->current ? arena->current->next : arena->first;
+    if (!next || next->capacity < size + align) {
+        size_t capacity = arena->block_size;
+        if (capacity < size + align) capacity = size + align;
+
+        ArenaBlock* block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + capacity);
+        if (!block) {
+            fprintf(stderr, "Arena: failed to allocate %zu byte block\n", capacity);
+            return NULL;
+        }
+        block->capacity = capacity;
+        block->next = next;
+        if (arena->current) {
+            arena->current->next = block;
+        } else {
+            arena->first = block;
+        }
+        next = block;
+    }
+
+    next->used = 0;
+    arena->current = next;
+    return block_alloc(next, size, align);
+}
+
+ArenaMark arena_mark(const Arena* arena) {
+    ArenaMark mark = {arena->current, arena->current ? arena->current->used : 0};
+    return mark;
+}
+
+void arena_rewind(Arena* arena, ArenaMark mark) {
+    arena->current = mark.block;
+    if (mark.block) {
+        mark.block->used = mark.used;
+    }
+}
+
+void arena_reset(Arena* arena) {
+    arena->current = NULL;
+}
+
+size_t arena_reserved(const Arena* arena) {
+    size_t total = 0;
+    for (ArenaBlock* block = arena->first; block; block = block->next) {
+        total += block->capacity;
+    }
+    return total;
+}
+
+Scratch scratch_begin(void) {
+    if (!t_scratch_ready) {
+        arena_init(&t_scratch, SCRATCH_BLOCK_SIZE);
+        t_scratch_ready = true;
+    }
+    Scratch scratch = {&t_scratch, arena_mark(&t_scratch)};
+    return scratch;
+}
+
+void scratch_end(Scratch scratch) {
+    arena_rewind(scratch.arena, scratch.mark);
+}
+
+void scratch_thread_shutdown(void) {
+    if (t_scratch_ready) {
+        arena_free(&t_scratch);
+        t_scratch_ready = false;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "types.h"
+#include <stddef.h>
+
+/* Linear (bump) allocator over a chain of blocks. Allocations are freed all
+ * at once by rewinding to a mark or resetting; blocks are kept for reuse,
+ * so an arena that has reached its working size never touches the heap. */
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock* first;
+    ArenaBlock* current;   /* NULL before the first allocation */
+    size_t block_size;     /* Minimum size of new blocks */
+} Arena;
+
+/* Position to rewind to */
+typedef struct {
+    ArenaBlock* block;
+    size_t used;
+} ArenaMark;
+
+void arena_init(Arena* arena, size_t block_size);
+void arena_free(Arena* arena);
+
+/* Returns NULL only when the heap is exhausted */
+void* arena_alloc(Arena* arena, size_t size, size_t align);
+
+#define arena_push_array(arena, type, count) \
+    ((type*)arena_alloc((arena), sizeof(type) * (size_t)(count), _Alignof(type)))
+
+ArenaMark arena_mark(const Arena* arena);
+void arena_rewind(Arena* arena, ArenaMark mark);
+void arena_reset(Arena* arena);
+
+/* Bytes held by the arena's blocks */
+size_t arena_reserved(const Arena* arena);
+
+/* Thread-local scratch arena for temporaries. Begin/end pairs nest like a
+ * stack; everything allocated since the matching begin is released. */
+typedef struct {
+    Arena* arena;
+    ArenaMark mark;
+} Scratch;
+
+Scratch scratch_begin(void);
+void scratch_end(Scratch scratch);
+
+/* Free the calling thread's scratch blocks, e.g. before the thread exits */
+void scratch_thread_shutdown(void);
+
+#endif /* ARENA_H */
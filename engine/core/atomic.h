@@ -0,0 +1,104 @@
+#ifndef ENGINE_ATOMIC_H
+#define ENGINE_ATOMIC_H
+
+#include "types.h"
+
+/* Sequentially consistent atomics on plain integers and pointers.
+ * GCC/Clang builtins, or Interlocked intrinsics on MSVC. */
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+static inline i32 atomic_i32_load(volatile i32* p) {
+    i32 value = *p;
+    _ReadWriteBarrier();
+    return value;
+}
+
+static inline void atomic_i32_store(volatile i32* p, i32 value) {
+    _InterlockedExchange((volatile long*)p, (long)value);
+}
+
+/* Returns the new value */
+static inline i32 atomic_i32_add(volatile i32* p, i32 delta) {
+    return (i32)_InterlockedExchangeAdd((volatile long*)p, (long)delta) + delta;
+}
+
+static inline i64 atomic_i64_load(volatile i64* p) {
+    i64 value = *p;
+    _ReadWriteBarrier();
+    return value;
+}
+
+static inline void atomic_i64_store(volatile i64* p, i64 value) {
+    _InterlockedExchange64((volatile __int64*)p, (__int64)value);
+}
+
+static inline bool atomic_i64_cas(volatile i64* p, i64 expected, i64 desired) {
+    return _InterlockedCompareExchange64((volatile __int64*)p, desired, expected) == expected;
+}
+
+static inline void* atomic_ptr_load(void* volatile* p) {
+    void* value = *p;
+    _ReadWriteBarrier();
+    return value;
+}
+
+static inline void atomic_ptr_store(void* volatile* p, void* value) {
+    _InterlockedExchangePointer(p, value);
+}
+
+/* Returns the previous value */
+static inline void* atomic_ptr_exchange(void* volatile* p, void* value) {
+    return _InterlockedExchangePointer(p, value);
+}
+
+static inline bool atomic_ptr_cas(void* volatile* p, void* expected, void* desired) {
+    return _InterlockedCompareExchangePointer(p, desired, expected) == expected;
+}
+#else
+static inline i32 atomic_i32_load(volatile i32* p) {
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+
+static inline void atomic_i32_store(volatile i32* p, i32 value) {
+    __atomic_store_n(p, value, __ATOMIC_SEQ_CST);
+}
+
+/* Returns the new value */
+static inline i32 atomic_i32_add(volatile i32* p, i32 delta) {
+    return __atomic_add_fetch(p, delta, __ATOMIC_SEQ_CST);
+}
+
+static inline i64 atomic_i64_load(volatile i64* p) {
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+
+static inline void atomic_i64_store(volatile i64* p, i64 value) {
+    __atomic_store_n(p, value, __ATOMIC_SEQ_CST);
+}
+
+static inline bool atomic_i64_cas(volatile i64* p, i64 expected, i64 desired) {
+    return __atomic_compare_exchange_n(p, &expected, desired, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline void* atomic_ptr_load(void* volatile* p) {
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+
+static inline void atomic_ptr_store(void* volatile* p, void* value) {
+    __atomic_store_n(p, value, __ATOMIC_SEQ_CST);
+}
+
+/* Returns the previous value */
+static inline void* atomic_ptr_exchange(void* volatile* p, void* value) {
+    return __atomic_exchange_n(p, value, __ATOMIC_SEQ_CST);
+}
+
+static inline bool atomic_ptr_cas(void* volatile* p, void* expected, void* desired) {
+    return __atomic_compare_exchange_n(p, &expected, desired, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+#endif
+
+#endif /* ENGINE_ATOMIC_H */
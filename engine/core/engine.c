@@ -1,5 +1,19 @@
 #include "engine.h"
+#include "timestep.h"
+#include "profiler.h"
+#include "timer.h"
 #include "../input/input.h"
+#include "../input/input_record.h"
+#include "../input/input_events.h"
+#include "../renderer/renderer.h"
+#include "../renderer/mesh.h"
+#include "../renderer/shader.h"
+#include "../renderer/shader_cache.h"
+#include "../renderer/texture.h"
+#include "../renderer/camera.h"
+#include "../renderer/gpu_profiler.h"
+#include "../renderer/frame_uniforms.h"
+#include "../renderer/render_thread.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <stdlib.h>
@@ -7,10 +21,35 @@
 
 /* Internal engine state */
 struct Engine {
-    GLFWwindow* window;
+    GLFWwindow* window;     /* NULL when headless */
+    bool headless;
+    JobSystem* jobs;
+    Arena frame_arena;
+    RenderThread* render_thread;  /* NULL until the first frame, or when disabled */
+    bool use_render_thread;
+    u32 render_queue_depth;
+    DrawList inline_list;         /* Used when there is no render thread */
+    DrawList* draw_list;          /* List being recorded this frame */
+    FrameStats* stats;
+    InputRecorder* recorder;
+    InputReplay* replay;
+    u64 last_frame_end_ns;        /* Real time, also in headless runs */
     InputState input;
+    InputEventQueue input_events;  /* Filled by the callbacks, applied in engine_poll_events */
+    InputEventTimes input_times;   /* Arrival times of the input this frame shows */
+    bool late_latch;
+    EngineLateLatchFn late_latch_fn;
+    void* late_latch_user;
+    f32 lod_bias;
     f64 last_frame_time;
     f64 delta_time;
+    f64 manual_time;        /* Headless clock */
+    f64 manual_frame_time;
+    u64 frame_count;
+    u64 max_frames;
+    bool close_requested;
+    FixedTimestep timestep;
+    f32 profile_budget_ms;
     i32 window_width;
     i32 window_height;
     bool mouse_captured;
@@ -20,10 +59,16 @@ struct Engine {
 /* Global engine pointer for callbacks */
 static Engine* g_engine = NULL;
 
-/* GLFW Callbacks */
+static void engine_push_event(Engine* engine, InputEventType type, i32 code, i32 action, f64 x, f64 y) {
+    InputEvent event = { timer_now_ns(), type, code, action, x, y };
+    input_event_push(&engine->input_events, &event);
+}
+
+/* GLFW Callbacks. These run on the main thread inside glfwPollEvents, which
+ * may not hold the GL context; the viewport is applied by the draw list.
+ * Input is queued with its arrival time and applied after polling. */
 static void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     (void)window;
-    glViewport(0, 0, width, height);
     if (g_engine) {
         g_engine->window_width = width;
         g_engine->window_height = height;
@@ -35,7 +80,7 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
     (void)scancode;
     (void)mods;
     if (g_engine) {
-        input_process_key(&g_engine->input, key, action);
+        engine_push_event(g_engine, INPUT_EVENT_KEY, key, action, 0.0, 0.0);
     }
 }
 
@@ -43,7 +88,7 @@ static void mouse_button_callback(GLFWwindow* window, int button, int action, in
     (void)window;
     (void)mods;
     if (g_engine) {
-        input_process_mouse_button(&g_engine->input, button, action);
+        engine_push_event(g_engine, INPUT_EVENT_MOUSE_BUTTON, button, action, 0.0, 0.0);
     }
 }
 
@@ -51,30 +96,26 @@ static void cursor_position_callback(GLFWwindow* window, double xpos, double ypo
     (void)window;
     if (g_engine) {
         if (g_engine->first_mouse && g_engine->mouse_captured) {
-            g_engine->input.mouse_x = xpos;
-            g_engine->input.mouse_y = ypos;
+            engine_push_event(g_engine, INPUT_EVENT_MOUSE_WARP, 0, 0, xpos, ypos);
             g_engine->first_mouse = false;
         }
-        input_process_mouse_move(&g_engine->input, xpos, ypos);
+        engine_push_event(g_engine, INPUT_EVENT_MOUSE_MOVE, 0, 0, xpos, ypos);
     }
 }
 
 static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     (void)window;
     if (g_engine) {
-        input_process_scroll(&g_engine->input, xoffset, yoffset);
+        engine_push_event(g_engine, INPUT_EVENT_SCROLL, 0, 0, xoffset, yoffset);
     }
 }
 
-Engine* engine_create(const EngineConfig* config) {
-    Engine* engine = (Engine*)malloc(sizeof(Engine));
-    if (!engine) return NULL;
-    
+/* Window, GL context and input callbacks for the GLFW backend */
+static bool engine_init_window(Engine* engine, const EngineConfig* config) {
     /* Initialize GLFW */
     if (!glfwInit()) {
         fprintf(stderr, "Failed to initialize GLFW\n");
-        free(engine);
-        return NULL;
+        return false;
     }
     
     /* Configure GLFW */
@@ -93,8 +134,7 @@ Engine* engine_create(const EngineConfig* config) {
     if (!engine->window) {
         fprintf(stderr, "Failed to create GLFW window\n");
         glfwTerminate();
-        free(engine);
-        return NULL;
+        return false;
     }
     
     glfwMakeContextCurrent(engine->window);
@@ -103,13 +143,12 @@ Engine* engine_create(const EngineConfig* config) {
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         fprintf(stderr, "Failed to initialize GLAD\n");
         glfwDestroyWindow(engine->window);
+        engine->window = NULL;
         glfwTerminate();
-        free(engine);
-        return NULL;
+        return false;
     }
     
     /* Set up callbacks */
-    g_engine = engine;
     glfwSetFramebufferSizeCallback(engine->window, framebuffer_size_callback);
     glfwSetKeyCallback(engine->window, key_callback);
     glfwSetMouseButtonCallback(engine->window, mouse_button_callback);
@@ -124,18 +163,167 @@ Engine* engine_create(const EngineConfig* config) {
     /* VSync */
     glfwSwapInterval(config->vsync ? 1 : 0);
     
+    printf("OpenGL Version: %s\n", glGetString(GL_VERSION));
+    printf("OpenGL Renderer: %s\n", glGetString(GL_RENDERER));
+    
+    gpu_profiler_init();
+    frame_uniforms_init();
+    shader_cache_init(config->shader_cache_dir);
+    
+    return true;
+}
+
+/* RenderContext hooks for the GLFW window */
+static void context_bind(void* user) {
+    glfwMakeContextCurrent(((Engine*)user)->window);
+}
+
+static void context_unbind(void* user) {
+    (void)user;
+    glfwMakeContextCurrent(NULL);
+}
+
+static void context_present(void* user) {
+    PROFILE_BEGIN("swap_buffers");
+    glfwSwapBuffers(((Engine*)user)->window);
+    PROFILE_END();
+}
+
+static void engine_start_render_thread(Engine* engine) {
+    /* Headless runs still hand lists over, so they exercise the same pipeline */
+    RenderContext context = {0};
+    if (engine->window) {
+        context.bind = context_bind;
+        context.unbind = context_unbind;
+        context.present = context_present;
+        context.user = engine;
+    }
+    
+    engine->render_thread = render_thread_create(&context, engine->render_queue_depth);
+    if (!engine->render_thread) {
+        fprintf(stderr, "Rendering on the main thread instead\n");
+        engine->use_render_thread = false;
+    }
+}
+
+Engine* engine_create(const EngineConfig* config) {
+    Engine* engine = (Engine*)malloc(sizeof(Engine));
+    if (!engine) return NULL;
+    
+#ifdef ENGINE_PROFILE
+    profiler_init(config->profile_window_frames);
+#endif
+    
+    engine->window = NULL;
+    engine->headless = config->headless;
+    renderer_set_headless(config->headless);
+    
+    /* Job system first so loading can use it */
+    engine->jobs = job_system_create(config->worker_threads);
+    if (!engine->jobs) {
+        fprintf(stderr, "Failed to create job system\n");
+#ifdef ENGINE_PROFILE
+        profiler_shutdown();
+#endif
+        free(engine);
+        return NULL;
+    }
+    printf("Job system: %u threads\n", job_system_thread_count(engine->jobs));
+    
+    engine->stats = frame_stats_create(config->stats_window_frames);
+    if (!engine->stats) {
+        job_system_destroy(engine->jobs);
+#ifdef ENGINE_PROFILE
+        profiler_shutdown();
+#endif
+        free(engine);
+        return NULL;
+    }
+    if (config->stats_csv_path) {
+        frame_stats_begin_csv(engine->stats, config->stats_csv_path);
+    }
+    engine->last_frame_end_ns = 0;
+    
+    arena_init(&engine->frame_arena, config->frame_arena_size);
+    engine->render_thread = NULL;
+    engine->use_render_thread = config->render_thread;
+    engine->render_queue_depth = config->render_queue_depth;
+    engine->draw_list = NULL;
+    
+    if (!draw_list_init(&engine->inline_list, 256)) {
+        fprintf(stderr, "Failed to allocate draw list\n");
+        draw_list_free(&engine->inline_list);
+        frame_stats_destroy(engine->stats);
+        job_system_destroy(engine->jobs);
+        arena_free(&engine->frame_arena);
+#ifdef ENGINE_PROFILE
+        profiler_shutdown();
+#endif
+        free(engine);
+        return NULL;
+    }
+    
+    if (engine->headless) {
+        printf("Running headless: no window or GL context\n");
+    } else if (!engine_init_window(engine, config)) {
+        draw_list_free(&engine->inline_list);
+        frame_stats_destroy(engine->stats);
+        job_system_destroy(engine->jobs);
+        arena_free(&engine->frame_arena);
+#ifdef ENGINE_PROFILE
+        profiler_shutdown();
+#endif
+        free(engine);
+        return NULL;
+    }
+    
+    g_engine = engine;
+    
     /* Initialize engine state */
     engine->window_width = config->window_width;
     engine->window_height = config->window_height;
-    engine->last_frame_time = glfwGetTime();
+    if (engine->window) {
+        /* Differs from the window size on high-DPI displays */
+        glfwGetFramebufferSize(engine->window, &engine->window_width, &engine->window_height);
+    }
+    engine->manual_time = 0.0;
+    engine->manual_frame_time = config->headless_frame_time > 0.0f
+                              ? config->headless_frame_time : 1.0f / 60.0f;
+    engine->last_frame_time = engine_get_time(engine);
     engine->delta_time = 0.0;
+    fixed_timestep_init(&engine->timestep, config->fixed_tick_rate, config->max_catchup_steps);
+    
+    /* A replay is only exact with the timestep it was recorded with */
+    engine->recorder = NULL;
+    engine->replay = NULL;
+    if (config->replay_path) {
+        engine->replay = input_replay_open(config->replay_path);
+        if (engine->replay) {
+            fixed_timestep_init(&engine->timestep, input_replay_tick_rate(engine->replay),
+                                input_replay_max_catchup_steps(engine->replay));
+            printf("Replaying input: %s\n", config->replay_path);
+        }
+    } else if (config->record_path) {
+        engine->recorder = input_recorder_create(config->record_path, config->fixed_tick_rate,
+                                                 config->max_catchup_steps);
+        if (engine->recorder) {
+            printf("Recording input: %s\n", config->record_path);
+        }
+    }
+    engine->frame_count = 0;
+    engine->max_frames = config->max_frames;
+    engine->close_requested = false;
+    engine->profile_budget_ms = config->profile_budget_ms;
     engine->mouse_captured = false;
     engine->first_mouse = true;
+    engine->late_latch = config->late_latch;
+    engine->late_latch_fn = NULL;
+    engine->late_latch_user = NULL;
+    engine->lod_bias = config->lod_bias;
     
     input_init(&engine->input);
-    
-    printf("OpenGL Version: %s\n", glGetString(GL_VERSION));
-    printf("OpenGL Renderer: %s\n", glGetString(GL_RENDERER));
+    input_event_queue_init(&engine->input_events);
+    input_event_times_reset(&engine->input_times);
     
     return engine;
 }
@@ -145,33 +333,196 @@ void engine_destroy(Engine* engine) {
     
     g_engine = NULL;
     
-    if (engine->window) {
-        glfwDestroyWindow(engine->window);
+    /* Brings the GL context back to this thread for the cleanup below */
+    engine_finish_rendering(engine);
+    draw_list_free(&engine->inline_list);
+    frame_stats_destroy(engine->stats);
+    input_recorder_destroy(engine->recorder);
+    input_replay_close(engine->replay);
+    
+    /* Anything the game forgot is reported and freed while GL is still up */
+    mesh_shutdown();
+    shader_shutdown();
+    texture_shutdown();
+    camera_shutdown();
+    
+    if (!engine->headless) {
+        gpu_profiler_shutdown();
+        frame_uniforms_shutdown();
+        shader_cache_shutdown();
+        if (engine->window) {
+            glfwDestroyWindow(engine->window);
+        }
+        glfwTerminate();
     }
-    glfwTerminate();
+    renderer_set_headless(false);
+    job_system_destroy(engine->jobs);
+    arena_free(&engine->frame_arena);
+    scratch_thread_shutdown();
+#ifdef ENGINE_PROFILE
+    profiler_shutdown();
+#endif
     free(engine);
 }
 
 bool engine_should_close(Engine* engine) {
-    return glfwWindowShouldClose(engine->window);
+    if (engine->close_requested) return true;
+    if (engine->max_frames > 0 && engine->frame_count >= engine->max_frames) return true;
+    return engine->window && glfwWindowShouldClose(engine->window);
+}
+
+void engine_request_close(Engine* engine) {
+    engine->close_requested = true;
+}
+
+bool engine_is_headless(Engine* engine) {
+    return engine->headless;
 }
 
 void engine_poll_events(Engine* engine) {
     input_update(&engine->input);
-    glfwPollEvents();
+    input_event_times_reset(&engine->input_times);
+    if (!engine->headless) {
+        glfwPollEvents();
+    }
+    input_events_apply(&engine->input_events, &engine->input, &engine->input_times);
+    
+#ifdef ENGINE_PROFILE
+    if (input_key_pressed(&engine->input, KEY_F9)) {
+        profiler_request_dump();
+    }
+#endif
+    
+    if (input_key_pressed(&engine->input, KEY_F10)) {
+        if (frame_stats_csv_active(engine->stats)) {
+            frame_stats_end_csv(engine->stats);
+            printf("Stopped writing frame stats\n");
+        } else {
+            char path[64];
+            snprintf(path, sizeof(path), "frame_stats_%llu.csv", (unsigned long long)engine->frame_count);
+            if (frame_stats_begin_csv(engine->stats, path)) {
+                printf("Writing frame stats: %s\n", path);
+            }
+        }
+    }
 }
 
 void engine_begin_frame(Engine* engine) {
-    f64 current_time = glfwGetTime();
+#ifdef ENGINE_PROFILE
+    profiler_frame_begin();
+#endif
+    arena_reset(&engine->frame_arena);
+    if (engine->last_frame_end_ns == 0) {
+        engine->last_frame_end_ns = timer_now_ns();
+    }
+    
+    /* The headless clock is manual: every frame lasts exactly manual_frame_time */
+    if (engine->headless) {
+        engine->manual_time += engine->manual_frame_time;
+    }
+    
+    f64 current_time = engine_get_time(engine);
     engine->delta_time = current_time - engine->last_frame_time;
     engine->last_frame_time = current_time;
     
-    glClearColor(0.2f, 0.3f, 0.4f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    /* Input is final here: polled, injected, or replayed over both */
+    if (engine->replay) {
+        /* Live input is discarded, so it has no latency to report */
+        input_event_times_reset(&engine->input_times);
+        if (!input_replay_next_frame(engine->replay, &engine->input, &engine->delta_time)) {
+            printf("Replay finished after %llu frames\n",
+                   (unsigned long long)input_replay_frame_count(engine->replay));
+            engine->close_requested = true;
+        }
+    } else if (engine->recorder) {
+        input_recorder_write_frame(engine->recorder, &engine->input, engine->delta_time);
+    }
+    fixed_timestep_advance(&engine->timestep, engine->delta_time);
+    
+    if (engine->use_render_thread && !engine->render_thread) {
+        engine_start_render_thread(engine);
+    }
+    
+    if (engine->render_thread) {
+        /* Blocks when the render thread is a full queue behind */
+        PROFILE_BEGIN("wait_render_thread");
+        engine->draw_list = render_thread_acquire(engine->render_thread);
+        PROFILE_END();
+    } else {
+        engine->draw_list = &engine->inline_list;
+        draw_list_reset(engine->draw_list);
+    }
+    
+    DrawList* list = engine->draw_list;
+    list->viewport_width = engine->window_width;
+    list->viewport_height = engine->window_height;
+    list->clear_color = color_create(0.2f, 0.3f, 0.4f, 1.0f);
+    list->lod_bias = engine->lod_bias;
+}
+
+/* Let the game re-aim the recorded view with the cursor motion that
+ * arrived while the frame was being simulated and recorded. The motion
+ * stays queued, so the simulation still sees it next frame. */
+static void engine_late_latch(Engine* engine) {
+    if (!engine->late_latch || !engine->late_latch_fn || engine->replay) return;
+    
+    PROFILE_BEGIN("late_latch");
+    if (!engine->headless) {
+        glfwPollEvents();
+    }
+    f64 dx, dy;
+    input_events_latch_mouse_delta(&engine->input_events, &engine->input, &dx, &dy,
+                                   &engine->input_times);
+    engine->late_latch_fn(engine->late_latch_user, dx, dy, engine->draw_list);
+    PROFILE_END();
 }
 
 void engine_end_frame(Engine* engine) {
-    glfwSwapBuffers(engine->window);
+    engine->frame_count++;
+    engine_late_latch(engine);
+    engine->draw_list->input_time_ns = input_event_times_mean(&engine->input_times);
+    draw_list_sort(engine->draw_list);
+    
+    if (engine->render_thread) {
+        render_thread_submit(engine->render_thread, engine->draw_list);
+        
+        /* Attributed to the frame in which the render thread finished it */
+        f64 render_ms;
+        if (render_thread_take_frame_time(engine->render_thread, &render_ms)) {
+            frame_stats_record(engine->stats, FRAME_STAT_RENDER, render_ms);
+        }
+        f64 input_ms;
+        if (render_thread_take_input_latency(engine->render_thread, &input_ms)) {
+            frame_stats_record(engine->stats, FRAME_STAT_INPUT, input_ms);
+        }
+    } else if (!engine->headless) {
+        u64 render_start = timer_now_ns();
+        draw_list_execute(engine->draw_list);
+        context_present(engine);
+        u64 render_end = timer_now_ns();
+        frame_stats_record(engine->stats, FRAME_STAT_RENDER, (f64)(render_end - render_start) * 1e-6);
+        if (engine->draw_list->input_time_ns) {
+            frame_stats_record(engine->stats, FRAME_STAT_INPUT,
+                               (f64)(render_end - engine->draw_list->input_time_ns) * 1e-6);
+        }
+    }
+    engine->draw_list = NULL;
+    
+    /* Resolved a few frames after it was drawn; counted in the frame that
+     * resolved it, like render time */
+    f32 gpu_ms;
+    if (gpu_profiler_take_frame_ms(&gpu_ms)) {
+        frame_stats_record(engine->stats, FRAME_STAT_GPU, gpu_ms);
+    }
+    
+    u64 now = timer_now_ns();
+    frame_stats_record(engine->stats, FRAME_STAT_FRAME, (f64)(now - engine->last_frame_end_ns) * 1e-6);
+    engine->last_frame_end_ns = now;
+    frame_stats_end_frame(engine->stats);
+    
+#ifdef ENGINE_PROFILE
+    profiler_frame_end(engine->profile_budget_ms);
+#endif
 }
 
 f32 engine_get_delta_time(Engine* engine) {
@@ -179,8 +530,46 @@ f32 engine_get_delta_time(Engine* engine) {
 }
 
 f64 engine_get_time(Engine* engine) {
-    (void)engine;
-    return glfwGetTime();
+    return engine->headless ? engine->manual_time : glfwGetTime();
+}
+
+u64 engine_get_frame_count(Engine* engine) {
+    return engine->frame_count;
+}
+
+bool engine_is_replaying(Engine* engine) {
+    return engine->replay != NULL;
+}
+
+bool engine_is_recording(Engine* engine) {
+    return engine->recorder != NULL;
+}
+
+void engine_set_headless_frame_time(Engine* engine, f32 seconds) {
+    engine->manual_frame_time = seconds;
+}
+
+u32 engine_get_fixed_steps(Engine* engine) {
+    return engine->timestep.pending_steps;
+}
+
+f32 engine_get_fixed_delta(Engine* engine) {
+    return (f32)engine->timestep.step;
+}
+
+f32 engine_get_interpolation_alpha(Engine* engine) {
+    return fixed_timestep_alpha(&engine->timestep);
+}
+
+DrawList* engine_get_draw_list(Engine* engine) {
+    return engine->draw_list;
+}
+
+void engine_finish_rendering(Engine* engine) {
+    if (engine->render_thread) {
+        render_thread_destroy(engine->render_thread);
+        engine->render_thread = NULL;
+    }
 }
 
 void engine_get_window_size(Engine* engine, i32* width, i32* height) {
@@ -191,11 +580,53 @@ void engine_get_window_size(Engine* engine, i32* width, i32* height) {
 void engine_set_mouse_captured(Engine* engine, bool captured) {
     engine->mouse_captured = captured;
     engine->first_mouse = true;
-    glfwSetInputMode(engine->window, GLFW_CURSOR, 
-                     captured ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
+    if (engine->window) {
+        glfwSetInputMode(engine->window, GLFW_CURSOR, 
+                         captured ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
+    }
 }
 
 /* Access to input state - needed by game code */
 struct InputState* engine_get_input(Engine* engine) {
     return &engine->input;
 }
+
+void engine_set_late_latch(Engine* engine, EngineLateLatchFn fn, void* user) {
+    engine->late_latch_fn = fn;
+    engine->late_latch_user = user;
+}
+
+JobSystem* engine_get_jobs(Engine* engine) {
+    return engine->jobs;
+}
+
+FrameStats* engine_get_stats(Engine* engine) {
+    return engine->stats;
+}
+
+Arena* engine_get_frame_arena(Engine* engine) {
+    return &engine->frame_arena;
+}
+
+/* Programmatic input goes through the queue like live input, so it is
+ * timestamped too, and is applied straight away for this frame */
+static void engine_inject_event(Engine* engine, InputEventType type, i32 code, i32 action, f64 x, f64 y) {
+    engine_push_event(engine, type, code, action, x, y);
+    input_events_apply(&engine->input_events, &engine->input, &engine->input_times);
+}
+
+void engine_inject_key(Engine* engine, i32 key, i32 action) {
+    engine_inject_event(engine, INPUT_EVENT_KEY, key, action, 0.0, 0.0);
+}
+
+void engine_inject_mouse_button(Engine* engine, i32 button, i32 action) {
+    engine_inject_event(engine, INPUT_EVENT_MOUSE_BUTTON, button, action, 0.0, 0.0);
+}
+
+void engine_inject_mouse_move(Engine* engine, f64 x, f64 y) {
+    engine_inject_event(engine, INPUT_EVENT_MOUSE_MOVE, 0, 0, x, y);
+}
+
+void engine_inject_scroll(Engine* engine, f64 x, f64 y) {
+    engine_inject_event(engine, INPUT_EVENT_SCROLL, 0, 0, x, y);
+}
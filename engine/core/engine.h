@@ -2,8 +2,12 @@
 #define ENGINE_H
 
 #include "types.h"
+#include "jobs.h"
+#include "arena.h"
+#include "frame_stats.h"
 #include "../math/vec3.h"
 #include "../math/mat4.h"
+#include "../renderer/draw_list.h"
 #include <stdbool.h>
 
 /* Forward declarations */
@@ -17,6 +21,24 @@ struct EngineConfig {
     i32 window_height;
     bool fullscreen;
     bool vsync;
+    f32 fixed_tick_rate;     /* Simulation ticks per second */
+    u32 max_catchup_steps;   /* Most ticks run in one frame after a hitch */
+    bool headless;           /* No window or GL context; manual clock */
+    f32 headless_frame_time; /* Seconds the headless clock advances per frame */
+    u64 max_frames;          /* Close after this many frames (0 = unlimited) */
+    u32 worker_threads;      /* Job workers besides the main thread (0 = one per core) */
+    u32 frame_arena_size;    /* Initial bytes for per-frame allocations */
+    u32 profile_window_frames; /* Frames written per profiler dump */
+    f32 profile_budget_ms;   /* Dump a trace when a frame exceeds this (0 = off) */
+    bool render_thread;      /* Submit draw lists from a dedicated thread that owns the GL context */
+    u32 render_queue_depth;  /* Frames the game thread may run ahead of the render thread */
+    u32 stats_window_frames; /* Frames in the sliding window of frame statistics */
+    const char* stats_csv_path; /* Write per-frame timings here from the start (NULL = off) */
+    const char* record_path; /* Record every frame's input and delta time here (NULL = off) */
+    const char* replay_path; /* Play back a recording instead of live input (NULL = off) */
+    bool late_latch;         /* Re-aim the view with input polled just before submission */
+    f32 lod_bias;            /* Scales the screen error mesh LODs may show (higher = coarser) */
+    const char* shader_cache_dir; /* Linked program binaries are kept here (NULL = off) */
 };
 
 /* Engine initialization and shutdown */
@@ -25,11 +47,42 @@ void engine_destroy(Engine* engine);
 
 /* Engine main loop */
 bool engine_should_close(Engine* engine);
+void engine_request_close(Engine* engine);
 void engine_poll_events(Engine* engine);
 void engine_begin_frame(Engine* engine);
 void engine_end_frame(Engine* engine);
 f32 engine_get_delta_time(Engine* engine);
 f64 engine_get_time(Engine* engine);
+u64 engine_get_frame_count(Engine* engine);
+
+/* Headless backend */
+bool engine_is_headless(Engine* engine);
+
+/* Input recording and replay. A replay feeds the recorded input and delta
+ * times in place of live input and the clock, so it reproduces the
+ * recorded simulation exactly and runs as fast as frames can be made;
+ * the engine requests close when the recording ends. */
+bool engine_is_replaying(Engine* engine);
+bool engine_is_recording(Engine* engine);
+void engine_set_headless_frame_time(Engine* engine, f32 seconds);
+
+/* Fixed-step simulation: run engine_get_fixed_steps ticks of
+ * engine_get_fixed_delta each frame, then render with the interpolation
+ * alpha between the previous and current simulation states */
+u32 engine_get_fixed_steps(Engine* engine);
+f32 engine_get_fixed_delta(Engine* engine);
+f32 engine_get_interpolation_alpha(Engine* engine);
+
+/* Draw list for the current frame, valid between engine_begin_frame and
+ * engine_end_frame. engine_end_frame executes it, or hands it to the render
+ * thread when one is configured.
+ *
+ * The render thread starts at the first engine_begin_frame and owns the GL
+ * context from then on: the game thread must not make GL calls (creating
+ * or destroying meshes and shaders included) until engine_finish_rendering
+ * has returned. The next engine_begin_frame starts the thread again. */
+DrawList* engine_get_draw_list(Engine* engine);
+void engine_finish_rendering(Engine* engine);
 
 /* Window management */
 void engine_get_window_size(Engine* engine, i32* width, i32* height);
@@ -42,11 +95,55 @@ static inline EngineConfig engine_default_config(void) {
         .window_width = 1280,
         .window_height = 720,
         .fullscreen = false,
-        .vsync = true
+        .vsync = true,
+        .fixed_tick_rate = 60.0f,
+        .max_catchup_steps = 5,
+        .headless = false,
+        .headless_frame_time = 1.0f / 60.0f,
+        .max_frames = 0,
+        .worker_threads = 0,
+        .frame_arena_size = 1024 * 1024,
+        .profile_window_frames = 120,
+        .profile_budget_ms = 0.0f,
+        .render_thread = true,
+        .render_queue_depth = 1,
+        .stats_window_frames = 300,
+        .stats_csv_path = NULL,
+        .record_path = NULL,
+        .replay_path = NULL,
+        .late_latch = false,
+        .lod_bias = 1.0f,
+        .shader_cache_dir = "shader_cache"
     };
 }
 
+/* Late latch: with EngineConfig.late_latch set, engine_end_frame polls
+ * events once more right before handing the draw list over and calls fn
+ * with the cursor motion that arrived since engine_poll_events, so the
+ * game can rotate the recorded view by it. The motion is still delivered
+ * to the next frame's input as usual. Not called during replay. */
+typedef void (*EngineLateLatchFn)(void* user, f64 mouse_dx, f64 mouse_dy, DrawList* list);
+void engine_set_late_latch(Engine* engine, EngineLateLatchFn fn, void* user);
+
 /* Access input state - declared in input/input.h */
 struct InputState* engine_get_input(Engine* engine);
 
+/* Job system shared by the engine and game; the main thread is thread 0 */
+JobSystem* engine_get_jobs(Engine* engine);
+
+/* Frame, update and render timings. The engine records frame and render
+ * time; the game adds FRAME_STAT_UPDATE around its simulation ticks. */
+FrameStats* engine_get_stats(Engine* engine);
+
+/* Main-thread bump allocator, reset in engine_begin_frame: allocations live
+ * until the next frame starts. Use scratch_begin for shorter lifetimes. */
+Arena* engine_get_frame_arena(Engine* engine);
+
+/* Feed input programmatically (headless runs, tests); call after
+ * engine_poll_events. Actions use GLFW values: 1 = press, 0 = release. */
+void engine_inject_key(Engine* engine, i32 key, i32 action);
+void engine_inject_mouse_button(Engine* engine, i32 button, i32 action);
+void engine_inject_mouse_move(Engine* engine, f64 x, f64 y);
+void engine_inject_scroll(Engine* engine, f64 x, f64 y);
+
 #endif /* ENGINE_H */
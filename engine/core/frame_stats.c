@@ -0,0 +1,247 @@
+#include "frame_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/* Values are whole microseconds. The first STATS_SUB_COUNT buckets are
+ * exact; above that each power of two is split into STATS_SUB_COUNT
+ * buckets, so a bucket spans at most 1/128 of its value. */
+#define STATS_SUB_BITS 7
+#define STATS_SUB_COUNT (1u << STATS_SUB_BITS)
+#define STATS_BUCKET_COUNT ((32 - STATS_SUB_BITS + 1) * STATS_SUB_COUNT)
+
+/* Window slot for a stat the frame didn't record */
+#define STATS_MISSING UINT32_MAX
+
+typedef struct {
+    u32 counts[STATS_BUCKET_COUNT];
+    u64 count;
+    u64 sum_us;
+    u32 max_us;               /* Only maintained for the whole-run histogram */
+} Histogram;
+
+struct FrameStats {
+    Histogram window[FRAME_STAT_COUNT];
+    Histogram total[FRAME_STAT_COUNT];
+    u32* samples;             /* window_frames rows of FRAME_STAT_COUNT */
+    u32 window_frames;
+    u64 frame_count;
+    f64 current_ms[FRAME_STAT_COUNT];
+    bool recorded[FRAME_STAT_COUNT];
+    FILE* csv;
+};
+
+static const char* g_stat_names[FRAME_STAT_COUNT] = { "frame", "update", "render", "input", "gpu" };
+
+static u32 highest_bit(u32 value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, value);
+    return (u32)index;
+#else
+    return 31u - (u32)__builtin_clz(value);
+#endif
+}
+
+static u32 bucket_index(u32 us) {
+    if (us < STATS_SUB_COUNT) return us;
+    u32 shift = highest_bit(us) - STATS_SUB_BITS;
+    return (shift + 1) * STATS_SUB_COUNT + ((us >> shift) & (STATS_SUB_COUNT - 1));
+}
+
+/* Largest value that lands in the bucket */
+static u32 bucket_upper(u32 index) {
+    if (index < STATS_SUB_COUNT) return index;
+    u32 shift = index / STATS_SUB_COUNT - 1;
+    u32 lower = (STATS_SUB_COUNT + index % STATS_SUB_COUNT) << shift;
+    return lower + ((1u << shift) - 1);
+}
+
+static u32 ms_to_us(f64 ms) {
+    f64 us = ms * 1000.0 + 0.5;
+    if (us <= 0.0) return 0;
+    if (us >= (f64)(STATS_MISSING - 1)) return STATS_MISSING - 1;
+    return (u32)us;
+}
+
+static void histogram_add(Histogram* histogram, u32 us) {
+    histogram->counts[bucket_index(us)]++;
+    histogram->count++;
+    histogram->sum_us += us;
+    if (us > histogram->max_us) histogram->max_us = us;
+}
+
+static void histogram_remove(Histogram* histogram, u32 us) {
+    histogram->counts[bucket_index(us)]--;
+    histogram->count--;
+    histogram->sum_us -= us;
+}
+
+static u32 histogram_percentile(const Histogram* histogram, f32 percentile) {
+    if (histogram->count == 0) return 0;
+
+    f64 fraction = percentile < 0.0f ? 0.0 : percentile > 100.0f ? 1.0 : percentile / 100.0;
+    u64 target = (u64)ceil(fraction * (f64)histogram->count);
+    if (target < 1) target = 1;
+
+    u64 seen = 0;
+    for (u32 i = 0; i < STATS_BUCKET_COUNT; i++) {
+        seen += histogram->counts[i];
+        if (seen >= target) return bucket_upper(i);
+    }
+    return bucket_upper(STATS_BUCKET_COUNT - 1);
+}
+
+FrameStats* frame_stats_create(u32 window_frames) {
+    FrameStats* stats = (FrameStats*)calloc(1, sizeof(FrameStats));
+    if (!stats) return NULL;
+
+    stats->window_frames = window_frames > 0 ? window_frames : 1;
+    stats->samples = (u32*)malloc((size_t)stats->window_frames * FRAME_STAT_COUNT * sizeof(u32));
+    if (!stats->samples) {
+        fprintf(stderr, "Failed to allocate frame stats window\n");
+        free(stats);
+        return NULL;
+    }
+    for (u32 i = 0; i < stats->window_frames * FRAME_STAT_COUNT; i++) {
+        stats->samples[i] = STATS_MISSING;
+    }
+    return stats;
+}
+
+void frame_stats_destroy(FrameStats* stats) {
+    if (!stats) return;
+    frame_stats_end_csv(stats);
+    free(stats->samples);
+    free(stats);
+}
+
+void frame_stats_record(FrameStats* stats, FrameStat stat, f64 ms) {
+    stats->current_ms[stat] += ms;
+    stats->recorded[stat] = true;
+}
+
+void frame_stats_end_frame(FrameStats* stats) {
+    u32* row = &stats->samples[(stats->frame_count % stats->window_frames) * FRAME_STAT_COUNT];
+
+    for (u32 s = 0; s < FRAME_STAT_COUNT; s++) {
+        /* The oldest frame leaves the window as this one enters */
+        if (row[s] != STATS_MISSING) {
+            histogram_remove(&stats->window[s], row[s]);
+        }
+        row[s] = STATS_MISSING;
+        if (stats->recorded[s]) {
+            row[s] = ms_to_us(stats->current_ms[s]);
+            histogram_add(&stats->window[s], row[s]);
+            histogram_add(&stats->total[s], row[s]);
+        }
+    }
+
+    if (stats->csv) {
+        fprintf(stats->csv, "%llu", (unsigned long long)stats->frame_count);
+        for (u32 s = 0; s < FRAME_STAT_COUNT; s++) {
+            if (stats->recorded[s]) {
+                fprintf(stats->csv, ",%.3f", stats->current_ms[s]);
+            } else {
+                fputc(',', stats->csv);
+            }
+        }
+        fputc('\n', stats->csv);
+    }
+
+    stats->frame_count++;
+    memset(stats->current_ms, 0, sizeof(stats->current_ms));
+    memset(stats->recorded, 0, sizeof(stats->recorded));
+}
+
+/* Exact maximum of the frames still in the window */
+static u32 window_max(const FrameStats* stats, FrameStat stat) {
+    u32 rows = stats->frame_count < stats->window_frames ? (u32)stats->frame_count : stats->window_frames;
+    u32 max_us = 0;
+    for (u32 i = 0; i < rows; i++) {
+        u32 us = stats->samples[i * FRAME_STAT_COUNT + stat];
+        if (us != STATS_MISSING && us > max_us) max_us = us;
+    }
+    return max_us;
+}
+
+f32 frame_stats_percentile(const FrameStats* stats, FrameStat stat,
+                           FrameStatsRange range, f32 percentile) {
+    const Histogram* histogram = range == FRAME_STATS_WINDOW ? &stats->window[stat] : &stats->total[stat];
+    u32 max_us = range == FRAME_STATS_WINDOW ? window_max(stats, stat) : histogram->max_us;
+
+    /* Bucket upper bounds can overshoot the largest real sample */
+    u32 us = histogram_percentile(histogram, percentile);
+    if (us > max_us) us = max_us;
+    return (f32)us * 0.001f;
+}
+
+FrameStatsSummary frame_stats_summary(const FrameStats* stats, FrameStat stat,
+                                      FrameStatsRange range) {
+    const Histogram* histogram = range == FRAME_STATS_WINDOW ? &stats->window[stat] : &stats->total[stat];
+    u32 max_us = range == FRAME_STATS_WINDOW ? window_max(stats, stat) : histogram->max_us;
+
+    FrameStatsSummary summary = {0};
+    summary.count = histogram->count;
+    if (histogram->count == 0) return summary;
+
+    summary.mean_ms = (f32)((f64)histogram->sum_us / (f64)histogram->count * 0.001);
+    summary.p50_ms = frame_stats_percentile(stats, stat, range, 50.0f);
+    summary.p95_ms = frame_stats_percentile(stats, stat, range, 95.0f);
+    summary.p99_ms = frame_stats_percentile(stats, stat, range, 99.0f);
+    summary.max_ms = (f32)max_us * 0.001f;
+    return summary;
+}
+
+void frame_stats_print(const FrameStats* stats, FrameStatsRange range) {
+    if (range == FRAME_STATS_WINDOW) {
+        printf("Frame stats (last %u frames):\n", stats->window_frames);
+    } else {
+        printf("Frame stats (%llu frames):\n", (unsigned long long)stats->frame_count);
+    }
+
+    for (u32 s = 0; s < FRAME_STAT_COUNT; s++) {
+        FrameStatsSummary summary = frame_stats_summary(stats, (FrameStat)s, range);
+        if (summary.count == 0) continue;
+        printf("  %-7s mean %7.3f  p50 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f ms\n",
+               g_stat_names[s], summary.mean_ms, summary.p50_ms, summary.p95_ms,
+               summary.p99_ms, summary.max_ms);
+    }
+}
+
+bool frame_stats_begin_csv(FrameStats* stats, const char* path) {
+    frame_stats_end_csv(stats);
+
+    stats->csv = fopen(path, "w");
+    if (!stats->csv) {
+        fprintf(stderr, "Failed to open stats output: %s\n", path);
+        return false;
+    }
+
+    fprintf(stats->csv, "frame");
+    for (u32 s = 0; s < FRAME_STAT_COUNT; s++) {
+        fprintf(stats->csv, ",%s_ms", g_stat_names[s]);
+    }
+    fputc('\n', stats->csv);
+    return true;
+}
+
+void frame_stats_end_csv(FrameStats* stats) {
+    if (stats->csv) {
+        fclose(stats->csv);
+        stats->csv = NULL;
+    }
+}
+
+bool frame_stats_csv_active(const FrameStats* stats) {
+    return stats->csv != NULL;
+}
+
+const char* frame_stat_name(FrameStat stat) {
+    return stat < FRAME_STAT_COUNT ? g_stat_names[stat] : "?";
+}
@@ -0,0 +1,66 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include "types.h"
+
+/* Per-frame timing statistics. Each stat goes into two log-linear
+ * histograms (HDR-style: 128 sub-buckets per power of two of microseconds,
+ * so values are kept to within 1%): one over a sliding window of recent
+ * frames and one over the whole run. Percentile queries walk the buckets,
+ * so they cost the same however many frames were recorded.
+ *
+ * Frames can also be streamed to a CSV file, one row per frame. */
+
+typedef enum {
+    FRAME_STAT_FRAME,    /* Wall time from one frame to the next */
+    FRAME_STAT_UPDATE,   /* Simulation ticks */
+    FRAME_STAT_RENDER,   /* Draw list execution and present */
+    FRAME_STAT_INPUT,    /* Mean age at present of the input events a frame first shows */
+    FRAME_STAT_GPU,      /* GPU time of the passes of a frame resolved this frame */
+    FRAME_STAT_COUNT
+} FrameStat;
+
+typedef enum {
+    FRAME_STATS_WINDOW,  /* The last window_frames frames */
+    FRAME_STATS_TOTAL    /* Every frame since creation */
+} FrameStatsRange;
+
+typedef struct {
+    u64 count;           /* Frames that recorded the stat */
+    f32 mean_ms;
+    f32 p50_ms;
+    f32 p95_ms;
+    f32 p99_ms;
+    f32 max_ms;
+} FrameStatsSummary;
+
+typedef struct FrameStats FrameStats;
+
+FrameStats* frame_stats_create(u32 window_frames);
+void frame_stats_destroy(FrameStats* stats);
+
+/* Add time to a stat for the current frame; several calls in one frame sum */
+void frame_stats_record(FrameStats* stats, FrameStat stat, f64 ms);
+
+/* Commit the current frame to the histograms and CSV. Stats not recorded
+ * this frame are left out rather than counted as zero. */
+void frame_stats_end_frame(FrameStats* stats);
+
+/* Value at or below which percentile% (0-100) of samples fall; 0 if empty */
+f32 frame_stats_percentile(const FrameStats* stats, FrameStat stat,
+                           FrameStatsRange range, f32 percentile);
+FrameStatsSummary frame_stats_summary(const FrameStats* stats, FrameStat stat,
+                                      FrameStatsRange range);
+
+/* Print p50/p95/p99/max of every recorded stat to stdout */
+void frame_stats_print(const FrameStats* stats, FrameStatsRange range);
+
+/* Stream one row per frame to path until frame_stats_end_csv; replaces
+ * any CSV already being written */
+bool frame_stats_begin_csv(FrameStats* stats, const char* path);
+void frame_stats_end_csv(FrameStats* stats);
+bool frame_stats_csv_active(const FrameStats* stats);
+
+const char* frame_stat_name(FrameStat stat);
+
+#endif /* FRAME_STATS_H */
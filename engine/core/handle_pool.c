@@ -0,0 +1,128 @@
+#include "handle_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* End of the free slot list */
+#define HANDLE_NO_SLOT HANDLE_MAX_SLOTS
+
+static inline u32 handle_slot(u32 id) {
+    return id & (HANDLE_MAX_SLOTS - 1);
+}
+
+static inline u32 handle_generation(u32 id) {
+    return id >> HANDLE_INDEX_BITS;
+}
+
+/* Slots only run out of free entries when every one is live, so the slot
+ * arrays never need more entries than the item arrays */
+static bool handle_pool_grow(HandlePool* pool, u32 new_capacity) {
+    if (new_capacity > HANDLE_MAX_SLOTS) new_capacity = HANDLE_MAX_SLOTS;
+    if (new_capacity <= pool->capacity) return false;
+
+    u8* items = (u8*)realloc(pool->items, (size_t)new_capacity * pool->item_size);
+    if (!items) return false;
+    pool->items = items;
+
+    u32* item_ids = (u32*)realloc(pool->item_ids, new_capacity * sizeof(u32));
+    if (!item_ids) return false;
+    pool->item_ids = item_ids;
+
+    u32* slot_items = (u32*)realloc(pool->slot_items, new_capacity * sizeof(u32));
+    if (!slot_items) return false;
+    pool->slot_items = slot_items;
+
+    u16* slot_generations = (u16*)realloc(pool->slot_generations, new_capacity * sizeof(u16));
+    if (!slot_generations) return false;
+    pool->slot_generations = slot_generations;
+
+    pool->capacity = new_capacity;
+    return true;
+}
+
+bool handle_pool_init(HandlePool* pool, u32 item_size, u32 initial_capacity, const char* name) {
+    memset(pool, 0, sizeof(HandlePool));
+    pool->item_size = item_size;
+    pool->free_slot = HANDLE_NO_SLOT;
+    pool->name = name;
+    if (!handle_pool_grow(pool, initial_capacity > 0 ? initial_capacity : 16)) {
+        fprintf(stderr, "Failed to allocate %s pool\n", name);
+        handle_pool_free(pool);
+        return false;
+    }
+    return true;
+}
+
+void handle_pool_free(HandlePool* pool) {
+    free(pool->items);
+    free(pool->item_ids);
+    free(pool->slot_items);
+    free(pool->slot_generations);
+    memset(pool, 0, sizeof(HandlePool));
+    pool->free_slot = HANDLE_NO_SLOT;
+}
+
+void* handle_pool_alloc(HandlePool* pool, u32* id) {
+    *id = 0;
+    if (pool->count == pool->capacity && !handle_pool_grow(pool, pool->capacity * 2)) {
+        fprintf(stderr, "%s pool is full (%u items)\n", pool->name, pool->count);
+        return NULL;
+    }
+
+    u32 slot;
+    if (pool->free_slot != HANDLE_NO_SLOT) {
+        slot = pool->free_slot;
+        pool->free_slot = pool->slot_items[slot];
+    } else {
+        slot = pool->slot_count++;
+        pool->slot_generations[slot] = 1;
+    }
+
+    u32 index = pool->count++;
+    *id = ((u32)pool->slot_generations[slot] << HANDLE_INDEX_BITS) | slot;
+    pool->slot_items[slot] = index;
+    pool->item_ids[index] = *id;
+
+    void* item = handle_pool_item_at(pool, index);
+    memset(item, 0, pool->item_size);
+    return item;
+}
+
+bool handle_pool_release(HandlePool* pool, u32 id) {
+    if (id == 0) return false;
+    if (!handle_pool_get(pool, id)) {
+        fprintf(stderr, "%s handle %08x released twice or never allocated\n", pool->name, id);
+        return false;
+    }
+
+    u32 slot = handle_slot(id);
+    u32 index = pool->slot_items[slot];
+    u32 last = pool->count - 1;
+
+    /* Keep the items packed: the last one takes the hole */
+    if (index != last) {
+        memcpy(handle_pool_item_at(pool, index), handle_pool_item_at(pool, last), pool->item_size);
+        u32 moved_id = pool->item_ids[last];
+        pool->item_ids[index] = moved_id;
+        pool->slot_items[handle_slot(moved_id)] = index;
+    }
+    pool->count--;
+
+    /* Skip generation 0 on wrap so id 0 stays null */
+    u32 generation = (pool->slot_generations[slot] + 1) & HANDLE_GENERATION_MASK;
+    pool->slot_generations[slot] = (u16)(generation ? generation : 1);
+    pool->slot_items[slot] = pool->free_slot;
+    pool->free_slot = slot;
+    return true;
+}
+
+void* handle_pool_get(const HandlePool* pool, u32 id) {
+    u32 slot = handle_slot(id);
+    if (id == 0 || slot >= pool->slot_count) return NULL;
+    if (pool->slot_generations[slot] != handle_generation(id)) return NULL;
+
+    /* A free slot's entry is a list link; it only matches when live */
+    u32 index = pool->slot_items[slot];
+    if (index >= pool->count || pool->item_ids[index] != id) return NULL;
+    return handle_pool_item_at(pool, index);
+}
@@ -0,0 +1,60 @@
+#ifndef HANDLE_POOL_H
+#define HANDLE_POOL_H
+
+#include "types.h"
+#include <stddef.h>
+
+/* Dense pool addressed by generational handles. Live items are packed at
+ * the start of one array, so iterating them touches no gaps; a slot table
+ * maps each handle to its item's current position. Releasing moves the
+ * last item into the hole and bumps the slot's generation, which makes
+ * every copy of the old handle fail to resolve instead of reaching
+ * whatever reuses the slot.
+ *
+ * Item pointers are valid until the next alloc or release on the pool. */
+
+/* Handle id: generation above HANDLE_INDEX_BITS, slot below. Generations
+ * start at 1, so id 0 is never live. */
+#define HANDLE_INDEX_BITS 20
+#define HANDLE_MAX_SLOTS (1u << HANDLE_INDEX_BITS)
+#define HANDLE_GENERATION_MASK ((1u << (32 - HANDLE_INDEX_BITS)) - 1)
+
+typedef struct {
+    u8* items;              /* count live items of item_size bytes */
+    u32* item_ids;          /* Handle id of each item */
+    u32* slot_items;        /* Item index of a live slot; next free slot otherwise */
+    u16* slot_generations;
+    u32 item_size;
+    u32 count;
+    u32 capacity;
+    u32 slot_count;         /* Slots ever handed out */
+    u32 free_slot;          /* Head of the free slot list */
+    const char* name;       /* For diagnostics */
+} HandlePool;
+
+bool handle_pool_init(HandlePool* pool, u32 item_size, u32 initial_capacity, const char* name);
+void handle_pool_free(HandlePool* pool);
+
+/* New zeroed item; returns NULL (and id 0) when out of memory or slots */
+void* handle_pool_alloc(HandlePool* pool, u32* id);
+
+/* False for id 0 and for ids already released, which are reported */
+bool handle_pool_release(HandlePool* pool, u32 id);
+
+/* NULL unless id refers to a live item */
+void* handle_pool_get(const HandlePool* pool, u32 id);
+
+static inline u32 handle_pool_count(const HandlePool* pool) {
+    return pool->count;
+}
+
+/* Dense iteration over [0, count) */
+static inline void* handle_pool_item_at(const HandlePool* pool, u32 index) {
+    return pool->items + (size_t)index * pool->item_size;
+}
+
+static inline u32 handle_pool_id_at(const HandlePool* pool, u32 index) {
+    return pool->item_ids[index];
+}
+
+#endif /* HANDLE_POOL_H */
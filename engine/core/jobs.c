@@ -0,0 +1,443 @@
+/* sysconf under strict -std=c11 */
+#if !defined(_WIN32) && !defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "jobs.h"
+#include "atomic.h"
+#include "arena.h"
+#include "profiler.h"
+#include "thread.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+/* Idle loop iterations before a worker goes to sleep */
+#define JOB_SPIN_COUNT 64
+
+typedef struct Job {
+    JobFunc func;
+    JobRangeFunc range_func;  /* Used instead of func when set */
+    void* data;
+    u32 begin;
+    u32 end;
+    JobCounter* counter;
+    struct JobWorker* owner;  /* Pool the job returns to */
+    struct Job* next;         /* Link in a waiter or free list */
+} Job;
+
+/* Chase-Lev deque over a fixed ring. The owner pushes and pops at bottom;
+ * thieves take from top and race the owner with a CAS for the last job. */
+typedef struct {
+    volatile i64 top;
+    u8 pad0[64 - sizeof(i64)];
+    volatile i64 bottom;
+    u8 pad1[64 - sizeof(i64)];
+    void* volatile slots[JOB_POOL_SIZE];
+} JobDeque;
+
+typedef struct JobWorker {
+    JobDeque deque;
+    Job pool[JOB_POOL_SIZE];
+    Job* free_list;            /* Owner only */
+    void* volatile returned;   /* Jobs finished on other threads */
+    u32 rng;
+    u32 index;
+    JobSystem* system;
+    Thread thread;
+} JobWorker;
+
+struct JobSystem {
+    JobWorker* workers;       /* [0] belongs to the creating thread */
+    u32 thread_count;
+    volatile i32 running;
+    volatile i32 queued;      /* Pushed but not yet taken */
+    volatile i32 sleeping;
+    Mutex mutex;
+    Cond wake;
+};
+
+static ENGINE_THREAD_LOCAL JobWorker* t_worker = NULL;
+
+u32 job_system_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (u32)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+#endif
+}
+
+/* Deque operations */
+static bool deque_push(JobDeque* d, Job* job) {
+    i64 b = atomic_i64_load(&d->bottom);
+    i64 t = atomic_i64_load(&d->top);
+    if (b - t >= JOB_POOL_SIZE) return false;
+    atomic_ptr_store(&d->slots[b & (JOB_POOL_SIZE - 1)], job);
+    atomic_i64_store(&d->bottom, b + 1);
+    return true;
+}
+
+static Job* deque_pop(JobDeque* d) {
+    i64 b = atomic_i64_load(&d->bottom) - 1;
+    atomic_i64_store(&d->bottom, b);
+    i64 t = atomic_i64_load(&d->top);
+
+    if (t > b) {
+        /* Empty */
+        atomic_i64_store(&d->bottom, b + 1);
+        return NULL;
+    }
+
+    Job* job = (Job*)atomic_ptr_load(&d->slots[b & (JOB_POOL_SIZE - 1)]);
+    if (t == b) {
+        /* Last job: a thief may be taking it too */
+        if (!atomic_i64_cas(&d->top, t, t + 1)) {
+            job = NULL;
+        }
+        atomic_i64_store(&d->bottom, b + 1);
+    }
+    return job;
+}
+
+static Job* deque_steal(JobDeque* d) {
+    i64 t = atomic_i64_load(&d->top);
+    i64 b = atomic_i64_load(&d->bottom);
+    if (t >= b) return NULL;
+
+    Job* job = (Job*)atomic_ptr_load(&d->slots[t & (JOB_POOL_SIZE - 1)]);
+    if (!atomic_i64_cas(&d->top, t, t + 1)) {
+        return NULL;
+    }
+    return job;
+}
+
+static JobWorker* current_worker(const JobSystem* jobs) {
+    return t_worker && t_worker->system == jobs ? t_worker : NULL;
+}
+
+/* NULL when every job in the pool is in flight */
+static Job* job_alloc(JobWorker* worker) {
+    if (!worker->free_list) {
+        worker->free_list = (Job*)atomic_ptr_exchange(&worker->returned, NULL);
+        if (!worker->free_list) return NULL;
+    }
+
+    Job* job = worker->free_list;
+    worker->free_list = job->next;
+    job->func = NULL;
+    job->range_func = NULL;
+    job->data = NULL;
+    job->begin = 0;
+    job->end = 0;
+    job->counter = NULL;
+    job->next = NULL;
+    return job;
+}
+
+static void job_free(JobWorker* worker, Job* job) {
+    JobWorker* owner = job->owner;
+    if (owner == worker) {
+        job->next = owner->free_list;
+        owner->free_list = job;
+        return;
+    }
+
+    /* Another thread's pool: push onto its return stack. Only the owner
+     * takes from it, and always the whole list, so there is no ABA. */
+    void* head;
+    do {
+        head = atomic_ptr_load(&owner->returned);
+        job->next = (Job*)head;
+    } while (!atomic_ptr_cas(&owner->returned, head, job));
+}
+
+static void job_execute(JobSystem* jobs, JobWorker* worker, Job* job);
+
+static void job_push(JobSystem* jobs, JobWorker* worker, Job* job) {
+    if (!deque_push(&worker->deque, job)) {
+        /* Deque full: run it here rather than drop it */
+        job_execute(jobs, worker, job);
+        return;
+    }
+
+    atomic_i32_add(&jobs->queued, 1);
+    if (atomic_i32_load(&jobs->sleeping) > 0) {
+        mutex_lock(&jobs->mutex);
+        cond_signal(&jobs->wake);
+        mutex_unlock(&jobs->mutex);
+    }
+}
+
+/* Queue every job waiting on a counter that just reached zero */
+static void release_waiters(JobSystem* jobs, JobWorker* worker, JobCounter* counter) {
+    Job* job = (Job*)atomic_ptr_exchange(&counter->waiters, NULL);
+    while (job) {
+        Job* next = job->next;
+        job->next = NULL;
+        job_push(jobs, worker, job);
+        job = next;
+    }
+}
+
+static void job_execute(JobSystem* jobs, JobWorker* worker, Job* job) {
+    if (job->range_func) {
+        job->range_func(job->data, job->begin, job->end);
+    } else {
+        job->func(job->data);
+    }
+
+    JobCounter* counter = job->counter;
+    job_free(worker, job);
+    if (counter) {
+        /* A waiter may return and free the counter as soon as it reads zero,
+         * so announce the release first and make it the last access */
+        atomic_i32_add(&counter->releasing, 1);
+        if (atomic_i32_add(&counter->pending, -1) == 0) {
+            release_waiters(jobs, worker, counter);
+        }
+        atomic_i32_add(&counter->releasing, -1);
+    }
+}
+
+/* Own deque first, then steal starting from a random victim */
+static Job* job_take(JobSystem* jobs, JobWorker* worker) {
+    Job* job = deque_pop(&worker->deque);
+
+    if (!job && jobs->thread_count > 1) {
+        worker->rng ^= worker->rng << 13;
+        worker->rng ^= worker->rng >> 17;
+        worker->rng ^= worker->rng << 5;
+        u32 start = worker->rng % jobs->thread_count;
+        for (u32 i = 0; i < jobs->thread_count && !job; i++) {
+            u32 victim = (start + i) % jobs->thread_count;
+            if (victim != worker->index) {
+                job = deque_steal(&jobs->workers[victim].deque);
+            }
+        }
+    }
+
+    if (job) {
+        atomic_i32_add(&jobs->queued, -1);
+    }
+    return job;
+}
+
+static void worker_main(void* arg) {
+    JobWorker* worker = (JobWorker*)arg;
+    JobSystem* jobs = worker->system;
+    t_worker = worker;
+    PROFILE_THREAD_NAME("Worker");
+
+    u32 idle = 0;
+    while (atomic_i32_load(&jobs->running)) {
+        Job* job = job_take(jobs, worker);
+        if (job) {
+            job_execute(jobs, worker, job);
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < JOB_SPIN_COUNT) {
+            thread_yield();
+            continue;
+        }
+
+        /* Sleep until a push; sleeping is published before queued is
+         * re-checked so a concurrent push either sees us or we see it */
+        mutex_lock(&jobs->mutex);
+        atomic_i32_add(&jobs->sleeping, 1);
+        while (atomic_i32_load(&jobs->running) && atomic_i32_load(&jobs->queued) <= 0) {
+            cond_wait(&jobs->wake, &jobs->mutex);
+        }
+        atomic_i32_add(&jobs->sleeping, -1);
+        mutex_unlock(&jobs->mutex);
+        idle = 0;
+    }
+
+    t_worker = NULL;
+    scratch_thread_shutdown();
+}
+
+JobSystem* job_system_create(u32 worker_count) {
+    if (worker_count == 0) {
+        u32 cores = job_system_cpu_count();
+        worker_count = cores > 1 ? cores - 1 : 0;
+    }
+
+    JobSystem* jobs = (JobSystem*)malloc(sizeof(JobSystem));
+    if (!jobs) return NULL;
+
+    jobs->thread_count = worker_count + 1;
+    jobs->workers = (JobWorker*)calloc(jobs->thread_count, sizeof(JobWorker));
+    if (!jobs->workers) {
+        fprintf(stderr, "Failed to allocate job workers\n");
+        free(jobs);
+        return NULL;
+    }
+
+    jobs->running = 1;
+    jobs->queued = 0;
+    jobs->sleeping = 0;
+    mutex_init(&jobs->mutex);
+    cond_init(&jobs->wake);
+
+    for (u32 i = 0; i < jobs->thread_count; i++) {
+        JobWorker* worker = &jobs->workers[i];
+        worker->index = i;
+        worker->system = jobs;
+        worker->rng = 0x9E3779B9u * (i + 1);
+        for (u32 j = 0; j < JOB_POOL_SIZE; j++) {
+            worker->pool[j].owner = worker;
+            worker->pool[j].next = j + 1 < JOB_POOL_SIZE ? &worker->pool[j + 1] : NULL;
+        }
+        worker->free_list = &worker->pool[0];
+    }
+    t_worker = &jobs->workers[0];
+
+    for (u32 i = 1; i < jobs->thread_count; i++) {
+        JobWorker* worker = &jobs->workers[i];
+        if (!thread_start(&worker->thread, worker_main, worker)) {
+            /* Run with the workers we got */
+            fprintf(stderr, "Failed to start job worker %u\n", i);
+            jobs->thread_count = i;
+            break;
+        }
+    }
+
+    return jobs;
+}
+
+void job_system_destroy(JobSystem* jobs) {
+    if (!jobs) return;
+
+    mutex_lock(&jobs->mutex);
+    atomic_i32_store(&jobs->running, 0);
+    cond_broadcast(&jobs->wake);
+    mutex_unlock(&jobs->mutex);
+
+    for (u32 i = 1; i < jobs->thread_count; i++) {
+        thread_join(&jobs->workers[i].thread);
+    }
+
+    if (t_worker && t_worker->system == jobs) {
+        t_worker = NULL;
+    }
+
+    cond_destroy(&jobs->wake);
+    mutex_destroy(&jobs->mutex);
+    free(jobs->workers);
+    free(jobs);
+}
+
+u32 job_system_thread_count(const JobSystem* jobs) {
+    return jobs ? jobs->thread_count : 1;
+}
+
+u32 job_system_thread_index(const JobSystem* jobs) {
+    JobWorker* worker = current_worker(jobs);
+    return worker ? worker->index : 0;
+}
+
+static void job_submit(JobSystem* jobs, JobCounter* dependency, Job* job) {
+    JobWorker* worker = current_worker(jobs);
+
+    if (job->counter) {
+        atomic_i32_add(&job->counter->pending, 1);
+    }
+
+    if (dependency && atomic_i32_load(&dependency->pending) > 0) {
+        /* Park on the dependency. If it finished while we were linking in,
+         * its release may have missed us, so take the list back ourselves;
+         * whoever swaps the list out queues the jobs on it. */
+        void* head;
+        do {
+            head = atomic_ptr_load(&dependency->waiters);
+            job->next = (Job*)head;
+        } while (!atomic_ptr_cas(&dependency->waiters, head, job));
+
+        if (atomic_i32_load(&dependency->pending) <= 0) {
+            release_waiters(jobs, worker, dependency);
+        }
+        return;
+    }
+
+    job_push(jobs, worker, job);
+}
+
+void job_system_run(JobSystem* jobs, JobFunc func, void* data, JobCounter* counter) {
+    job_system_run_after(jobs, NULL, func, data, counter);
+}
+
+void job_system_run_after(JobSystem* jobs, JobCounter* dependency,
+                          JobFunc func, void* data, JobCounter* counter) {
+    JobWorker* worker = jobs ? current_worker(jobs) : NULL;
+    Job* job = worker ? job_alloc(worker) : NULL;
+    if (!job) {
+        /* No system, a foreign thread or a full pool: run inline */
+        if (dependency) job_system_wait(jobs, dependency);
+        func(data);
+        return;
+    }
+
+    job->func = func;
+    job->data = data;
+    job->counter = counter;
+    job_submit(jobs, dependency, job);
+}
+
+void job_system_wait(JobSystem* jobs, JobCounter* counter) {
+    JobWorker* worker = jobs ? current_worker(jobs) : NULL;
+
+    while (atomic_i32_load(&counter->pending) > 0 || atomic_i32_load(&counter->releasing) > 0) {
+        Job* job = worker ? job_take(jobs, worker) : NULL;
+        if (job) {
+            job_execute(jobs, worker, job);
+        } else {
+            thread_yield();
+        }
+    }
+}
+
+void job_system_parallel_for(JobSystem* jobs, u32 count, u32 min_batch,
+                             JobRangeFunc func, void* data) {
+    if (count == 0) return;
+    if (min_batch == 0) min_batch = 1;
+
+    JobWorker* worker = jobs ? current_worker(jobs) : NULL;
+    if (!worker || jobs->thread_count == 1 || count <= min_batch) {
+        func(data, 0, count);
+        return;
+    }
+
+    /* A few batches per thread so stealing can even out uneven work */
+    u32 batches = (count + min_batch - 1) / min_batch;
+    u32 max_batches = jobs->thread_count * 4;
+    if (batches > max_batches) batches = max_batches;
+    u32 batch_size = (count + batches - 1) / batches;
+
+    JobCounter counter = {0};
+    for (u32 begin = batch_size; begin < count; begin += batch_size) {
+        u32 end = begin + batch_size < count ? begin + batch_size : count;
+        Job* job = job_alloc(worker);
+        if (!job) {
+            func(data, begin, end);
+            continue;
+        }
+        job->range_func = func;
+        job->data = data;
+        job->begin = begin;
+        job->end = end;
+        job->counter = &counter;
+        job_submit(jobs, NULL, job);
+    }
+
+    /* The first batch runs here while the others are stolen */
+    func(data, 0, batch_size < count ? batch_size : count);
+    job_system_wait(jobs, &counter);
+}
@@ -0,0 +1,66 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "types.h"
+
+/* Work-stealing job system. Every thread (the creating thread plus the
+ * workers) owns a deque: it pushes and pops its own jobs at the bottom,
+ * idle threads steal from the top of the others'. Completion is tracked
+ * with counters, and waiting on one runs queued jobs instead of blocking.
+ *
+ * Jobs may be submitted from the thread that created the system and from
+ * inside jobs. Submitting from any other thread runs the job inline. */
+typedef struct JobSystem JobSystem;
+
+typedef void (*JobFunc)(void* data);
+typedef void (*JobRangeFunc)(void* data, u32 begin, u32 end);
+
+/* Number of jobs submitted with this counter that haven't finished. A job
+ * counts from submission, even while job_system_run_after holds it back,
+ * until it has run. Jobs parked on a counter as their dependency don't
+ * add to it; they are queued once it drops to zero. Zero-initialize before
+ * first use; one counter can track any number of jobs, and must stay alive
+ * until job_system_wait on it returns. */
+typedef struct {
+    volatile i32 pending;
+    volatile i32 releasing;
+    void* volatile waiters;
+} JobCounter;
+
+/* Jobs one thread can have in flight (queued, running or waiting on a
+ * dependency); submissions beyond that run inline */
+#define JOB_POOL_SIZE 4096
+
+/* worker_count 0 = one worker per core besides the calling thread */
+JobSystem* job_system_create(u32 worker_count);
+void job_system_destroy(JobSystem* jobs);
+
+/* Workers plus the creating thread */
+u32 job_system_thread_count(const JobSystem* jobs);
+
+/* Index of the calling thread in [0, thread_count), 0 for the creating
+ * thread; for per-thread scratch inside jobs */
+u32 job_system_thread_index(const JobSystem* jobs);
+
+/* Queue func(data). counter (optional) is incremented now and decremented
+ * when the job finishes. */
+void job_system_run(JobSystem* jobs, JobFunc func, void* data, JobCounter* counter);
+
+/* As job_system_run, but the job doesn't start before dependency reaches
+ * zero; chains jobs without blocking the submitting thread */
+void job_system_run_after(JobSystem* jobs, JobCounter* dependency,
+                          JobFunc func, void* data, JobCounter* counter);
+
+/* Run queued jobs on this thread until counter reaches zero */
+void job_system_wait(JobSystem* jobs, JobCounter* counter);
+
+/* Split [0, count) into batches of at least min_batch, call func on each
+ * across all threads and wait for them. Runs inline when jobs is NULL or
+ * the range fits in one batch. */
+void job_system_parallel_for(JobSystem* jobs, u32 count, u32 min_batch,
+                             JobRangeFunc func, void* data);
+
+/* Logical processors available to the process */
+u32 job_system_cpu_count(void);
+
+#endif /* JOBS_H */
@@ -0,0 +1,287 @@
+#include "profiler.h"
+#include "atomic.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Frames remembered for the trace window and budget checks */
+#define PROFILER_MAX_FRAMES 1024
+
+/* Oldest events skipped by a dump so writers can't overwrite what it reads */
+#define PROFILER_DUMP_MARGIN 1024
+
+typedef struct {
+    const char* name;
+    u64 start_ns;
+    u64 end_ns;
+} ProfileEvent;
+
+typedef struct {
+    u64 index;
+    u64 start_ns;
+    u64 end_ns;
+} ProfileFrame;
+
+/* Written only by its thread; the dump reads it from the main thread */
+typedef struct {
+    ProfileEvent events[PROFILER_EVENTS_PER_THREAD];
+    volatile i64 written;     /* Events ever written; slot = written % size */
+    const char* stack_names[PROFILER_MAX_DEPTH];
+    u64 stack_starts[PROFILER_MAX_DEPTH];
+    u32 depth;
+    u32 id;
+    const char* name;
+} ProfileThread;
+
+typedef struct {
+    volatile i32 initialized; /* Read by markers on every thread */
+    u32 generation;           /* Bumped by init so stale thread pointers re-register */
+    u32 window_frames;
+    ProfileThread* volatile threads[PROFILER_MAX_THREADS];
+    volatile i32 thread_count;
+    ProfileThread* gpu;       /* Track fed by profiler_record_gpu */
+    ProfileFrame frames[PROFILER_MAX_FRAMES];
+    u64 frame_count;
+    u64 frame_start_ns;
+    u64 last_dump_frame;
+    bool dump_requested;
+} Profiler;
+
+static Profiler g_profiler = {0};
+
+static inline bool profiler_active(void) {
+    return atomic_i32_load(&g_profiler.initialized) != 0;
+}
+
+static ENGINE_THREAD_LOCAL ProfileThread* t_thread = NULL;
+static ENGINE_THREAD_LOCAL u32 t_generation = 0;
+
+static ProfileThread* register_track(void) {
+    i32 slot = atomic_i32_add(&g_profiler.thread_count, 1) - 1;
+    if (slot >= PROFILER_MAX_THREADS) {
+        atomic_i32_add(&g_profiler.thread_count, -1);
+        return NULL;
+    }
+
+    ProfileThread* thread = (ProfileThread*)calloc(1, sizeof(ProfileThread));
+    if (!thread) return NULL;
+    thread->id = (u32)slot;
+    thread->name = slot == 0 ? "Main" : NULL;
+    atomic_ptr_store((void* volatile*)&g_profiler.threads[slot], thread);
+    return thread;
+}
+
+static ProfileThread* profiler_thread(void) {
+    if (t_thread && t_generation == g_profiler.generation) {
+        return t_thread;
+    }
+
+    ProfileThread* thread = register_track();
+    if (!thread) return NULL;
+    t_thread = thread;
+    t_generation = g_profiler.generation;
+    return thread;
+}
+
+void profiler_init(u32 window_frames) {
+    if (profiler_active()) return;
+
+    /* The generation survives re-initialization so old thread-locals go stale */
+    u32 generation = g_profiler.generation + 1;
+    memset(&g_profiler, 0, sizeof(g_profiler));
+    g_profiler.generation = generation;
+    g_profiler.window_frames = window_frames > 0 && window_frames <= PROFILER_MAX_FRAMES
+                             ? window_frames : 120;
+    atomic_i32_store(&g_profiler.initialized, 1);
+
+    /* The initializing thread is the main thread, id 0 */
+    profiler_thread();
+}
+
+void profiler_shutdown(void) {
+    if (!profiler_active()) return;
+
+    /* Markers stop recording from here on; the rings are freed below, so
+     * no other thread may still be inside one (see profiler.h) */
+    atomic_i32_store(&g_profiler.initialized, 0);
+    i32 count = atomic_i32_load(&g_profiler.thread_count);
+    for (i32 i = 0; i < count && i < PROFILER_MAX_THREADS; i++) {
+        free(g_profiler.threads[i]);
+        g_profiler.threads[i] = NULL;
+    }
+    g_profiler.thread_count = 0;
+    t_thread = NULL;
+}
+
+static void push_event(ProfileThread* thread, const char* name, u64 start_ns, u64 end_ns) {
+    i64 written = thread->written;
+    ProfileEvent* event = &thread->events[written % PROFILER_EVENTS_PER_THREAD];
+    event->name = name;
+    event->start_ns = start_ns;
+    event->end_ns = end_ns;
+    /* Publish after the event is complete */
+    atomic_i64_store(&thread->written, written + 1);
+}
+
+void profiler_begin(const char* name) {
+    if (!profiler_active()) return;
+    ProfileThread* thread = profiler_thread();
+    if (!thread) return;
+
+    /* Past the maximum depth only the depth is tracked */
+    if (thread->depth < PROFILER_MAX_DEPTH) {
+        thread->stack_names[thread->depth] = name;
+        thread->stack_starts[thread->depth] = timer_now_ns();
+    }
+    thread->depth++;
+}
+
+void profiler_end(void) {
+    if (!profiler_active()) return;
+    ProfileThread* thread = profiler_thread();
+    if (!thread || thread->depth == 0) return;
+
+    thread->depth--;
+    if (thread->depth >= PROFILER_MAX_DEPTH) return;
+
+    push_event(thread, thread->stack_names[thread->depth],
+               thread->stack_starts[thread->depth], timer_now_ns());
+}
+
+void profiler_record_gpu(const char* name, u64 start_ns, u64 end_ns) {
+    if (!profiler_active()) return;
+
+    if (!g_profiler.gpu) {
+        g_profiler.gpu = register_track();
+        if (!g_profiler.gpu) return;
+        g_profiler.gpu->name = "GPU";
+    }
+    push_event(g_profiler.gpu, name, start_ns, end_ns);
+}
+
+void profiler_set_thread_name(const char* name) {
+    if (!profiler_active()) return;
+    ProfileThread* thread = profiler_thread();
+    if (thread) {
+        thread->name = name;
+    }
+}
+
+void profiler_frame_begin(void) {
+    if (!profiler_active()) return;
+    g_profiler.frame_start_ns = timer_now_ns();
+}
+
+void profiler_request_dump(void) {
+    g_profiler.dump_requested = true;
+}
+
+void profiler_frame_end(f32 budget_ms) {
+    if (!profiler_active()) return;
+
+    ProfileFrame* frame = &g_profiler.frames[g_profiler.frame_count % PROFILER_MAX_FRAMES];
+    frame->index = g_profiler.frame_count;
+    frame->start_ns = g_profiler.frame_start_ns;
+    frame->end_ns = timer_now_ns();
+    g_profiler.frame_count++;
+
+    f64 frame_ms = (f64)(frame->end_ns - frame->start_ns) * 1e-6;
+    bool over_budget = budget_ms > 0.0f && frame_ms > budget_ms;
+
+    /* After a budget dump, let a full window go by so one hitch doesn't
+     * produce a file per frame */
+    bool cooled_down = g_profiler.last_dump_frame == 0 ||
+                       frame->index >= g_profiler.last_dump_frame + g_profiler.window_frames;
+
+    if (g_profiler.dump_requested || (over_budget && cooled_down)) {
+        char path[64];
+        snprintf(path, sizeof(path), "profile_%llu.json", (unsigned long long)frame->index);
+        if (over_budget) {
+            printf("Frame %llu took %.2f ms (budget %.2f ms)\n",
+                   (unsigned long long)frame->index, frame_ms, budget_ms);
+        }
+        if (profiler_dump(path)) {
+            printf("Wrote profile: %s\n", path);
+        }
+        g_profiler.dump_requested = false;
+        g_profiler.last_dump_frame = frame->index > 0 ? frame->index : 1;
+    }
+}
+
+static void write_json_string(FILE* file, const char* str) {
+    fputc('"', file);
+    for (const char* c = str ? str : "?"; *c; c++) {
+        if (*c == '"' || *c == '\\') fputc('\\', file);
+        if ((unsigned char)*c >= 0x20) fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+bool profiler_dump(const char* path) {
+    if (!profiler_active() || g_profiler.frame_count == 0) return false;
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open profile output: %s\n", path);
+        return false;
+    }
+
+    /* Window: the last window_frames completed frames */
+    u64 frames = g_profiler.frame_count < g_profiler.window_frames
+               ? g_profiler.frame_count : g_profiler.window_frames;
+    u64 first = g_profiler.frame_count - frames;
+    u64 window_start = g_profiler.frames[first % PROFILER_MAX_FRAMES].start_ns;
+    u64 origin = window_start;
+    if (first == 0) {
+        /* Include loading done before the first frame */
+        window_start = 0;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first_event = true;
+
+    i32 thread_count = atomic_i32_load(&g_profiler.thread_count);
+    for (i32 t = 0; t < thread_count && t < PROFILER_MAX_THREADS; t++) {
+        ProfileThread* thread = (ProfileThread*)atomic_ptr_load((void* volatile*)&g_profiler.threads[t]);
+        if (!thread) continue;
+
+        char fallback[32];
+        snprintf(fallback, sizeof(fallback), "Thread %u", thread->id);
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                first_event ? "" : ",\n", thread->id);
+        write_json_string(file, thread->name ? thread->name : fallback);
+        fprintf(file, "}}");
+        first_event = false;
+
+        /* Other threads may still be writing; only read what they've
+         * published, and stay clear of the slots about to be overwritten */
+        i64 written = atomic_i64_load(&thread->written);
+        i64 readable = PROFILER_EVENTS_PER_THREAD - PROFILER_DUMP_MARGIN;
+        i64 begin = written > readable ? written - readable : 0;
+        for (i64 i = begin; i < written; i++) {
+            const ProfileEvent* event = &thread->events[i % PROFILER_EVENTS_PER_THREAD];
+            if (event->start_ns < window_start) continue;
+            fprintf(file, ",\n{\"name\":");
+            write_json_string(file, event->name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    thread->id, ((f64)event->start_ns - (f64)origin) * 1e-3,
+                    (f64)(event->end_ns - event->start_ns) * 1e-3);
+        }
+    }
+
+    /* Frames on their own track */
+    fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Frames\"}}",
+            PROFILER_MAX_THREADS);
+    for (u64 f = first; f < g_profiler.frame_count; f++) {
+        const ProfileFrame* frame = &g_profiler.frames[f % PROFILER_MAX_FRAMES];
+        fprintf(file, ",\n{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                      "\"args\":{\"index\":%llu}}",
+                PROFILER_MAX_THREADS, (f64)(frame->start_ns - origin) * 1e-3,
+                (f64)(frame->end_ns - frame->start_ns) * 1e-3, (unsigned long long)frame->index);
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
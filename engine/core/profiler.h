@@ -0,0 +1,64 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "types.h"
+
+/* CPU frame profiler. Markers record nested begin/end pairs into a ring
+ * buffer owned by the calling thread, so recording takes no locks. The
+ * last window_frames frames can be written out as Chrome trace JSON, which
+ * chrome://tracing and ui.perfetto.dev both open.
+ *
+ * Markers compile to nothing unless ENGINE_PROFILE is defined; CMake
+ * defines it for every configuration except Release. */
+
+/* Events each thread keeps before the oldest are overwritten */
+#define PROFILER_EVENTS_PER_THREAD 65536
+#define PROFILER_MAX_THREADS 64
+#define PROFILER_MAX_DEPTH 64
+
+/* Main thread only. Markers on other threads see the profiler switch on
+ * and off atomically, but shutdown frees every thread's ring, so it must
+ * run after all other threads that record (the render thread, job
+ * workers) have stopped; engine_destroy stops them first. */
+void profiler_init(u32 window_frames);
+void profiler_shutdown(void);
+
+/* name must outlive the profiler; string literals are the intended use */
+void profiler_begin(const char* name);
+void profiler_end(void);
+
+/* Label the calling thread in the trace */
+void profiler_set_thread_name(const char* name);
+
+/* Add an already-timed event to the "GPU" track, in timer_now_ns time.
+ * Only the thread holding the GL context may call it; used by the GPU
+ * profiler. */
+void profiler_record_gpu(const char* name, u64 start_ns, u64 end_ns);
+
+/* Frame boundaries, called by the engine on the main thread.
+ * frame_end writes a trace if one was requested or, when budget_ms > 0,
+ * if the frame took longer than that. */
+void profiler_frame_begin(void);
+void profiler_frame_end(f32 budget_ms);
+
+/* Dump at the end of the current frame */
+void profiler_request_dump(void);
+
+/* Write the current window now, on the main thread. Other threads keep
+ * recording meanwhile: each ring is read only up to its atomically
+ * published count, leaving out its oldest 1024 slots, which the writer
+ * may be reusing. A thread that records more than that during the dump
+ * can put a torn event in the trace, but not crash it. */
+bool profiler_dump(const char* path);
+
+#ifdef ENGINE_PROFILE
+#define PROFILE_BEGIN(name)        profiler_begin(name)
+#define PROFILE_END()              profiler_end()
+#define PROFILE_THREAD_NAME(name)  profiler_set_thread_name(name)
+#else
+#define PROFILE_BEGIN(name)        ((void)0)
+#define PROFILE_END()              ((void)0)
+#define PROFILE_THREAD_NAME(name)  ((void)0)
+#endif
+
+#endif /* PROFILER_H */
@@ -0,0 +1,74 @@
+/* sched_yield under strict -std=c11 */
+#if !defined(_WIN32) && !defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "thread.h"
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_main(LPVOID arg) {
+    Thread* thread = (Thread*)arg;
+    thread->func(thread->data);
+    return 0;
+}
+
+bool thread_start(Thread* thread, ThreadFunc func, void* data) {
+    thread->func = func;
+    thread->data = data;
+    thread->handle = CreateThread(NULL, 0, thread_main, thread, 0, NULL);
+    return thread->handle != NULL;
+}
+
+void thread_join(Thread* thread) {
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+}
+
+void thread_yield(void) { SwitchToThread(); }
+
+void mutex_init(Mutex* mutex) { InitializeCriticalSection(mutex); }
+void mutex_destroy(Mutex* mutex) { DeleteCriticalSection(mutex); }
+void mutex_lock(Mutex* mutex) { EnterCriticalSection(mutex); }
+void mutex_unlock(Mutex* mutex) { LeaveCriticalSection(mutex); }
+
+void cond_init(Cond* cond) { InitializeConditionVariable(cond); }
+void cond_destroy(Cond* cond) { (void)cond; }
+void cond_wait(Cond* cond, Mutex* mutex) { SleepConditionVariableCS(cond, mutex, INFINITE); }
+void cond_signal(Cond* cond) { WakeConditionVariable(cond); }
+void cond_broadcast(Cond* cond) { WakeAllConditionVariable(cond); }
+
+#else
+
+#include <sched.h>
+
+static void* thread_main(void* arg) {
+    Thread* thread = (Thread*)arg;
+    thread->func(thread->data);
+    return NULL;
+}
+
+bool thread_start(Thread* thread, ThreadFunc func, void* data) {
+    thread->func = func;
+    thread->data = data;
+    return pthread_create(&thread->handle, NULL, thread_main, thread) == 0;
+}
+
+void thread_join(Thread* thread) {
+    pthread_join(thread->handle, NULL);
+}
+
+void thread_yield(void) { sched_yield(); }
+
+void mutex_init(Mutex* mutex) { pthread_mutex_init(mutex, NULL); }
+void mutex_destroy(Mutex* mutex) { pthread_mutex_destroy(mutex); }
+void mutex_lock(Mutex* mutex) { pthread_mutex_lock(mutex); }
+void mutex_unlock(Mutex* mutex) { pthread_mutex_unlock(mutex); }
+
+void cond_init(Cond* cond) { pthread_cond_init(cond, NULL); }
+void cond_destroy(Cond* cond) { pthread_cond_destroy(cond); }
+void cond_wait(Cond* cond, Mutex* mutex) { pthread_cond_wait(cond, mutex); }
+void cond_signal(Cond* cond) { pthread_cond_signal(cond); }
+void cond_broadcast(Cond* cond) { pthread_cond_broadcast(cond); }
+
+#endif
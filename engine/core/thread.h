@@ -0,0 +1,49 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#include "types.h"
+
+/* Thin wrappers over Win32 and pthreads threads, mutexes and condition
+ * variables, shared by the job system and the render thread. */
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+typedef HANDLE ThreadHandle;
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE Cond;
+#else
+#include <pthread.h>
+typedef pthread_t ThreadHandle;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Cond;
+#endif
+
+typedef void (*ThreadFunc)(void* data);
+
+/* The thread reads func and data from this struct when it starts, so it
+ * must stay at the same address until thread_join */
+typedef struct {
+    ThreadHandle handle;
+    ThreadFunc func;
+    void* data;
+} Thread;
+
+bool thread_start(Thread* thread, ThreadFunc func, void* data);
+void thread_join(Thread* thread);
+void thread_yield(void);
+
+void mutex_init(Mutex* mutex);
+void mutex_destroy(Mutex* mutex);
+void mutex_lock(Mutex* mutex);
+void mutex_unlock(Mutex* mutex);
+
+void cond_init(Cond* cond);
+void cond_destroy(Cond* cond);
+void cond_wait(Cond* cond, Mutex* mutex);
+void cond_signal(Cond* cond);
+void cond_broadcast(Cond* cond);
+
+#endif /* THREAD_H */
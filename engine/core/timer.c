@@ -0,0 +1,32 @@
+/* clock_gettime under strict -std=c11 */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "timer.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+u64 timer_now_ns(void) {
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    /* Split to avoid overflowing counter * 1e9 */
+    u64 seconds = (u64)(counter.QuadPart / frequency.QuadPart);
+    u64 remainder = (u64)(counter.QuadPart % frequency.QuadPart);
+    return seconds * 1000000000ull + remainder * 1000000000ull / (u64)frequency.QuadPart;
+}
+#else
+#include <time.h>
+
+u64 timer_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+#endif
@@ -0,0 +1,13 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "types.h"
+
+/* Monotonic high-resolution clock, independent of the window backend */
+u64 timer_now_ns(void);
+
+static inline f64 timer_now_seconds(void) {
+    return (f64)timer_now_ns() * 1e-9;
+}
+
+#endif /* TIMER_H */
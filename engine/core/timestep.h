@@ -0,0 +1,52 @@
+#ifndef TIMESTEP_H
+#define TIMESTEP_H
+
+#include "types.h"
+#include <math.h>
+
+/* Fixed-step accumulator: real frame time goes in, a whole number of
+ * simulation ticks comes out, plus the fraction of a tick left over for
+ * interpolating between the previous and current simulation states. */
+typedef struct {
+    f64 step;          /* Seconds per tick */
+    f64 accumulator;   /* Unsimulated time, always < step after advance */
+    u32 max_steps;     /* Catch-up limit per frame; excess time is dropped */
+    u32 pending_steps; /* Ticks to run this frame */
+    u64 tick;          /* Ticks handed out so far */
+} FixedTimestep;
+
+static inline void fixed_timestep_init(FixedTimestep* ts, f32 tick_rate, u32 max_steps) {
+    ts->step = tick_rate > 0.0f ? 1.0 / (f64)tick_rate : 1.0 / 60.0;
+    ts->accumulator = 0.0;
+    ts->max_steps = max_steps > 0 ? max_steps : 1;
+    ts->pending_steps = 0;
+    ts->tick = 0;
+}
+
+/* Add a frame's worth of real time; returns the ticks to simulate */
+static inline u32 fixed_timestep_advance(FixedTimestep* ts, f64 frame_time) {
+    if (frame_time < 0.0) frame_time = 0.0;
+    ts->accumulator += frame_time;
+
+    u32 steps = (u32)(ts->accumulator / ts->step);
+    if (steps > ts->max_steps) {
+        /* A hitch: run the catch-up limit and forget the rest so one long
+         * frame can't snowball into ever longer ones */
+        steps = ts->max_steps;
+        ts->accumulator = fmod(ts->accumulator, ts->step);
+    } else {
+        ts->accumulator -= steps * ts->step;
+    }
+
+    ts->pending_steps = steps;
+    ts->tick += steps;
+    return steps;
+}
+
+/* Blend factor between the previous (0) and current (1) simulation state */
+static inline f32 fixed_timestep_alpha(const FixedTimestep* ts) {
+    f64 alpha = ts->accumulator / ts->step;
+    return (f32)(alpha < 0.0 ? 0.0 : (alpha > 1.0 ? 1.0 : alpha));
+}
+
+#endif /* TIMESTEP_H */
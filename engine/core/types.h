@@ -16,6 +16,13 @@ typedef int64_t  i64;
 typedef float    f32;
 typedef double   f64;
 
+/* Thread-local storage qualifier */
+#if defined(_MSC_VER)
+#define ENGINE_THREAD_LOCAL __declspec(thread)
+#else
+#define ENGINE_THREAD_LOCAL _Thread_local
+#endif
+
 /* Color structure */
 typedef struct {
     f32 r, g, b, a;
@@ -31,11 +38,16 @@ static inline Color color_create(f32 r, f32 g, f32 b, f32 a) {
 #define COLOR_GREEN  (Color){0.0f, 1.0f, 0.0f, 1.0f}
 #define COLOR_BLUE   (Color){0.0f, 0.0f, 1.0f, 1.0f}
 
-/* Handle types for resources */
-typedef u32 MeshHandle;
-typedef u32 TextureHandle;
-typedef u32 ShaderHandle;
-
-#define INVALID_HANDLE ((u32)-1)
+/* Handle types for resources: generational ids into the owning module's
+ * pool (see handle_pool.h). Wrapped in structs so one kind can't be passed
+ * as another; id 0 is the null handle, so zero-initialized handles are
+ * empty. */
+typedef struct { u32 id; } MeshHandle;
+typedef struct { u32 id; } TextureHandle;
+typedef struct { u32 id; } ShaderHandle;
+typedef struct { u32 id; } CameraHandle;
+
+#define INVALID_HANDLE 0u
+#define HANDLE_IS_VALID(handle) ((handle).id != INVALID_HANDLE)
 
 #endif /* ENGINE_TYPES_H */
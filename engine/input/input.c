@@ -45,16 +45,17 @@ void input_process_mouse_button(InputState* state, i32 button, i32 action) {
     }
 }
 
+/* Deltas and scroll add up over the frame; input_update clears them */
 void input_process_mouse_move(InputState* state, f64 x, f64 y) {
-    state->mouse_delta_x = x - state->mouse_x;
-    state->mouse_delta_y = y - state->mouse_y;
+    state->mouse_delta_x += x - state->mouse_x;
+    state->mouse_delta_y += y - state->mouse_y;
     state->mouse_x = x;
     state->mouse_y = y;
 }
 
 void input_process_scroll(InputState* state, f64 x, f64 y) {
-    state->scroll_x = x;
-    state->scroll_y = y;
+    state->scroll_x += x;
+    state->scroll_y += y;
 }
 
 bool input_key_down(const InputState* state, KeyCode key) {
@@ -0,0 +1,92 @@
+#include "input_events.h"
+#include <stdio.h>
+#include <string.h>
+
+#define INPUT_EVENT_MASK (INPUT_EVENT_QUEUE_SIZE - 1)
+
+void input_event_queue_init(InputEventQueue* queue) {
+    memset(queue, 0, sizeof(InputEventQueue));
+}
+
+void input_event_push(InputEventQueue* queue, const InputEvent* event) {
+    if (input_event_queue_count(queue) == INPUT_EVENT_QUEUE_SIZE) {
+        /* Keep the older timestamp: latency is measured from the first
+         * motion the merged event stands for */
+        InputEvent* newest = &queue->events[(queue->tail - 1) & INPUT_EVENT_MASK];
+        if (event->type == INPUT_EVENT_MOUSE_MOVE && newest->type == INPUT_EVENT_MOUSE_MOVE) {
+            newest->x = event->x;
+            newest->y = event->y;
+            return;
+        }
+        if (queue->dropped++ == 0) {
+            fprintf(stderr, "Input event queue full; dropping events\n");
+        }
+        return;
+    }
+
+    queue->events[queue->tail & INPUT_EVENT_MASK] = *event;
+    queue->tail++;
+}
+
+static void apply_event(const InputEvent* event, InputState* state) {
+    switch (event->type) {
+        case INPUT_EVENT_KEY:
+            input_process_key(state, event->code, event->action);
+            break;
+        case INPUT_EVENT_MOUSE_BUTTON:
+            input_process_mouse_button(state, event->code, event->action);
+            break;
+        case INPUT_EVENT_MOUSE_MOVE:
+            input_process_mouse_move(state, event->x, event->y);
+            break;
+        case INPUT_EVENT_MOUSE_WARP:
+            state->mouse_x = event->x;
+            state->mouse_y = event->y;
+            break;
+        case INPUT_EVENT_SCROLL:
+            input_process_scroll(state, event->x, event->y);
+            break;
+    }
+}
+
+/* A latch only shows cursor motion early; keys and buttons wait for the
+ * frame that applies them */
+static bool is_motion(const InputEvent* event) {
+    return event->type == INPUT_EVENT_MOUSE_MOVE || event->type == INPUT_EVENT_MOUSE_WARP;
+}
+
+void input_events_apply(InputEventQueue* queue, InputState* state, InputEventTimes* times) {
+    /* latched is always in [head, tail] */
+    for (; queue->head != queue->tail; queue->head++) {
+        const InputEvent* event = &queue->events[queue->head & INPUT_EVENT_MASK];
+        bool latched = (i32)(queue->latched - queue->head) > 0;
+        if (!latched || !is_motion(event)) {
+            input_event_times_add(times, event->time_ns);
+        }
+        apply_event(event, state);
+    }
+    queue->latched = queue->tail;
+}
+
+void input_events_latch_mouse_delta(InputEventQueue* queue, const InputState* state,
+                                    f64* dx, f64* dy, InputEventTimes* times) {
+    /* Same sum input_process_mouse_move will make when these are applied */
+    f64 x = state->mouse_x;
+    f64 y = state->mouse_y;
+    *dx = 0.0;
+    *dy = 0.0;
+    for (u32 i = queue->head; i != queue->tail; i++) {
+        const InputEvent* event = &queue->events[i & INPUT_EVENT_MASK];
+        if (!is_motion(event)) continue;
+        if (event->type == INPUT_EVENT_MOUSE_MOVE) {
+            *dx += event->x - x;
+            *dy += event->y - y;
+            if ((i32)(i - queue->latched) >= 0) {
+                input_event_times_add(times, event->time_ns);
+            }
+        }
+        x = event->x;
+        y = event->y;
+    }
+    queue->latched = queue->tail;
+}
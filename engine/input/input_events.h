@@ -0,0 +1,85 @@
+#ifndef INPUT_EVENTS_H
+#define INPUT_EVENTS_H
+
+#include "../core/types.h"
+#include "input.h"
+
+/* Timestamped queue between the window callbacks and InputState. Callbacks
+ * only append; the engine applies everything queued once per frame, so
+ * several cursor or scroll events in one poll all add to the frame's
+ * deltas. A late latch can look at the mouse motion queued since then
+ * without consuming it, and the timestamps give the age of each frame's
+ * input when it is presented. */
+
+#define INPUT_EVENT_QUEUE_SIZE 1024   /* Power of two */
+
+typedef enum {
+    INPUT_EVENT_KEY,
+    INPUT_EVENT_MOUSE_BUTTON,
+    INPUT_EVENT_MOUSE_MOVE,
+    INPUT_EVENT_MOUSE_WARP,   /* Cursor jumped (capture changed): position without a delta */
+    INPUT_EVENT_SCROLL
+} InputEventType;
+
+typedef struct {
+    u64 time_ns;              /* timer_now_ns when the event arrived */
+    InputEventType type;
+    i32 code;                 /* Key or button */
+    i32 action;               /* GLFW values: 1 = press, 0 = release */
+    f64 x;                    /* Cursor position or scroll offset */
+    f64 y;
+} InputEvent;
+
+/* Arrival times of the events a frame reflects for the first time */
+typedef struct {
+    u32 count;
+    u64 first_ns;
+    u64 offset_sum_ns;        /* Sum of time_ns - first_ns, which cannot overflow */
+} InputEventTimes;
+
+typedef struct {
+    InputEvent events[INPUT_EVENT_QUEUE_SIZE];
+    u32 head;                 /* Next event to apply; counters wrap, indices are masked */
+    u32 tail;                 /* Next free entry */
+    u32 latched;              /* Motion before this was already shown by a late latch */
+    u32 dropped;
+} InputEventQueue;
+
+void input_event_queue_init(InputEventQueue* queue);
+
+/* Append an event. When full, cursor motion merges into a queued move
+ * (positions are absolute, so no motion is lost); anything else is
+ * dropped and counted. */
+void input_event_push(InputEventQueue* queue, const InputEvent* event);
+
+static inline u32 input_event_queue_count(const InputEventQueue* queue) {
+    return queue->tail - queue->head;
+}
+
+/* Apply and remove every queued event in arrival order, adding the times
+ * of events a late latch has not already shown */
+void input_events_apply(InputEventQueue* queue, InputState* state, InputEventTimes* times);
+
+/* Cursor motion queued since state was last updated, leaving the queue as
+ * it is; the times of moves not seen by an earlier latch are added */
+void input_events_latch_mouse_delta(InputEventQueue* queue, const InputState* state,
+                                    f64* dx, f64* dy, InputEventTimes* times);
+
+static inline void input_event_times_reset(InputEventTimes* times) {
+    times->count = 0;
+    times->first_ns = 0;
+    times->offset_sum_ns = 0;
+}
+
+static inline void input_event_times_add(InputEventTimes* times, u64 time_ns) {
+    if (times->count == 0) times->first_ns = time_ns;
+    times->offset_sum_ns += time_ns - times->first_ns;
+    times->count++;
+}
+
+/* Mean arrival time; 0 when there were no events */
+static inline u64 input_event_times_mean(const InputEventTimes* times) {
+    return times->count ? times->first_ns + times->offset_sum_ns / times->count : 0;
+}
+
+#endif /* INPUT_EVENTS_H */
@@ -0,0 +1,245 @@
+#include "input_record.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INPUT_RECORD_MAGIC 0x31504E49u  /* "INP1" */
+#define INPUT_RECORD_VERSION 1
+
+/* Frame flags: which sections follow */
+#define FRAME_HAS_KEYS    0x01
+#define FRAME_HAS_BUTTONS 0x02
+#define FRAME_HAS_MOUSE   0x04
+#define FRAME_HAS_SCROLL  0x08
+#define FRAME_HAS_DT      0x10
+
+/* Key and button entries pack the code with its down/pressed/released bits */
+#define KEY_CODE_BITS 9
+#define BUTTON_CODE_BITS 3
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    f32 fixed_tick_rate;
+    u32 max_catchup_steps;
+} InputRecordHeader;
+
+struct InputRecorder {
+    FILE* file;
+    InputState previous;
+    f64 previous_dt;
+    u64 frame_count;
+};
+
+struct InputReplay {
+    FILE* file;
+    InputRecordHeader header;
+    InputState state;
+    f64 dt;
+    u64 frame_count;
+};
+
+static u32 pack_flags(bool down, bool pressed, bool released, u32 shift) {
+    return ((u32)down << shift) | ((u32)pressed << (shift + 1)) | ((u32)released << (shift + 2));
+}
+
+InputRecorder* input_recorder_create(const char* path, f32 fixed_tick_rate, u32 max_catchup_steps) {
+    InputRecorder* recorder = (InputRecorder*)calloc(1, sizeof(InputRecorder));
+    if (!recorder) return NULL;
+
+    recorder->file = fopen(path, "wb");
+    if (!recorder->file) {
+        fprintf(stderr, "Failed to open input recording: %s\n", path);
+        free(recorder);
+        return NULL;
+    }
+
+    InputRecordHeader header = { INPUT_RECORD_MAGIC, INPUT_RECORD_VERSION,
+                                 fixed_tick_rate, max_catchup_steps };
+    fwrite(&header, sizeof(header), 1, recorder->file);
+    input_init(&recorder->previous);
+    recorder->previous_dt = -1.0;
+    return recorder;
+}
+
+void input_recorder_destroy(InputRecorder* recorder) {
+    if (!recorder) return;
+    fclose(recorder->file);
+    free(recorder);
+}
+
+void input_recorder_write_frame(InputRecorder* recorder, const InputState* state, f64 delta_time) {
+    const InputState* previous = &recorder->previous;
+    u16 keys[KEY_MAX];
+    u16 key_count = 0;
+    u8 buttons[MOUSE_BUTTON_MAX];
+    u8 button_count = 0;
+
+    for (u32 k = 0; k < KEY_MAX; k++) {
+        if (state->keys[k] != previous->keys[k] || state->keys_pressed[k] || state->keys_released[k]) {
+            keys[key_count++] = (u16)(k | pack_flags(state->keys[k], state->keys_pressed[k],
+                                                     state->keys_released[k], KEY_CODE_BITS));
+        }
+    }
+    for (u32 b = 0; b < MOUSE_BUTTON_MAX; b++) {
+        if (state->mouse_buttons[b] != previous->mouse_buttons[b] ||
+            state->mouse_buttons_pressed[b] || state->mouse_buttons_released[b]) {
+            buttons[button_count++] = (u8)(b | pack_flags(state->mouse_buttons[b],
+                                                          state->mouse_buttons_pressed[b],
+                                                          state->mouse_buttons_released[b],
+                                                          BUTTON_CODE_BITS));
+        }
+    }
+
+    bool mouse = state->mouse_x != previous->mouse_x || state->mouse_y != previous->mouse_y ||
+                 state->mouse_delta_x != 0.0 || state->mouse_delta_y != 0.0;
+    bool scroll = state->scroll_x != 0.0 || state->scroll_y != 0.0;
+    bool dt = delta_time != recorder->previous_dt;
+
+    u8 flags = (key_count ? FRAME_HAS_KEYS : 0) | (button_count ? FRAME_HAS_BUTTONS : 0) |
+               (mouse ? FRAME_HAS_MOUSE : 0) | (scroll ? FRAME_HAS_SCROLL : 0) |
+               (dt ? FRAME_HAS_DT : 0);
+
+    FILE* file = recorder->file;
+    fwrite(&flags, sizeof(flags), 1, file);
+    if (key_count) {
+        fwrite(&key_count, sizeof(key_count), 1, file);
+        fwrite(keys, sizeof(u16), key_count, file);
+    }
+    if (button_count) {
+        fwrite(&button_count, sizeof(button_count), 1, file);
+        fwrite(buttons, sizeof(u8), button_count, file);
+    }
+    if (mouse) {
+        f64 values[4] = { state->mouse_x, state->mouse_y, state->mouse_delta_x, state->mouse_delta_y };
+        fwrite(values, sizeof(f64), 4, file);
+    }
+    if (scroll) {
+        f64 values[2] = { state->scroll_x, state->scroll_y };
+        fwrite(values, sizeof(f64), 2, file);
+    }
+    if (dt) {
+        fwrite(&delta_time, sizeof(delta_time), 1, file);
+    }
+
+    recorder->previous = *state;
+    recorder->previous_dt = delta_time;
+    recorder->frame_count++;
+}
+
+u64 input_recorder_frame_count(const InputRecorder* recorder) {
+    return recorder->frame_count;
+}
+
+InputReplay* input_replay_open(const char* path) {
+    InputReplay* replay = (InputReplay*)calloc(1, sizeof(InputReplay));
+    if (!replay) return NULL;
+
+    replay->file = fopen(path, "rb");
+    if (!replay->file) {
+        fprintf(stderr, "Failed to open input recording: %s\n", path);
+        free(replay);
+        return NULL;
+    }
+
+    if (fread(&replay->header, sizeof(replay->header), 1, replay->file) != 1 ||
+        replay->header.magic != INPUT_RECORD_MAGIC ||
+        replay->header.version != INPUT_RECORD_VERSION) {
+        fprintf(stderr, "Not an input recording: %s\n", path);
+        fclose(replay->file);
+        free(replay);
+        return NULL;
+    }
+
+    input_init(&replay->state);
+    replay->dt = 0.0;
+    return replay;
+}
+
+void input_replay_close(InputReplay* replay) {
+    if (!replay) return;
+    fclose(replay->file);
+    free(replay);
+}
+
+f32 input_replay_tick_rate(const InputReplay* replay) {
+    return replay->header.fixed_tick_rate;
+}
+
+u32 input_replay_max_catchup_steps(const InputReplay* replay) {
+    return replay->header.max_catchup_steps;
+}
+
+bool input_replay_next_frame(InputReplay* replay, InputState* state, f64* delta_time) {
+    FILE* file = replay->file;
+    InputState* current = &replay->state;
+
+    /* Per-frame fields start cleared, as after input_update */
+    input_update(current);
+
+    u8 flags;
+    bool ok = fread(&flags, sizeof(flags), 1, file) == 1;
+    if (ok && (flags & FRAME_HAS_KEYS)) {
+        u16 count = 0;
+        u16 keys[KEY_MAX];
+        ok = fread(&count, sizeof(count), 1, file) == 1 && count <= KEY_MAX &&
+             fread(keys, sizeof(u16), count, file) == count;
+        for (u32 i = 0; ok && i < count; i++) {
+            u32 k = keys[i] & ((1u << KEY_CODE_BITS) - 1);
+            if (k >= KEY_MAX) continue;
+            current->keys[k] = (keys[i] >> KEY_CODE_BITS) & 1;
+            current->keys_pressed[k] = (keys[i] >> (KEY_CODE_BITS + 1)) & 1;
+            current->keys_released[k] = (keys[i] >> (KEY_CODE_BITS + 2)) & 1;
+        }
+    }
+    if (ok && (flags & FRAME_HAS_BUTTONS)) {
+        u8 count = 0;
+        u8 buttons[256];
+        ok = fread(&count, sizeof(count), 1, file) == 1 &&
+             fread(buttons, sizeof(u8), count, file) == count;
+        for (u32 i = 0; ok && i < count; i++) {
+            u32 b = buttons[i] & ((1u << BUTTON_CODE_BITS) - 1);
+            current->mouse_buttons[b] = (buttons[i] >> BUTTON_CODE_BITS) & 1;
+            current->mouse_buttons_pressed[b] = (buttons[i] >> (BUTTON_CODE_BITS + 1)) & 1;
+            current->mouse_buttons_released[b] = (buttons[i] >> (BUTTON_CODE_BITS + 2)) & 1;
+        }
+    }
+    if (ok && (flags & FRAME_HAS_MOUSE)) {
+        f64 values[4];
+        ok = fread(values, sizeof(f64), 4, file) == 4;
+        if (ok) {
+            current->mouse_x = values[0];
+            current->mouse_y = values[1];
+            current->mouse_delta_x = values[2];
+            current->mouse_delta_y = values[3];
+        }
+    }
+    if (ok && (flags & FRAME_HAS_SCROLL)) {
+        f64 values[2];
+        ok = fread(values, sizeof(f64), 2, file) == 2;
+        if (ok) {
+            current->scroll_x = values[0];
+            current->scroll_y = values[1];
+        }
+    }
+    if (ok && (flags & FRAME_HAS_DT)) {
+        ok = fread(&replay->dt, sizeof(replay->dt), 1, file) == 1;
+    }
+
+    if (!ok) {
+        /* End of the recording, or a frame cut off mid-write */
+        input_update(current);
+        *state = *current;
+        *delta_time = 0.0;
+        return false;
+    }
+
+    *state = *current;
+    *delta_time = replay->dt;
+    replay->frame_count++;
+    return true;
+}
+
+u64 input_replay_frame_count(const InputReplay* replay) {
+    return replay->frame_count;
+}
@@ -0,0 +1,41 @@
+#ifndef INPUT_RECORD_H
+#define INPUT_RECORD_H
+
+#include "../core/types.h"
+#include "input.h"
+
+/* Recording and replay of per-frame input. Each frame stores what changed
+ * in its InputState since the previous frame (keys and buttons whose state
+ * changed or that were pressed/released, mouse position and delta, scroll)
+ * plus the frame's delta time, which is written only when it differs from
+ * the last one. The file also keeps the fixed-step settings, so a replay
+ * produces the same ticks and the same simulation as the recorded session.
+ *
+ * Files are in native byte order and meant for the machine or build farm
+ * that made them. */
+
+typedef struct InputRecorder InputRecorder;
+typedef struct InputReplay InputReplay;
+
+InputRecorder* input_recorder_create(const char* path, f32 fixed_tick_rate, u32 max_catchup_steps);
+
+/* Closes the file; a recording cut short by a crash still replays up to
+ * the last whole frame */
+void input_recorder_destroy(InputRecorder* recorder);
+
+void input_recorder_write_frame(InputRecorder* recorder, const InputState* state, f64 delta_time);
+u64 input_recorder_frame_count(const InputRecorder* recorder);
+
+InputReplay* input_replay_open(const char* path);
+void input_replay_close(InputReplay* replay);
+
+/* Timestep settings the recording was made with */
+f32 input_replay_tick_rate(const InputReplay* replay);
+u32 input_replay_max_catchup_steps(const InputReplay* replay);
+
+/* Overwrite state with the next recorded frame; false once the recording
+ * is exhausted (state is then left as an idle frame) */
+bool input_replay_next_frame(InputReplay* replay, InputState* state, f64* delta_time);
+u64 input_replay_frame_count(const InputReplay* replay);
+
+#endif /* INPUT_RECORD_H */
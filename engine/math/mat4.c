@@ -0,0 +1,106 @@
+#include "mat4.h"
+
+void mat4_multiply_batch(Mat4* out, const Mat4* lhs, const Mat4* rhs, u32 count) {
+#if defined(ENGINE_SIMD_AVX)
+    /* Two result columns per 256-bit register: each lhs column is broadcast
+     * to both lanes and multiplied by the per-lane splat of the rhs column. */
+    __m256 a0 = _mm256_broadcast_ps((const __m128*)&lhs->m[0]);
+    __m256 a1 = _mm256_broadcast_ps((const __m128*)&lhs->m[4]);
+    __m256 a2 = _mm256_broadcast_ps((const __m128*)&lhs->m[8]);
+    __m256 a3 = _mm256_broadcast_ps((const __m128*)&lhs->m[12]);
+
+    for (u32 i = 0; i < count; i++) {
+        for (int half = 0; half < 2; half++) {
+            __m256 b = _mm256_loadu_ps(&rhs[i].m[half * 8]);
+#if defined(ENGINE_SIMD_FMA)
+            __m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(b, b, 0x00));
+            r = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(b, b, 0x55), r);
+            r = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(b, b, 0xAA), r);
+            r = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(b, b, 0xFF), r);
+#else
+            __m256 r = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(a0, _mm256_shuffle_ps(b, b, 0x00)),
+                              _mm256_mul_ps(a1, _mm256_shuffle_ps(b, b, 0x55))),
+                _mm256_add_ps(_mm256_mul_ps(a2, _mm256_shuffle_ps(b, b, 0xAA)),
+                              _mm256_mul_ps(a3, _mm256_shuffle_ps(b, b, 0xFF))));
+#endif
+            _mm256_storeu_ps(&out[i].m[half * 8], r);
+        }
+    }
+#elif defined(ENGINE_SIMD_SSE)
+    __m128 a0 = _mm_load_ps(&lhs->m[0]);
+    __m128 a1 = _mm_load_ps(&lhs->m[4]);
+    __m128 a2 = _mm_load_ps(&lhs->m[8]);
+    __m128 a3 = _mm_load_ps(&lhs->m[12]);
+
+    for (u32 i = 0; i < count; i++) {
+        for (int c = 0; c < 4; c++) {
+            __m128 b = _mm_load_ps(&rhs[i].m[c * 4]);
+            __m128 r = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a0, _mm_shuffle_ps(b, b, 0x00)),
+                           _mm_mul_ps(a1, _mm_shuffle_ps(b, b, 0x55))),
+                _mm_add_ps(_mm_mul_ps(a2, _mm_shuffle_ps(b, b, 0xAA)),
+                           _mm_mul_ps(a3, _mm_shuffle_ps(b, b, 0xFF))));
+            _mm_store_ps(&out[i].m[c * 4], r);
+        }
+    }
+#else
+    for (u32 i = 0; i < count; i++) {
+        out[i] = mat4_multiply_scalar(*lhs, rhs[i]);
+    }
+#endif
+}
+
+void mat4_transform_points(Vec3* out, const Mat4* m, const Vec3* points, u32 count) {
+    u32 i = 0;
+
+#if defined(ENGINE_SIMD_SSE)
+    /* Four points per iteration: deinterleave xyz into SoA registers,
+     * transform, and interleave back. */
+    const float* e = m->m;
+    __m128 m0 = _mm_set1_ps(e[0]),  m1 = _mm_set1_ps(e[1]),  m2 = _mm_set1_ps(e[2]),  m3 = _mm_set1_ps(e[3]);
+    __m128 m4 = _mm_set1_ps(e[4]),  m5 = _mm_set1_ps(e[5]),  m6 = _mm_set1_ps(e[6]),  m7 = _mm_set1_ps(e[7]);
+    __m128 m8 = _mm_set1_ps(e[8]),  m9 = _mm_set1_ps(e[9]),  m10 = _mm_set1_ps(e[10]), m11 = _mm_set1_ps(e[11]);
+    __m128 m12 = _mm_set1_ps(e[12]), m13 = _mm_set1_ps(e[13]), m14 = _mm_set1_ps(e[14]), m15 = _mm_set1_ps(e[15]);
+
+    for (; i + 4 <= count; i += 4) {
+        const float* src = &points[i].x;
+        __m128 v0 = _mm_loadu_ps(src);     /* x0 y0 z0 x1 */
+        __m128 v1 = _mm_loadu_ps(src + 4); /* y1 z1 x2 y2 */
+        __m128 v2 = _mm_loadu_ps(src + 8); /* z2 x3 y3 z3 */
+
+        __m128 t = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(2, 1, 3, 2)); /* x2 y2 x3 y3 */
+        __m128 u = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 0, 2, 1)); /* y0 z0 y1 z1 */
+        __m128 x = _mm_shuffle_ps(v0, t, _MM_SHUFFLE(2, 0, 3, 0));
+        __m128 y = _mm_shuffle_ps(u, t, _MM_SHUFFLE(3, 1, 2, 0));
+        __m128 z = _mm_shuffle_ps(u, v2, _MM_SHUFFLE(3, 0, 3, 1));
+
+        __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)), _mm_add_ps(_mm_mul_ps(m8, z), m12));
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)), _mm_add_ps(_mm_mul_ps(m9, z), m13));
+        __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, x), _mm_mul_ps(m6, y)), _mm_add_ps(_mm_mul_ps(m10, z), m14));
+        __m128 rw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m3, x), _mm_mul_ps(m7, y)), _mm_add_ps(_mm_mul_ps(m11, z), m15));
+
+        __m128 inv_w = _mm_div_ps(_mm_set1_ps(1.0f), rw);
+        rx = _mm_mul_ps(rx, inv_w);
+        ry = _mm_mul_ps(ry, inv_w);
+        rz = _mm_mul_ps(rz, inv_w);
+
+        __m128 xy_lo = _mm_unpacklo_ps(rx, ry);                          /* x0 y0 x1 y1 */
+        __m128 xy_hi = _mm_unpackhi_ps(rx, ry);                          /* x2 y2 x3 y3 */
+        __m128 zx_lo = _mm_shuffle_ps(rz, rx, _MM_SHUFFLE(1, 1, 0, 0));  /* z0 z0 x1 x1 */
+        __m128 yz_mid = _mm_shuffle_ps(ry, rz, _MM_SHUFFLE(1, 1, 1, 1)); /* y1 y1 z1 z1 */
+        __m128 zx_hi = _mm_shuffle_ps(rz, rx, _MM_SHUFFLE(3, 3, 2, 2));  /* z2 z2 x3 x3 */
+        __m128 yz_hi = _mm_shuffle_ps(ry, rz, _MM_SHUFFLE(3, 3, 3, 3));  /* y3 y3 z3 z3 */
+
+        float* dst = &out[i].x;
+        _mm_storeu_ps(dst,     _mm_shuffle_ps(xy_lo, zx_lo, _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(dst + 4, _mm_shuffle_ps(yz_mid, xy_hi, _MM_SHUFFLE(1, 0, 2, 0)));
+        _mm_storeu_ps(dst + 8, _mm_shuffle_ps(zx_hi, yz_hi, _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+#endif
+
+    /* Remainder (or everything on scalar builds) */
+    for (; i < count; i++) {
+        out[i] = mat4_transform_point(*m, points[i]);
+    }
+}
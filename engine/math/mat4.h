@@ -2,10 +2,13 @@
 #define MAT4_H
 
 #include "vec3.h"
+#include "simd.h"
+#include "../core/types.h"
+#include <stdbool.h>
 #include <string.h>
 
 typedef struct {
-    float m[16]; /* Column-major order for OpenGL */
+    ENGINE_ALIGN(16) float m[16]; /* Column-major order for OpenGL */
 } Mat4;
 
 static inline Mat4 mat4_identity(void) {
@@ -17,7 +20,8 @@ static inline Mat4 mat4_identity(void) {
     return result;
 }
 
-static inline Mat4 mat4_multiply(Mat4 a, Mat4 b) {
+/* Portable reference implementation, used when no SIMD path is available */
+static inline Mat4 mat4_multiply_scalar(Mat4 a, Mat4 b) {
     Mat4 result = {0};
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
@@ -31,6 +35,180 @@ static inline Mat4 mat4_multiply(Mat4 a, Mat4 b) {
     return result;
 }
 
+/* out = a * b. Operands are aligned and passed by pointer; out may alias a or b. */
+static inline void mat4_mul(Mat4* out, const Mat4* a, const Mat4* b) {
+#if defined(ENGINE_SIMD_SSE)
+    __m128 a0 = _mm_load_ps(&a->m[0]);
+    __m128 a1 = _mm_load_ps(&a->m[4]);
+    __m128 a2 = _mm_load_ps(&a->m[8]);
+    __m128 a3 = _mm_load_ps(&a->m[12]);
+    __m128 r[4];
+    for (int i = 0; i < 4; i++) {
+        const float* bc = &b->m[i * 4];
+        r[i] = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(bc[0])), _mm_mul_ps(a1, _mm_set1_ps(bc[1]))),
+            _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(bc[2])), _mm_mul_ps(a3, _mm_set1_ps(bc[3]))));
+    }
+    _mm_store_ps(&out->m[0], r[0]);
+    _mm_store_ps(&out->m[4], r[1]);
+    _mm_store_ps(&out->m[8], r[2]);
+    _mm_store_ps(&out->m[12], r[3]);
+#else
+    *out = mat4_multiply_scalar(*a, *b);
+#endif
+}
+
+static inline Mat4 mat4_multiply(Mat4 a, Mat4 b) {
+    Mat4 result;
+    mat4_mul(&result, &a, &b);
+    return result;
+}
+
+static inline Mat4 mat4_transpose(Mat4 m) {
+    Mat4 result;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            result.m[i * 4 + j] = m.m[j * 4 + i];
+        }
+    }
+    return result;
+}
+
+/* Portable general inverse (cofactor expansion). Returns false if singular. */
+static inline bool mat4_invert_scalar(Mat4* out, const Mat4* in) {
+    const float* m = in->m;
+    float inv[16];
+    
+    inv[0]  =  m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] +
+               m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+    inv[4]  = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] -
+               m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+    inv[8]  =  m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] +
+               m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+    inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] -
+               m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+    inv[1]  = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] -
+               m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+    inv[5]  =  m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] +
+               m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+    inv[9]  = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] -
+               m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+    inv[13] =  m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] +
+               m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+    inv[2]  =  m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] +
+               m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+    inv[6]  = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] -
+               m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+    inv[10] =  m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] +
+               m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+    inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] -
+               m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+    inv[3]  = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] -
+               m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+    inv[7]  =  m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] +
+               m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+    inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] -
+               m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+    inv[15] =  m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] +
+               m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+    
+    float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+    if (det == 0.0f) return false;
+    
+    float inv_det = 1.0f / det;
+    for (int i = 0; i < 16; i++) {
+        out->m[i] = inv[i] * inv_det;
+    }
+    return true;
+}
+
+#if defined(ENGINE_SIMD_SSE)
+/* 2x2 block helpers for the SSE inverse. A 2x2 block is stored as
+ * (a00, a01, a10, a11) in one register. */
+#define MAT4_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define MAT4_SWIZZLE(v, x, y, z, w) MAT4_SHUFFLE(v, v, x, y, z, w)
+
+/* A * B */
+static inline __m128 mat2_mul(__m128 a, __m128 b) {
+    return _mm_add_ps(_mm_mul_ps(a, MAT4_SWIZZLE(b, 0, 3, 0, 3)),
+                      _mm_mul_ps(MAT4_SWIZZLE(a, 1, 0, 3, 2), MAT4_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+/* adj(A) * B */
+static inline __m128 mat2_adj_mul(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(MAT4_SWIZZLE(a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(MAT4_SWIZZLE(a, 1, 1, 2, 2), MAT4_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+/* A * adj(B) */
+static inline __m128 mat2_mul_adj(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(a, MAT4_SWIZZLE(b, 3, 0, 3, 0)),
+                      _mm_mul_ps(MAT4_SWIZZLE(a, 1, 0, 3, 2), MAT4_SWIZZLE(b, 2, 1, 2, 1)));
+}
+#endif
+
+/* General inverse. Uses the 2x2 block method on SSE targets; since
+ * inverse(transpose(M)) == transpose(inverse(M)) the same code serves the
+ * column-major layout. Returns false (and leaves out untouched) if singular. */
+static inline bool mat4_invert(Mat4* out, const Mat4* in) {
+#if defined(ENGINE_SIMD_SSE)
+    __m128 c0 = _mm_load_ps(&in->m[0]);
+    __m128 c1 = _mm_load_ps(&in->m[4]);
+    __m128 c2 = _mm_load_ps(&in->m[8]);
+    __m128 c3 = _mm_load_ps(&in->m[12]);
+    
+    /* Sub-blocks */
+    __m128 A = _mm_movelh_ps(c0, c1);
+    __m128 B = _mm_movehl_ps(c1, c0);
+    __m128 C = _mm_movelh_ps(c2, c3);
+    __m128 D = _mm_movehl_ps(c3, c2);
+    
+    /* Determinants of each block as (|A| |B| |C| |D|) */
+    __m128 det_sub = _mm_sub_ps(
+        _mm_mul_ps(MAT4_SHUFFLE(c0, c2, 0, 2, 0, 2), MAT4_SHUFFLE(c1, c3, 1, 3, 1, 3)),
+        _mm_mul_ps(MAT4_SHUFFLE(c0, c2, 1, 3, 1, 3), MAT4_SHUFFLE(c1, c3, 0, 2, 0, 2)));
+    __m128 det_a = MAT4_SWIZZLE(det_sub, 0, 0, 0, 0);
+    __m128 det_b = MAT4_SWIZZLE(det_sub, 1, 1, 1, 1);
+    __m128 det_c = MAT4_SWIZZLE(det_sub, 2, 2, 2, 2);
+    __m128 det_d = MAT4_SWIZZLE(det_sub, 3, 3, 3, 3);
+    
+    __m128 d_c = mat2_adj_mul(D, C);
+    __m128 a_b = mat2_adj_mul(A, B);
+    __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, A), mat2_mul(B, d_c));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, D), mat2_mul(C, a_b));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, C), mat2_mul_adj(D, a_b));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, B), mat2_mul_adj(A, d_c));
+    
+    /* |M| = |A||D| + |B||C| - tr((A#B)(D#C)) */
+    __m128 tr = _mm_mul_ps(a_b, MAT4_SWIZZLE(d_c, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, MAT4_SWIZZLE(tr, 1, 0, 3, 2));
+    tr = _mm_add_ps(tr, MAT4_SWIZZLE(tr, 2, 3, 0, 1));
+    __m128 det_m = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), tr);
+    if (_mm_cvtss_f32(det_m) == 0.0f) return false;
+    
+    __m128 r_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det_m);
+    x = _mm_mul_ps(x, r_det);
+    y = _mm_mul_ps(y, r_det);
+    z = _mm_mul_ps(z, r_det);
+    w = _mm_mul_ps(w, r_det);
+    
+    _mm_store_ps(&out->m[0], MAT4_SHUFFLE(x, y, 3, 1, 3, 1));
+    _mm_store_ps(&out->m[4], MAT4_SHUFFLE(x, y, 2, 0, 2, 0));
+    _mm_store_ps(&out->m[8], MAT4_SHUFFLE(z, w, 3, 1, 3, 1));
+    _mm_store_ps(&out->m[12], MAT4_SHUFFLE(z, w, 2, 0, 2, 0));
+    return true;
+#else
+    return mat4_invert_scalar(out, in);
+#endif
+}
+
+/* Inverse by value; returns identity for a singular matrix */
+static inline Mat4 mat4_inverse(Mat4 m) {
+    Mat4 result = mat4_identity();
+    mat4_invert(&result, &m);
+    return result;
+}
+
 static inline Mat4 mat4_translate(Vec3 v) {
     Mat4 result = mat4_identity();
     result.m[12] = v.x;
@@ -129,4 +307,13 @@ static inline Vec3 mat4_transform_direction(Mat4 m, Vec3 v) {
     };
 }
 
+/* Batched transforms (mat4.c) */
+
+/* out[i] = lhs * rhs[i], e.g. view-projection times N model matrices.
+ * out must not alias rhs. */
+void mat4_multiply_batch(Mat4* out, const Mat4* lhs, const Mat4* rhs, u32 count);
+
+/* out[i] = m * points[i] with perspective divide. out may alias points. */
+void mat4_transform_points(Vec3* out, const Mat4* m, const Vec3* points, u32 count);
+
 #endif /* MAT4_H */
@@ -0,0 +1,115 @@
+#ifndef QUAT_H
+#define QUAT_H
+
+#include "vec3.h"
+#include "mat4.h"
+
+typedef struct {
+    float x, y, z, w;
+} Quat;
+
+static inline Quat quat_identity(void) {
+    return (Quat){0.0f, 0.0f, 0.0f, 1.0f};
+}
+
+/* Rotation of angle radians about a unit axis */
+static inline Quat quat_from_axis_angle(Vec3 axis, float angle) {
+    float s = sinf(angle * 0.5f);
+    return (Quat){axis.x * s, axis.y * s, axis.z * s, cosf(angle * 0.5f)};
+}
+
+/* Same rotation as mat4_rotate_y(angle) */
+static inline Quat quat_rotate_y(float angle) {
+    return (Quat){0.0f, sinf(angle * 0.5f), 0.0f, cosf(angle * 0.5f)};
+}
+
+/* a * b applies b first, then a */
+static inline Quat quat_multiply(Quat a, Quat b) {
+    return (Quat){
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+    };
+}
+
+static inline Quat quat_conjugate(Quat q) {
+    return (Quat){-q.x, -q.y, -q.z, q.w};
+}
+
+static inline float quat_dot(Quat a, Quat b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+static inline Quat quat_normalize(Quat q) {
+    float len = sqrtf(quat_dot(q, q));
+    if (len > 0.0001f) {
+        float inv = 1.0f / len;
+        return (Quat){q.x * inv, q.y * inv, q.z * inv, q.w * inv};
+    }
+    return quat_identity();
+}
+
+/* Rotate v by unit quaternion q (15 mul + 15 add, no matrix) */
+static inline Vec3 quat_rotate_vec3(Quat q, Vec3 v) {
+    Vec3 u = vec3_create(q.x, q.y, q.z);
+    Vec3 t = vec3_scale(vec3_cross(u, v), 2.0f);
+    return vec3_add(vec3_add(v, vec3_scale(t, q.w)), vec3_cross(u, t));
+}
+
+/* Normalized linear interpolation along the shortest arc */
+static inline Quat quat_nlerp(Quat a, Quat b, float t) {
+    float sign = quat_dot(a, b) < 0.0f ? -1.0f : 1.0f;
+    float wa = 1.0f - t;
+    float wb = t * sign;
+    return quat_normalize((Quat){
+        a.x * wa + b.x * wb,
+        a.y * wa + b.y * wb,
+        a.z * wa + b.z * wb,
+        a.w * wa + b.w * wb
+    });
+}
+
+/* Spherical interpolation along the shortest arc; falls back to nlerp
+ * when the quaternions are nearly parallel */
+static inline Quat quat_slerp(Quat a, Quat b, float t) {
+    float cos_theta = quat_dot(a, b);
+    if (cos_theta < 0.0f) {
+        b = (Quat){-b.x, -b.y, -b.z, -b.w};
+        cos_theta = -cos_theta;
+    }
+    if (cos_theta > 0.9995f) {
+        return quat_nlerp(a, b, t);
+    }
+
+    float theta = acosf(cos_theta);
+    float inv_sin = 1.0f / sinf(theta);
+    float wa = sinf((1.0f - t) * theta) * inv_sin;
+    float wb = sinf(t * theta) * inv_sin;
+    return (Quat){
+        a.x * wa + b.x * wb,
+        a.y * wa + b.y * wb,
+        a.z * wa + b.z * wb,
+        a.w * wa + b.w * wb
+    };
+}
+
+static inline Mat4 quat_to_mat4(Quat q) {
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    Mat4 result = mat4_identity();
+    result.m[0] = 1.0f - 2.0f * (yy + zz);
+    result.m[1] = 2.0f * (xy + wz);
+    result.m[2] = 2.0f * (xz - wy);
+    result.m[4] = 2.0f * (xy - wz);
+    result.m[5] = 1.0f - 2.0f * (xx + zz);
+    result.m[6] = 2.0f * (yz + wx);
+    result.m[8] = 2.0f * (xz + wy);
+    result.m[9] = 2.0f * (yz - wx);
+    result.m[10] = 1.0f - 2.0f * (xx + yy);
+    return result;
+}
+
+#endif /* QUAT_H */
@@ -0,0 +1,34 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+/* SIMD feature selection for the math library.
+ * ENGINE_SIMD_AVX is set when the compiler targets AVX (see the
+ * ENGINE_ENABLE_AVX2 CMake option), ENGINE_SIMD_SSE on any x86 target with
+ * SSE2. Define ENGINE_FORCE_SCALAR to build the portable fallback only. */
+
+#if !defined(ENGINE_FORCE_SCALAR)
+    #if defined(__AVX__)
+        #define ENGINE_SIMD_AVX 1
+    #endif
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define ENGINE_SIMD_SSE 1
+    #endif
+    #if defined(__FMA__)
+        #define ENGINE_SIMD_FMA 1
+    #endif
+#endif
+
+#if defined(ENGINE_SIMD_AVX)
+    #include <immintrin.h>
+#elif defined(ENGINE_SIMD_SSE)
+    #include <emmintrin.h>
+#endif
+
+/* Alignment for SIMD-friendly structs */
+#if defined(_MSC_VER) && !defined(__clang__)
+    #define ENGINE_ALIGN(n) __declspec(align(n))
+#else
+    #define ENGINE_ALIGN(n) _Alignas(n)
+#endif
+
+#endif /* SIMD_H */
@@ -0,0 +1,124 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "vec3.h"
+#include "mat4.h"
+#include "quat.h"
+
+/* Compact affine transform: scale, then rotate, then translate.
+ * Compose and inverse are exact for uniform scale; with non-uniform scale
+ * they ignore the shear a full matrix product would produce. */
+typedef struct {
+    Quat rotation;
+    Vec3 translation;
+    Vec3 scale;
+} Transform;
+
+/* 3x3 matrix, column-major (GLSL mat3) */
+typedef struct {
+    float m[9];
+} Mat3;
+
+/* Upper three rows of an affine matrix, row-major: 48 bytes instead of 64.
+ * Uploaded as a GLSL mat3x4 and applied as `vec4(p, 1.0) * model`. */
+typedef struct {
+    ENGINE_ALIGN(16) float m[12];
+} Mat3x4;
+
+static inline Transform transform_identity(void) {
+    return (Transform){quat_identity(), vec3_create(0.0f, 0.0f, 0.0f), vec3_create(1.0f, 1.0f, 1.0f)};
+}
+
+static inline Transform transform_create(Vec3 translation, Quat rotation, Vec3 scale) {
+    return (Transform){rotation, translation, scale};
+}
+
+static inline Vec3 transform_point(const Transform* t, Vec3 p) {
+    Vec3 scaled = vec3_create(p.x * t->scale.x, p.y * t->scale.y, p.z * t->scale.z);
+    return vec3_add(quat_rotate_vec3(t->rotation, scaled), t->translation);
+}
+
+static inline Vec3 transform_direction(const Transform* t, Vec3 d) {
+    Vec3 scaled = vec3_create(d.x * t->scale.x, d.y * t->scale.y, d.z * t->scale.z);
+    return quat_rotate_vec3(t->rotation, scaled);
+}
+
+/* parent * child: applies child first */
+static inline Transform transform_compose(const Transform* parent, const Transform* child) {
+    Transform result;
+    result.rotation = quat_multiply(parent->rotation, child->rotation);
+    result.translation = transform_point(parent, child->translation);
+    result.scale = vec3_create(parent->scale.x * child->scale.x,
+                               parent->scale.y * child->scale.y,
+                               parent->scale.z * child->scale.z);
+    return result;
+}
+
+static inline Transform transform_inverse(const Transform* t) {
+    Transform result;
+    result.rotation = quat_conjugate(t->rotation);
+    result.scale = vec3_create(1.0f / t->scale.x, 1.0f / t->scale.y, 1.0f / t->scale.z);
+    Vec3 r = quat_rotate_vec3(result.rotation, vec3_negate(t->translation));
+    result.translation = vec3_create(r.x * result.scale.x, r.y * result.scale.y, r.z * result.scale.z);
+    return result;
+}
+
+/* Interpolate: lerp translation and scale, slerp rotation */
+static inline Transform transform_interpolate(const Transform* a, const Transform* b, float t) {
+    Transform result;
+    result.rotation = quat_slerp(a->rotation, b->rotation, t);
+    result.translation = vec3_lerp(a->translation, b->translation, t);
+    result.scale = vec3_lerp(a->scale, b->scale, t);
+    return result;
+}
+
+static inline Mat4 transform_to_mat4(const Transform* t) {
+    Mat4 result = quat_to_mat4(t->rotation);
+    for (int i = 0; i < 3; i++) {
+        result.m[i] *= t->scale.x;
+        result.m[4 + i] *= t->scale.y;
+        result.m[8 + i] *= t->scale.z;
+    }
+    result.m[12] = t->translation.x;
+    result.m[13] = t->translation.y;
+    result.m[14] = t->translation.z;
+    return result;
+}
+
+static inline Mat3x4 transform_to_mat3x4(const Transform* t) {
+    Mat4 m = transform_to_mat4(t);
+    Mat3x4 result;
+    for (int row = 0; row < 3; row++) {
+        result.m[row * 4 + 0] = m.m[row];
+        result.m[row * 4 + 1] = m.m[4 + row];
+        result.m[row * 4 + 2] = m.m[8 + row];
+        result.m[row * 4 + 3] = m.m[12 + row];
+    }
+    return result;
+}
+
+/* inverse-transpose of the upper 3x3, which for R * S is just R * S^-1.
+ * Computed once per object on the CPU instead of per vertex on the GPU. */
+static inline Mat3 transform_normal_matrix(const Transform* t) {
+    Mat4 r = quat_to_mat4(t->rotation);
+    float inv_scale[3] = {1.0f / t->scale.x, 1.0f / t->scale.y, 1.0f / t->scale.z};
+    Mat3 result;
+    for (int col = 0; col < 3; col++) {
+        for (int row = 0; row < 3; row++) {
+            result.m[col * 3 + row] = r.m[col * 4 + row] * inv_scale[col];
+        }
+    }
+    return result;
+}
+
+static inline Mat3 mat3_identity(void) {
+    return (Mat3){{1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f}};
+}
+
+static inline Mat3x4 mat3x4_identity(void) {
+    return (Mat3x4){{1.0f, 0.0f, 0.0f, 0.0f,
+                     0.0f, 1.0f, 0.0f, 0.0f,
+                     0.0f, 0.0f, 1.0f, 0.0f}};
+}
+
+#endif /* TRANSFORM_H */
@@ -0,0 +1,180 @@
+#include "vec3_stream.h"
+#include "simd.h"
+#include <stdlib.h>
+
+/* Lane abstraction so each kernel is written once for AVX, SSE and scalar */
+#if defined(ENGINE_SIMD_AVX)
+    #define LANES 8
+    typedef __m256 vf;
+    #define vf_load(p)       _mm256_loadu_ps(p)
+    #define vf_store(p, v)   _mm256_storeu_ps(p, v)
+    #define vf_set1(s)       _mm256_set1_ps(s)
+    #define vf_add(a, b)     _mm256_add_ps(a, b)
+    #define vf_sub(a, b)     _mm256_sub_ps(a, b)
+    #define vf_mul(a, b)     _mm256_mul_ps(a, b)
+    #define vf_div(a, b)     _mm256_div_ps(a, b)
+    #define vf_sqrt(a)       _mm256_sqrt_ps(a)
+    #define vf_gt(a, b)      _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+    #define vf_select(m, a, b) _mm256_blendv_ps(b, a, m)
+#elif defined(ENGINE_SIMD_SSE)
+    #define LANES 4
+    typedef __m128 vf;
+    #define vf_load(p)       _mm_loadu_ps(p)
+    #define vf_store(p, v)   _mm_storeu_ps(p, v)
+    #define vf_set1(s)       _mm_set1_ps(s)
+    #define vf_add(a, b)     _mm_add_ps(a, b)
+    #define vf_sub(a, b)     _mm_sub_ps(a, b)
+    #define vf_mul(a, b)     _mm_mul_ps(a, b)
+    #define vf_div(a, b)     _mm_div_ps(a, b)
+    #define vf_sqrt(a)       _mm_sqrt_ps(a)
+    #define vf_gt(a, b)      _mm_cmpgt_ps(a, b)
+    #define vf_select(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#endif
+
+/* Same threshold as vec3_normalize */
+#define NORMALIZE_EPSILON 0.0001f
+
+bool vec3_stream_init(Vec3Stream* stream, u32 capacity) {
+    stream->x = NULL;
+    stream->y = NULL;
+    stream->z = NULL;
+    stream->count = 0;
+    stream->capacity = 0;
+    return vec3_stream_reserve(stream, capacity);
+}
+
+void vec3_stream_free(Vec3Stream* stream) {
+    if (!stream) return;
+    free(stream->x);
+    stream->x = NULL;
+    stream->y = NULL;
+    stream->z = NULL;
+    stream->count = 0;
+    stream->capacity = 0;
+}
+
+bool vec3_stream_reserve(Vec3Stream* stream, u32 capacity) {
+    if (capacity <= stream->capacity) return true;
+
+    /* One block holding the three component arrays back to back */
+    f32* block = (f32*)malloc((size_t)capacity * 3 * sizeof(f32));
+    if (!block) return false;
+
+    for (u32 i = 0; i < stream->count; i++) {
+        block[i] = stream->x[i];
+        block[capacity + i] = stream->y[i];
+        block[capacity * 2 + i] = stream->z[i];
+    }
+
+    free(stream->x);
+    stream->x = block;
+    stream->y = block + capacity;
+    stream->z = block + capacity * 2;
+    stream->capacity = capacity;
+    return true;
+}
+
+void vec3_stream_length(f32* out, const Vec3Stream* v) {
+    u32 i = 0;
+#ifdef LANES
+    for (; i + LANES <= v->count; i += LANES) {
+        vf x = vf_load(v->x + i), y = vf_load(v->y + i), z = vf_load(v->z + i);
+        vf len_sq = vf_add(vf_add(vf_mul(x, x), vf_mul(y, y)), vf_mul(z, z));
+        vf_store(out + i, vf_sqrt(len_sq));
+    }
+#endif
+    for (; i < v->count; i++) {
+        out[i] = sqrtf(v->x[i] * v->x[i] + v->y[i] * v->y[i] + v->z[i] * v->z[i]);
+    }
+}
+
+void vec3_stream_dot(f32* out, const Vec3Stream* a, const Vec3Stream* b) {
+    u32 i = 0;
+#ifdef LANES
+    for (; i + LANES <= a->count; i += LANES) {
+        vf d = vf_add(vf_add(vf_mul(vf_load(a->x + i), vf_load(b->x + i)),
+                             vf_mul(vf_load(a->y + i), vf_load(b->y + i))),
+                      vf_mul(vf_load(a->z + i), vf_load(b->z + i)));
+        vf_store(out + i, d);
+    }
+#endif
+    for (; i < a->count; i++) {
+        out[i] = a->x[i] * b->x[i] + a->y[i] * b->y[i] + a->z[i] * b->z[i];
+    }
+}
+
+void vec3_stream_distance_to_point(f32* out, const Vec3Stream* v, Vec3 point) {
+    u32 i = 0;
+#ifdef LANES
+    vf px = vf_set1(point.x), py = vf_set1(point.y), pz = vf_set1(point.z);
+    for (; i + LANES <= v->count; i += LANES) {
+        vf dx = vf_sub(vf_load(v->x + i), px);
+        vf dy = vf_sub(vf_load(v->y + i), py);
+        vf dz = vf_sub(vf_load(v->z + i), pz);
+        vf len_sq = vf_add(vf_add(vf_mul(dx, dx), vf_mul(dy, dy)), vf_mul(dz, dz));
+        vf_store(out + i, vf_sqrt(len_sq));
+    }
+#endif
+    for (; i < v->count; i++) {
+        f32 dx = v->x[i] - point.x;
+        f32 dy = v->y[i] - point.y;
+        f32 dz = v->z[i] - point.z;
+        out[i] = sqrtf(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+void vec3_stream_normalize(Vec3Stream* out, const Vec3Stream* v) {
+    u32 i = 0;
+#ifdef LANES
+    vf eps = vf_set1(NORMALIZE_EPSILON);
+    vf one = vf_set1(1.0f);
+    for (; i + LANES <= v->count; i += LANES) {
+        vf x = vf_load(v->x + i), y = vf_load(v->y + i), z = vf_load(v->z + i);
+        vf len = vf_sqrt(vf_add(vf_add(vf_mul(x, x), vf_mul(y, y)), vf_mul(z, z)));
+        /* Near-zero vectors pass through unchanged, like vec3_normalize */
+        vf scale = vf_select(vf_gt(len, eps), vf_div(one, len), one);
+        vf_store(out->x + i, vf_mul(x, scale));
+        vf_store(out->y + i, vf_mul(y, scale));
+        vf_store(out->z + i, vf_mul(z, scale));
+    }
+#endif
+    for (; i < v->count; i++) {
+        Vec3 n = vec3_normalize(vec3_stream_get(v, i));
+        vec3_stream_set(out, i, n);
+    }
+    out->count = v->count;
+}
+
+void vec3_stream_lerp(Vec3Stream* out, const Vec3Stream* a, const Vec3Stream* b, f32 t) {
+    u32 i = 0;
+#ifdef LANES
+    vf wa = vf_set1(1.0f - t), wb = vf_set1(t);
+    for (; i + LANES <= a->count; i += LANES) {
+        vf_store(out->x + i, vf_add(vf_mul(vf_load(a->x + i), wa), vf_mul(vf_load(b->x + i), wb)));
+        vf_store(out->y + i, vf_add(vf_mul(vf_load(a->y + i), wa), vf_mul(vf_load(b->y + i), wb)));
+        vf_store(out->z + i, vf_add(vf_mul(vf_load(a->z + i), wa), vf_mul(vf_load(b->z + i), wb)));
+    }
+#endif
+    for (; i < a->count; i++) {
+        vec3_stream_set(out, i, vec3_lerp(vec3_stream_get(a, i), vec3_stream_get(b, i), t));
+    }
+    out->count = a->count;
+}
+
+void vec3_stream_scaled_add(Vec3Stream* out, const Vec3Stream* a, const Vec3Stream* b, f32 scale) {
+    u32 i = 0;
+#ifdef LANES
+    vf s = vf_set1(scale);
+    for (; i + LANES <= a->count; i += LANES) {
+        vf_store(out->x + i, vf_add(vf_load(a->x + i), vf_mul(vf_load(b->x + i), s)));
+        vf_store(out->y + i, vf_add(vf_load(a->y + i), vf_mul(vf_load(b->y + i), s)));
+        vf_store(out->z + i, vf_add(vf_load(a->z + i), vf_mul(vf_load(b->z + i), s)));
+    }
+#endif
+    for (; i < a->count; i++) {
+        out->x[i] = a->x[i] + b->x[i] * scale;
+        out->y[i] = a->y[i] + b->y[i] * scale;
+        out->z[i] = a->z[i] + b->z[i] * scale;
+    }
+    out->count = a->count;
+}
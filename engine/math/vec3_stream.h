@@ -0,0 +1,44 @@
+#ifndef VEC3_STREAM_H
+#define VEC3_STREAM_H
+
+#include "vec3.h"
+#include "../core/types.h"
+#include <stdbool.h>
+
+/* Structure-of-arrays companion to Vec3 for bulk math over many entities.
+ * All operations process [0, count) of their input stream and set the
+ * output count; outputs may alias inputs. */
+typedef struct {
+    f32* x;
+    f32* y;
+    f32* z;
+    u32 count;
+    u32 capacity;
+} Vec3Stream;
+
+/* Storage */
+bool vec3_stream_init(Vec3Stream* stream, u32 capacity);
+void vec3_stream_free(Vec3Stream* stream);
+bool vec3_stream_reserve(Vec3Stream* stream, u32 capacity);
+
+static inline void vec3_stream_set(Vec3Stream* stream, u32 index, Vec3 v) {
+    stream->x[index] = v.x;
+    stream->y[index] = v.y;
+    stream->z[index] = v.z;
+}
+
+static inline Vec3 vec3_stream_get(const Vec3Stream* stream, u32 index) {
+    return (Vec3){stream->x[index], stream->y[index], stream->z[index]};
+}
+
+/* Scalar results: out[i] */
+void vec3_stream_length(f32* out, const Vec3Stream* v);
+void vec3_stream_dot(f32* out, const Vec3Stream* a, const Vec3Stream* b);
+void vec3_stream_distance_to_point(f32* out, const Vec3Stream* v, Vec3 point);
+
+/* Vector results: out[i] (out needs capacity >= input count) */
+void vec3_stream_normalize(Vec3Stream* out, const Vec3Stream* v);
+void vec3_stream_lerp(Vec3Stream* out, const Vec3Stream* a, const Vec3Stream* b, f32 t);
+void vec3_stream_scaled_add(Vec3Stream* out, const Vec3Stream* a, const Vec3Stream* b, f32 scale);
+
+#endif /* VEC3_STREAM_H */
@@ -1,5 +1,8 @@
 #include "camera.h"
+#include "../core/handle_pool.h"
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #ifndef M_PI
@@ -12,9 +15,18 @@ static const f32 DEFAULT_FOV = 45.0f;
 static const f32 DEFAULT_SPEED = 5.0f;
 static const f32 DEFAULT_SENSITIVITY = 0.1f;
 
-Camera* camera_create(Vec3 position, f32 yaw, f32 pitch) {
-    Camera* camera = (Camera*)malloc(sizeof(Camera));
-    if (!camera) return NULL;
+static HandlePool g_cameras;
+static bool g_cameras_ready = false;
+
+CameraHandle camera_create(Vec3 position, f32 yaw, f32 pitch) {
+    CameraHandle handle = {INVALID_HANDLE};
+    if (!g_cameras_ready) {
+        g_cameras_ready = handle_pool_init(&g_cameras, sizeof(Camera), 4, "Camera");
+        if (!g_cameras_ready) return handle;
+    }
+    
+    Camera* camera = (Camera*)handle_pool_alloc(&g_cameras, &handle.id);
+    if (!camera) return handle;
     
     camera->position = position;
     camera->world_up = vec3_create(0.0f, 1.0f, 0.0f);
@@ -26,14 +38,31 @@ Camera* camera_create(Vec3 position, f32 yaw, f32 pitch) {
     camera->far_plane = 1000.0f;
     camera->move_speed = DEFAULT_SPEED;
     camera->mouse_sensitivity = DEFAULT_SENSITIVITY;
+    camera->cache_valid = false;
     
     camera_update_vectors(camera);
     
-    return camera;
+    return handle;
+}
+
+void camera_destroy(CameraHandle handle) {
+    if (!g_cameras_ready || !HANDLE_IS_VALID(handle)) return;
+    handle_pool_release(&g_cameras, handle.id);
 }
 
-void camera_destroy(Camera* camera) {
-    free(camera);
+Camera* camera_get(CameraHandle handle) {
+    return g_cameras_ready ? (Camera*)handle_pool_get(&g_cameras, handle.id) : NULL;
+}
+
+void camera_shutdown(void) {
+    if (!g_cameras_ready) return;
+    
+    u32 leaked = handle_pool_count(&g_cameras);
+    if (leaked > 0) {
+        fprintf(stderr, "%u camera(s) still alive at shutdown\n", leaked);
+    }
+    handle_pool_free(&g_cameras);
+    g_cameras_ready = false;
 }
 
 void camera_update_vectors(Camera* camera) {
@@ -60,6 +89,41 @@ Mat4 camera_get_projection_matrix(const Camera* camera) {
     return mat4_perspective(fov_rad, camera->aspect_ratio, camera->near_plane, camera->far_plane);
 }
 
+/* Fields are written directly by game code, so change detection compares
+ * the current inputs against the ones the cache was built from */
+static void camera_refresh_cache(Camera* camera) {
+    CameraCacheKey key = {
+        .position = camera->position,
+        .front = camera->front,
+        .up = camera->up,
+        .fov = camera->fov,
+        .aspect_ratio = camera->aspect_ratio,
+        .near_plane = camera->near_plane,
+        .far_plane = camera->far_plane
+    };
+    
+    if (camera->cache_valid && memcmp(&key, &camera->cache_key, sizeof(key)) == 0) {
+        return;
+    }
+    
+    Mat4 view = camera_get_view_matrix(camera);
+    Mat4 projection = camera_get_projection_matrix(camera);
+    mat4_mul(&camera->view_projection, &projection, &view);
+    frustum_extract(&camera->frustum, &camera->view_projection);
+    camera->cache_key = key;
+    camera->cache_valid = true;
+}
+
+const Mat4* camera_get_view_projection(Camera* camera) {
+    camera_refresh_cache(camera);
+    return &camera->view_projection;
+}
+
+const Frustum* camera_get_frustum(Camera* camera) {
+    camera_refresh_cache(camera);
+    return &camera->frustum;
+}
+
 void camera_process_mouse(Camera* camera, f32 xoffset, f32 yoffset, bool constrain_pitch) {
     xoffset *= camera->mouse_sensitivity;
     yoffset *= camera->mouse_sensitivity;
@@ -4,6 +4,18 @@
 #include "../core/types.h"
 #include "../math/vec3.h"
 #include "../math/mat4.h"
+#include "culling.h"
+
+/* Inputs the cached matrices and frustum were built from */
+typedef struct {
+    Vec3 position;
+    Vec3 front;
+    Vec3 up;
+    f32 fov;
+    f32 aspect_ratio;
+    f32 near_plane;
+    f32 far_plane;
+} CameraCacheKey;
 
 /* Camera structure */
 typedef struct {
@@ -20,16 +32,33 @@ typedef struct {
     f32 far_plane;
     f32 move_speed;
     f32 mouse_sensitivity;
+    /* Cached view-projection and frustum, rebuilt lazily when the key changes */
+    CameraCacheKey cache_key;
+    bool cache_valid;
+    Mat4 view_projection;
+    Frustum frustum;
 } Camera;
 
-/* Camera creation and initialization */
-Camera* camera_create(Vec3 position, f32 yaw, f32 pitch);
-void camera_destroy(Camera* camera);
+/* Cameras live in a pool owned by this module and are referred to by
+ * handle */
+CameraHandle camera_create(Vec3 position, f32 yaw, f32 pitch);
+void camera_destroy(CameraHandle camera);
+
+/* NULL once the camera is destroyed; good until the next create or destroy */
+Camera* camera_get(CameraHandle camera);
+
+/* Free the pool, reporting cameras still alive */
+void camera_shutdown(void);
 
 /* Camera matrix getters */
 Mat4 camera_get_view_matrix(const Camera* camera);
 Mat4 camera_get_projection_matrix(const Camera* camera);
 
+/* Cached view-projection and frustum; only recomputed when the camera moved,
+ * rotated or changed its projection since the last call */
+const Mat4* camera_get_view_projection(Camera* camera);
+const Frustum* camera_get_frustum(Camera* camera);
+
 /* Camera updates */
 void camera_update_vectors(Camera* camera);
 void camera_process_mouse(Camera* camera, f32 xoffset, f32 yoffset, bool constrain_pitch);
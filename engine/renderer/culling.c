@@ -0,0 +1,181 @@
+#include "culling.h"
+#include "../math/simd.h"
+
+static Plane plane_normalize(f32 a, f32 b, f32 c, f32 d) {
+    f32 len = sqrtf(a * a + b * b + c * c);
+    f32 inv = len > 0.0f ? 1.0f / len : 0.0f;
+    return (Plane){vec3_create(a * inv, b * inv, c * inv), d * inv};
+}
+
+void frustum_extract(Frustum* frustum, const Mat4* view_projection) {
+    /* Gribb/Hartmann: planes are sums/differences of the matrix rows.
+     * Row i of a column-major matrix is (m[i], m[4+i], m[8+i], m[12+i]). */
+    const f32* m = view_projection->m;
+    f32 r[4][4];
+    for (int i = 0; i < 4; i++) {
+        r[i][0] = m[i];
+        r[i][1] = m[4 + i];
+        r[i][2] = m[8 + i];
+        r[i][3] = m[12 + i];
+    }
+
+    for (int p = 0; p < 3; p++) {
+        /* left/bottom/near = row3 + rowN, right/top/far = row3 - rowN */
+        frustum->planes[p * 2] = plane_normalize(r[3][0] + r[p][0], r[3][1] + r[p][1],
+                                                 r[3][2] + r[p][2], r[3][3] + r[p][3]);
+        frustum->planes[p * 2 + 1] = plane_normalize(r[3][0] - r[p][0], r[3][1] - r[p][1],
+                                                     r[3][2] - r[p][2], r[3][3] - r[p][3]);
+    }
+}
+
+bool frustum_test_sphere(const Frustum* frustum, Vec3 center, f32 radius) {
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        const Plane* p = &frustum->planes[i];
+        if (vec3_dot(p->normal, center) + p->distance < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool frustum_test_aabb(const Frustum* frustum, Vec3 min, Vec3 max) {
+    Vec3 center = vec3_scale(vec3_add(min, max), 0.5f);
+    Vec3 extent = vec3_scale(vec3_sub(max, min), 0.5f);
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+        const Plane* p = &frustum->planes[i];
+        f32 r = fabsf(p->normal.x) * extent.x + fabsf(p->normal.y) * extent.y +
+                fabsf(p->normal.z) * extent.z;
+        if (vec3_dot(p->normal, center) + p->distance < -r) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Append the lanes set in mask without branching on each bit */
+static inline u32 append_visible(u32* out, u32 n, u32 base, u32 mask, u32 lanes) {
+    for (u32 j = 0; j < lanes; j++) {
+        out[n] = base + j;
+        n += (mask >> j) & 1u;
+    }
+    return n;
+}
+
+u32 cull_spheres(const Frustum* frustum, const Vec3Stream* centers, const f32* radii,
+                 u32* out_visible) {
+    u32 count = centers->count;
+    u32 visible = 0;
+    u32 i = 0;
+
+#if defined(ENGINE_SIMD_AVX)
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(centers->x + i);
+        __m256 y = _mm256_loadu_ps(centers->y + i);
+        __m256 z = _mm256_loadu_ps(centers->z + i);
+        __m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radii + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < FRUSTUM_PLANE_COUNT; p++) {
+            const Plane* pl = &frustum->planes[p];
+            __m256 d = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(pl->normal.x)),
+                              _mm256_mul_ps(y, _mm256_set1_ps(pl->normal.y))),
+                _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(pl->normal.z)),
+                              _mm256_set1_ps(pl->distance)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, neg_r, _CMP_GE_OQ));
+        }
+        visible = append_visible(out_visible, visible, i, (u32)_mm256_movemask_ps(inside), 8);
+    }
+#endif
+#if defined(ENGINE_SIMD_SSE)
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(centers->x + i);
+        __m128 y = _mm_loadu_ps(centers->y + i);
+        __m128 z = _mm_loadu_ps(centers->z + i);
+        __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radii + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < FRUSTUM_PLANE_COUNT; p++) {
+            const Plane* pl = &frustum->planes[p];
+            __m128 d = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(pl->normal.x)),
+                           _mm_mul_ps(y, _mm_set1_ps(pl->normal.y))),
+                _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(pl->normal.z)),
+                           _mm_set1_ps(pl->distance)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, neg_r));
+        }
+        visible = append_visible(out_visible, visible, i, (u32)_mm_movemask_ps(inside), 4);
+    }
+#endif
+    for (; i < count; i++) {
+        if (frustum_test_sphere(frustum, vec3_stream_get(centers, i), radii[i])) {
+            out_visible[visible++] = i;
+        }
+    }
+    return visible;
+}
+
+u32 cull_aabbs(const Frustum* frustum, const Vec3Stream* centers, const Vec3Stream* extents,
+               u32* out_visible) {
+    u32 count = centers->count;
+    u32 visible = 0;
+    u32 i = 0;
+
+#if defined(ENGINE_SIMD_AVX)
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(centers->x + i);
+        __m256 y = _mm256_loadu_ps(centers->y + i);
+        __m256 z = _mm256_loadu_ps(centers->z + i);
+        __m256 ex = _mm256_loadu_ps(extents->x + i);
+        __m256 ey = _mm256_loadu_ps(extents->y + i);
+        __m256 ez = _mm256_loadu_ps(extents->z + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < FRUSTUM_PLANE_COUNT; p++) {
+            const Plane* pl = &frustum->planes[p];
+            __m256 d = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(pl->normal.x)),
+                              _mm256_mul_ps(y, _mm256_set1_ps(pl->normal.y))),
+                _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(pl->normal.z)),
+                              _mm256_set1_ps(pl->distance)));
+            /* Projected half-size of the box onto the plane normal */
+            __m256 r = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(fabsf(pl->normal.x))),
+                              _mm256_mul_ps(ey, _mm256_set1_ps(fabsf(pl->normal.y)))),
+                _mm256_mul_ps(ez, _mm256_set1_ps(fabsf(pl->normal.z))));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        visible = append_visible(out_visible, visible, i, (u32)_mm256_movemask_ps(inside), 8);
+    }
+#endif
+#if defined(ENGINE_SIMD_SSE)
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(centers->x + i);
+        __m128 y = _mm_loadu_ps(centers->y + i);
+        __m128 z = _mm_loadu_ps(centers->z + i);
+        __m128 ex = _mm_loadu_ps(extents->x + i);
+        __m128 ey = _mm_loadu_ps(extents->y + i);
+        __m128 ez = _mm_loadu_ps(extents->z + i);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < FRUSTUM_PLANE_COUNT; p++) {
+            const Plane* pl = &frustum->planes[p];
+            __m128 d = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(pl->normal.x)),
+                           _mm_mul_ps(y, _mm_set1_ps(pl->normal.y))),
+                _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(pl->normal.z)),
+                           _mm_set1_ps(pl->distance)));
+            __m128 r = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(fabsf(pl->normal.x))),
+                           _mm_mul_ps(ey, _mm_set1_ps(fabsf(pl->normal.y)))),
+                _mm_mul_ps(ez, _mm_set1_ps(fabsf(pl->normal.z))));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+        }
+        visible = append_visible(out_visible, visible, i, (u32)_mm_movemask_ps(inside), 4);
+    }
+#endif
+    for (; i < count; i++) {
+        Vec3 c = vec3_stream_get(centers, i);
+        Vec3 e = vec3_stream_get(extents, i);
+        if (frustum_test_aabb(frustum, vec3_sub(c, e), vec3_add(c, e))) {
+            out_visible[visible++] = i;
+        }
+    }
+    return visible;
+}
@@ -0,0 +1,46 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include "../core/types.h"
+#include "../math/vec3.h"
+#include "../math/mat4.h"
+#include "../math/vec3_stream.h"
+
+/* Plane: dot(normal, p) + distance >= 0 on the inside */
+typedef struct {
+    Vec3 normal;
+    f32 distance;
+} Plane;
+
+typedef enum {
+    FRUSTUM_LEFT,
+    FRUSTUM_RIGHT,
+    FRUSTUM_BOTTOM,
+    FRUSTUM_TOP,
+    FRUSTUM_NEAR,
+    FRUSTUM_FAR,
+    FRUSTUM_PLANE_COUNT
+} FrustumPlane;
+
+typedef struct {
+    Plane planes[FRUSTUM_PLANE_COUNT];
+} Frustum;
+
+/* Extract normalized planes from an OpenGL view-projection matrix */
+void frustum_extract(Frustum* frustum, const Mat4* view_projection);
+
+/* Single-object tests */
+bool frustum_test_sphere(const Frustum* frustum, Vec3 center, f32 radius);
+bool frustum_test_aabb(const Frustum* frustum, Vec3 min, Vec3 max);
+
+/* Sphere radius that never passes, for keeping dead slots in the arrays */
+#define CULL_REJECT (-1e30f)
+
+/* Batched tests over SoA inputs. Indices of visible objects are written to
+ * out_visible (capacity >= count) in ascending order; returns how many. */
+u32 cull_spheres(const Frustum* frustum, const Vec3Stream* centers, const f32* radii,
+                 u32* out_visible);
+u32 cull_aabbs(const Frustum* frustum, const Vec3Stream* centers, const Vec3Stream* extents,
+               u32* out_visible);
+
+#endif /* CULLING_H */
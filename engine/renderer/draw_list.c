@@ -0,0 +1,393 @@
+#include "draw_list.h"
+#include "renderer.h"
+#include "gpu_profiler.h"
+#include "frame_uniforms.h"
+#include "../core/profiler.h"
+#include <glad/glad.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+bool draw_list_init(DrawList* list, u32 initial_capacity) {
+    memset(list, 0, sizeof(DrawList));
+    list->clear_color = color_create(0.0f, 0.0f, 0.0f, 1.0f);
+    list->view = mat4_identity();
+    list->projection = mat4_identity();
+    list->lod_bias = 1.0f;
+
+    if (initial_capacity == 0) initial_capacity = 64;
+    list->commands = (DrawCommand*)malloc(initial_capacity * sizeof(DrawCommand));
+    if (!list->commands) return false;
+    list->command_capacity = initial_capacity;
+    return true;
+}
+
+void draw_list_free(DrawList* list) {
+    free(list->commands);
+    list->commands = NULL;
+    list->command_count = 0;
+    list->command_capacity = 0;
+    free(list->batches);
+    list->batches = NULL;
+    list->batch_count = 0;
+    list->batch_capacity = 0;
+    free(list->instances);
+    list->instances = NULL;
+    list->instance_count = 0;
+    list->instance_capacity = 0;
+    free(list->sorted);
+    free(list->sort_scratch);
+    list->sorted = NULL;
+    list->sort_scratch = NULL;
+    list->sorted_capacity = 0;
+    list->is_sorted = false;
+}
+
+void draw_list_reset(DrawList* list) {
+    list->pass_count = 0;
+    list->command_count = 0;
+    list->batch_count = 0;
+    list->instance_count = 0;
+    list->input_time_ns = 0;
+    list->is_sorted = false;
+}
+
+void draw_list_set_camera(DrawList* list, const Mat4* view, const Mat4* projection, Vec3 position) {
+    list->view = *view;
+    list->projection = *projection;
+    list->view_position = position;
+}
+
+void draw_list_set_light(DrawList* list, Vec3 direction, Vec3 color) {
+    list->light_dir = direction;
+    list->light_color = color;
+}
+
+void draw_list_begin_pass(DrawList* list, const char* name) {
+    /* Past the limit, commands keep going into the last pass */
+    if (list->pass_count >= DRAW_LIST_MAX_PASSES) return;
+
+    DrawPass* pass = &list->passes[list->pass_count++];
+    pass->name = name;
+    pass->first_command = list->command_count;
+    pass->command_count = 0;
+    pass->first_batch = list->batch_count;
+    pass->batch_count = 0;
+}
+
+/* Grow an array to hold at least needed elements, doubling */
+static bool reserve(void** items, u32* capacity, u32 needed, size_t item_size) {
+    if (needed <= *capacity) return true;
+    u32 new_capacity = *capacity ? *capacity : 16;
+    while (new_capacity < needed) new_capacity *= 2;
+    void* new_items = realloc(*items, new_capacity * item_size);
+    if (!new_items) return false;
+    *items = new_items;
+    *capacity = new_capacity;
+    return true;
+}
+
+/* Color is the only per-object material state, so it is the material id */
+static u32 color_material(Color color) {
+    u32 bits[4];
+    memcpy(bits, &color, sizeof(bits));
+    u32 hash = 2166136261u;
+    for (u32 i = 0; i < 4; i++) {
+        hash = (hash ^ bits[i]) * 16777619u;
+    }
+    return hash ^ (hash >> 12) ^ (hash >> 24);
+}
+
+/* Variants of a shader get ids of their own, so each one's draws sort
+ * together; a clash with another shader only costs extra binds */
+static u32 shader_sort_id(ShaderHandle shader, u32 features) {
+    return shader.id ^ ((features * 2654435761u) >> 21);
+}
+
+void draw_list_add(DrawList* list, ShaderHandle shader, u32 features, MeshHandle mesh,
+                   const Mat3x4* model, const Mat3* normal_matrix, Color color) {
+    if (list->pass_count == 0 || !HANDLE_IS_VALID(mesh)) return;
+
+    if (!reserve((void**)&list->commands, &list->command_capacity, list->command_count + 1,
+                 sizeof(DrawCommand))) {
+        return;
+    }
+
+    /* Distance to the mesh's bounds center, placed by the model rows */
+    Vec3 center = vec3_create(0.0f, 0.0f, 0.0f);
+    const Mesh* resolved = mesh_get(mesh);
+    if (resolved) center = resolved->bounds_center;
+    const f32* m = model->m;
+    Vec3 world = vec3_create(m[0] * center.x + m[1] * center.y + m[2] * center.z + m[3],
+                             m[4] * center.x + m[5] * center.y + m[6] * center.z + m[7],
+                             m[8] * center.x + m[9] * center.y + m[10] * center.z + m[11]);
+    Vec3 offset = vec3_sub(world, list->view_position);
+
+    /* The radius grows with the model's largest axis scale */
+    u32 lod = 0;
+    if (resolved) {
+        f32 scale_sq = 0.0f;
+        for (u32 axis = 0; axis < 3; axis++) {
+            f32 length_sq = m[axis] * m[axis] + m[4 + axis] * m[4 + axis] + m[8 + axis] * m[8 + axis];
+            if (length_sq > scale_sq) scale_sq = length_sq;
+        }
+        lod = draw_list_select_lod(list, resolved, world, resolved->bounds_radius * sqrtf(scale_sq));
+    }
+
+    DrawCommand* command = &list->commands[list->command_count++];
+    command->shader = shader;
+    command->features = features;
+    command->mesh = mesh;
+    command->model = *model;
+    command->normal_matrix = *normal_matrix;
+    command->color = color;
+    command->lod = lod;
+    command->key = render_queue_key(shader_sort_id(shader, features), color_material(color),
+                                    mesh.id, vec3_dot(offset, offset), color.a < 1.0f);
+    list->passes[list->pass_count - 1].command_count++;
+    list->is_sorted = false;
+}
+
+MeshInstance* draw_list_add_instances(DrawList* list, ShaderHandle shader, u32 features,
+                                      MeshHandle mesh, u32 lod, u32 count) {
+    return draw_list_add_textured_instances(list, shader, features, mesh,
+                                            (TextureHandle){INVALID_HANDLE}, lod, count);
+}
+
+MeshInstance* draw_list_add_textured_instances(DrawList* list, ShaderHandle shader, u32 features,
+                                               MeshHandle mesh, TextureHandle texture, u32 lod,
+                                               u32 count) {
+    if (list->pass_count == 0 || count == 0 || !HANDLE_IS_VALID(mesh)) return NULL;
+
+    if (!reserve((void**)&list->batches, &list->batch_capacity, list->batch_count + 1,
+                 sizeof(DrawBatch)) ||
+        !reserve((void**)&list->instances, &list->instance_capacity, list->instance_count + count,
+                 sizeof(MeshInstance))) {
+        return NULL;
+    }
+
+    /* Instances carry their own colors and spread across the scene, so a
+     * batch sorts by shader, texture and mesh only, ahead of single draws
+     * of the same shader and mesh */
+    DrawBatch* batch = &list->batches[list->batch_count++];
+    batch->shader = shader;
+    batch->features = features;
+    batch->mesh = mesh;
+    batch->texture = texture;
+    batch->first_instance = list->instance_count;
+    batch->instance_count = count;
+    batch->lod = lod;
+    batch->key = render_queue_key(shader_sort_id(shader, features), texture.id, mesh.id, 0.0f, false);
+    list->instance_count += count;
+    list->passes[list->pass_count - 1].batch_count++;
+    list->is_sorted = false;
+    return &list->instances[batch->first_instance];
+}
+
+u32 draw_list_select_lod(const DrawList* list, const Mesh* mesh, Vec3 center, f32 radius) {
+    if (mesh->lod_count < 2) return 0;
+
+    /* projection.m[5] is the cotangent of half the vertical field of view */
+    f32 distance = vec3_length(vec3_sub(center, list->view_position));
+    if (distance <= radius) return 0;
+    f32 screen_size = radius * list->projection.m[5] / distance;
+    return mesh_select_lod(mesh, screen_size, list->lod_bias);
+}
+
+void draw_list_sort(DrawList* list) {
+    PROFILE_BEGIN("draw_list_sort");
+
+    u32 total = list->command_count + list->batch_count;
+    u32 capacity = list->sorted_capacity;
+    if (!reserve((void**)&list->sorted, &capacity, total, sizeof(RenderSortEntry)) ||
+        !reserve((void**)&list->sort_scratch, &list->sorted_capacity, total, sizeof(RenderSortEntry))) {
+        /* Drawn in recording order instead */
+        list->is_sorted = false;
+        PROFILE_END();
+        return;
+    }
+
+    for (u32 p = 0; p < list->pass_count; p++) {
+        const DrawPass* pass = &list->passes[p];
+        RenderSortEntry* entries = &list->sorted[pass->first_command + pass->first_batch];
+        u32 count = 0;
+        for (u32 i = 0; i < pass->command_count; i++) {
+            u32 item = pass->first_command + i;
+            entries[count++] = (RenderSortEntry){ list->commands[item].key, item };
+        }
+        for (u32 i = 0; i < pass->batch_count; i++) {
+            u32 item = pass->first_batch + i;
+            entries[count++] = (RenderSortEntry){ list->batches[item].key, item | DRAW_ITEM_BATCH };
+        }
+        render_queue_sort(entries, list->sort_scratch, count);
+    }
+    list->is_sorted = true;
+
+    PROFILE_END();
+}
+
+static bool color_equal(Color a, Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+/* Bound state, so draws only change what differs from the previous one */
+typedef struct {
+    u32 shader_id;
+    u32 features;
+    const Shader* shader;      /* The variant drawn with */
+    u32 program;               /* Its program; adding a variant can move the shader */
+    const Mesh* mesh;
+    const Mesh* decode_mesh;   /* Mesh whose decoding the bound shader has */
+    u32 texture_id;            /* Handle of the texture on unit 0 */
+    Color color;
+    bool color_set;
+    bool blending;
+    UniformId model;
+    UniformId normal_matrix;
+    UniformId object_color;
+    UniformId position_scale;
+    UniformId position_offset;
+    UniformId oct_normals;
+} DrawState;
+
+/* False if the shader was destroyed or its variant failed to build.
+ * Variants that stand in for one still building can be shared by several
+ * masks, so the program decides whether anything is rebound. */
+static bool bind_shader(DrawState* state, ShaderHandle handle, u32 features) {
+    if (state->shader && handle.id == state->shader_id && features == state->features) return true;
+
+    const Shader* shader = shader_select_variant(handle, features);
+    if (!shader) return false;
+    if (!state->shader || shader->program != state->program) {
+        shader_use(shader);
+        state->program = shader->program;
+        state->color_set = false;
+        state->decode_mesh = NULL;
+    }
+    state->shader_id = handle.id;
+    state->features = features;
+    state->shader = shader;
+    return true;
+}
+
+/* Tell the bound shader how the mesh's vertices are stored */
+static void set_mesh_decode(DrawState* state, const Mesh* mesh) {
+    if (mesh == state->decode_mesh) return;
+    const Shader* shader = state->shader;
+    shader_set_vec3(shader, state->position_scale, mesh->position_scale);
+    shader_set_vec3(shader, state->position_offset, mesh->position_offset);
+    shader_set_int(shader, state->oct_normals, mesh->format == MESH_VERTEX_COMPACT);
+    state->decode_mesh = mesh;
+}
+
+static void set_blending(DrawState* state, bool blending) {
+    if (blending == state->blending) return;
+    if (blending) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+    } else {
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+    }
+    state->blending = blending;
+}
+
+static void draw_command(DrawState* state, const DrawCommand* command) {
+    const Mesh* mesh = mesh_get(command->mesh);
+    if (!mesh || !bind_shader(state, command->shader, command->features)) return;
+    set_blending(state, command->color.a < 1.0f);
+    set_mesh_decode(state, mesh);
+
+    const Shader* shader = state->shader;
+    shader_set_mat3x4(shader, state->model, &command->model);
+    shader_set_mat3(shader, state->normal_matrix, &command->normal_matrix);
+    if (!state->color_set || !color_equal(command->color, state->color)) {
+        shader_set_color(shader, state->object_color, command->color);
+        state->color = command->color;
+        state->color_set = true;
+    }
+
+    if (mesh != state->mesh) {
+        mesh_bind(mesh);
+        state->mesh = mesh;
+    }
+    mesh_draw_bound(mesh, command->lod);
+}
+
+static void draw_batch(DrawState* state, const DrawList* list, const DrawBatch* batch) {
+    Mesh* mesh = mesh_get(batch->mesh);
+    if (!mesh || !bind_shader(state, batch->shader, batch->features)) return;
+    set_blending(state, false);
+    set_mesh_decode(state, mesh);
+    if (HANDLE_IS_VALID(batch->texture) && batch->texture.id != state->texture_id) {
+        texture_bind(texture_get(batch->texture), 0);
+        state->texture_id = batch->texture.id;
+    }
+
+    /* Binds the mesh's VAO and leaves none bound */
+    mesh_draw_instanced(mesh, batch->lod, &list->instances[batch->first_instance],
+                        batch->instance_count);
+    state->mesh = NULL;
+}
+
+void draw_list_execute(const DrawList* list) {
+    if (renderer_is_headless()) return;
+
+    PROFILE_BEGIN("draw_list_execute");
+    gpu_profiler_begin_frame();
+
+    glViewport(0, 0, list->viewport_width, list->viewport_height);
+    glClearColor(list->clear_color.r, list->clear_color.g, list->clear_color.b, list->clear_color.a);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    shader_poll_variants();
+
+    /* One upload serves every program drawn this frame */
+    FrameUniforms frame;
+    frame_uniforms_set(&frame, &list->view, &list->projection, list->view_position,
+                       list->light_dir, list->light_color);
+    frame_uniforms_upload(&frame);
+
+    DrawState state;
+    memset(&state, 0, sizeof(state));
+    state.model = uniform_id("model");
+    state.normal_matrix = uniform_id("normalMatrix");
+    state.object_color = uniform_id("objectColor");
+    state.position_scale = uniform_id("meshPositionScale");
+    state.position_offset = uniform_id("meshPositionOffset");
+    state.oct_normals = uniform_id("meshOctNormals");
+
+    for (u32 p = 0; p < list->pass_count; p++) {
+        const DrawPass* pass = &list->passes[p];
+        u32 count = pass->command_count + pass->batch_count;
+        if (count == 0) continue;
+
+        GPU_PROFILE_BEGIN(pass->name);
+        const RenderSortEntry* entries = list->is_sorted
+                                       ? &list->sorted[pass->first_command + pass->first_batch] : NULL;
+        for (u32 i = 0; i < count; i++) {
+            u32 item;
+            if (list->is_sorted) {
+                item = entries[i].item;
+            } else if (i < pass->command_count) {
+                item = pass->first_command + i;
+            } else {
+                item = (pass->first_batch + i - pass->command_count) | DRAW_ITEM_BATCH;
+            }
+
+            if (item & DRAW_ITEM_BATCH) {
+                draw_batch(&state, list, &list->batches[item & ~DRAW_ITEM_BATCH]);
+            } else {
+                draw_command(&state, &list->commands[item]);
+            }
+        }
+        GPU_PROFILE_END();
+    }
+
+    set_blending(&state, false);
+    if (state.mesh) mesh_unbind();
+
+    gpu_profiler_end_frame();
+    PROFILE_END();
+}
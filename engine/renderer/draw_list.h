@@ -0,0 +1,141 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include "../core/types.h"
+#include "../math/vec3.h"
+#include "../math/mat4.h"
+#include "../math/transform.h"
+#include "mesh.h"
+#include "shader.h"
+#include "texture.h"
+#include "render_queue.h"
+
+/* Everything needed to draw one frame, recorded by the game thread and
+ * executed later, possibly on the render thread. Once submitted a list is
+ * read-only, so it holds copies of all per-frame state. Meshes and shaders
+ * are held by handle and resolved at execution, where destroyed ones are
+ * skipped and shader variants are chosen (and built if new) from each
+ * draw's feature mask, which plain shaders ignore. Their pools must not
+ * change while a list is executing on the render thread, so create and
+ * destroy them before the first frame or after engine_finish_rendering.
+ *
+ * Each command and batch gets a sort key (see render_queue.h) when added,
+ * and draw_list_sort orders every pass by key before the list is handed
+ * over, so execution binds each shader, color and mesh as few times as
+ * possible and draws opaque objects front to back. A color with alpha
+ * below 1 makes a command translucent: blended, drawn after the opaque
+ * ones, back to front. */
+
+#define DRAW_LIST_MAX_PASSES 16
+
+/* Set on RenderSortEntry.item for batches; commands have it clear */
+#define DRAW_ITEM_BATCH 0x80000000u
+
+typedef struct {
+    ShaderHandle shader;
+    u32 features;            /* Variant of shader, see shader_create_variants */
+    MeshHandle mesh;
+    Mat3x4 model;
+    Mat3 normal_matrix;
+    Color color;
+    u32 lod;
+    u64 key;
+} DrawCommand;
+
+/* Instances of one mesh drawn with a single call; always opaque */
+typedef struct {
+    ShaderHandle shader;
+    u32 features;
+    MeshHandle mesh;
+    TextureHandle texture;   /* Bound to unit 0 when valid */
+    u32 first_instance;      /* Into DrawList.instances */
+    u32 instance_count;
+    u32 lod;
+    u64 key;
+} DrawBatch;
+
+/* A layer of the frame, timed as one GPU pass; passes are drawn in the
+ * order they were begun and their contents in key order */
+typedef struct {
+    const char* name;        /* Must outlive the list; string literals */
+    u32 first_command;
+    u32 command_count;
+    u32 first_batch;
+    u32 batch_count;
+} DrawPass;
+
+typedef struct {
+    /* Frame state */
+    i32 viewport_width;
+    i32 viewport_height;
+    Color clear_color;
+    Mat4 view;
+    Mat4 projection;
+    Vec3 view_position;
+    Vec3 light_dir;
+    Vec3 light_color;
+    f32 lod_bias;            /* Scales the screen error LODs may show; higher is coarser */
+    u64 input_time_ns;       /* Mean arrival time of the input it shows (0 = none) */
+
+    DrawPass passes[DRAW_LIST_MAX_PASSES];
+    u32 pass_count;
+
+    DrawCommand* commands;
+    u32 command_count;
+    u32 command_capacity;
+
+    DrawBatch* batches;
+    u32 batch_count;
+    u32 batch_capacity;
+    MeshInstance* instances;
+    u32 instance_count;
+    u32 instance_capacity;
+
+    /* Commands and batches in submission order, per pass starting at
+     * first_command + first_batch; filled by draw_list_sort */
+    RenderSortEntry* sorted;
+    RenderSortEntry* sort_scratch;
+    u32 sorted_capacity;
+    bool is_sorted;
+} DrawList;
+
+bool draw_list_init(DrawList* list, u32 initial_capacity);
+void draw_list_free(DrawList* list);
+
+/* Drop all passes and commands, keeping the command storage */
+void draw_list_reset(DrawList* list);
+
+void draw_list_set_camera(DrawList* list, const Mat4* view, const Mat4* projection, Vec3 position);
+void draw_list_set_light(DrawList* list, Vec3 direction, Vec3 color);
+
+/* Commands added after this belong to the new pass */
+void draw_list_begin_pass(DrawList* list, const char* name);
+
+/* Depth for the sort key and the LOD are chosen from the camera set by
+ * draw_list_set_camera, so set the camera first */
+void draw_list_add(DrawList* list, ShaderHandle shader, u32 features, MeshHandle mesh,
+                   const Mat3x4* model, const Mat3* normal_matrix, Color color);
+
+/* Reserve count instances of one LOD of mesh, drawn with one instanced
+ * call, for the caller to fill in. The pointer is good until the next add;
+ * NULL when there is no pass, count is 0 or memory runs out. */
+MeshInstance* draw_list_add_instances(DrawList* list, ShaderHandle shader, u32 features,
+                                      MeshHandle mesh, u32 lod, u32 count);
+
+/* Same, with texture bound to unit 0 for the batch */
+MeshInstance* draw_list_add_textured_instances(DrawList* list, ShaderHandle shader, u32 features,
+                                               MeshHandle mesh, TextureHandle texture, u32 lod,
+                                               u32 count);
+
+/* LOD of mesh for a world-space bounding sphere, from the list's camera
+ * and lod_bias */
+u32 draw_list_select_lod(const DrawList* list, const Mesh* mesh, Vec3 center, f32 radius);
+
+/* Order each pass by sort key; called by the engine when recording ends */
+void draw_list_sort(DrawList* list);
+
+/* Clear and draw the whole frame on the thread that owns the GL context.
+ * Unsorted lists are drawn in recording order. No-op when headless. */
+void draw_list_execute(const DrawList* list);
+
+#endif /* DRAW_LIST_H */
@@ -0,0 +1,64 @@
+#include "frame_uniforms.h"
+#include "renderer.h"
+#include <glad/glad.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/* The GLSL block is declared by hand, so check the offsets std140 gives it */
+_Static_assert(offsetof(FrameUniforms, projection) == 64, "FrameUniforms layout");
+_Static_assert(offsetof(FrameUniforms, view_position) == 192, "FrameUniforms layout");
+_Static_assert(offsetof(FrameUniforms, light_color) == 224, "FrameUniforms layout");
+_Static_assert(sizeof(FrameUniforms) == 240, "FrameUniforms layout");
+
+static u32 g_frame_ubo = 0;
+
+bool frame_uniforms_init(void) {
+    if (renderer_is_headless() || g_frame_ubo) return g_frame_ubo != 0;
+    
+    glGenBuffers(1, &g_frame_ubo);
+    if (!g_frame_ubo) {
+        fprintf(stderr, "Failed to create frame uniform buffer\n");
+        return false;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, g_frame_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    
+    /* Stays bound: nothing else uses this binding point */
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, g_frame_ubo);
+    return true;
+}
+
+void frame_uniforms_shutdown(void) {
+    if (g_frame_ubo) {
+        glDeleteBuffers(1, &g_frame_ubo);
+        g_frame_ubo = 0;
+    }
+}
+
+static void set_vec(f32 out[4], Vec3 value) {
+    out[0] = value.x;
+    out[1] = value.y;
+    out[2] = value.z;
+    out[3] = 0.0f;
+}
+
+void frame_uniforms_set(FrameUniforms* uniforms, const Mat4* view, const Mat4* projection,
+                        Vec3 view_position, Vec3 light_dir, Vec3 light_color) {
+    uniforms->view = *view;
+    uniforms->projection = *projection;
+    mat4_mul(&uniforms->view_projection, projection, view);
+    set_vec(uniforms->view_position, view_position);
+    set_vec(uniforms->light_dir, light_dir);
+    set_vec(uniforms->light_color, light_color);
+}
+
+void frame_uniforms_upload(const FrameUniforms* uniforms) {
+    if (!g_frame_ubo) return;
+    
+    /* Orphan, then fill: the previous frame's draws may still be reading */
+    glBindBuffer(GL_UNIFORM_BUFFER, g_frame_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), uniforms);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
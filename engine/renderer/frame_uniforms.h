@@ -0,0 +1,50 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include "../core/types.h"
+#include "../math/vec3.h"
+#include "../math/mat4.h"
+
+/* Per-frame constants in one std140 uniform buffer, written once per frame
+ * and bound to FRAME_UNIFORMS_BINDING for every program. shader_create
+ * points each program's FrameData block at that binding, so shaders only
+ * need to declare the block (FRAME_UNIFORMS_GLSL).
+ *
+ * When there is no GL context (headless), every call is a no-op. */
+
+#define FRAME_UNIFORMS_BINDING 0
+#define FRAME_UNIFORMS_BLOCK "FrameData"
+
+/* std140 layout: mat4 is four 16-byte columns and a vec3 takes a whole
+ * 16-byte slot, so the vectors carry a w that the shaders ignore */
+typedef struct {
+    Mat4 view;
+    Mat4 projection;
+    Mat4 view_projection;
+    f32 view_position[4];
+    f32 light_dir[4];
+    f32 light_color[4];
+} FrameUniforms;
+
+/* GLSL declaration matching FrameUniforms, for pasting into shader sources */
+#define FRAME_UNIFORMS_GLSL \
+    "layout (std140) uniform " FRAME_UNIFORMS_BLOCK " {\n" \
+    "    mat4 view;\n" \
+    "    mat4 projection;\n" \
+    "    mat4 viewProjection;\n" \
+    "    vec4 viewPos;\n" \
+    "    vec4 lightDir;\n" \
+    "    vec4 lightColor;\n" \
+    "};\n"
+
+/* Needs a current GL context */
+bool frame_uniforms_init(void);
+void frame_uniforms_shutdown(void);
+
+void frame_uniforms_set(FrameUniforms* uniforms, const Mat4* view, const Mat4* projection,
+                        Vec3 view_position, Vec3 light_dir, Vec3 light_color);
+
+/* Replace the buffer's contents; draws issued after this see them */
+void frame_uniforms_upload(const FrameUniforms* uniforms);
+
+#endif /* FRAME_UNIFORMS_H */
@@ -0,0 +1,222 @@
+#include "gpu_profiler.h"
+#include "renderer.h"
+#include "../core/profiler.h"
+#include "../core/thread.h"
+#include "../core/timer.h"
+#include <glad/glad.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Resolved frames between GPU/CPU clock re-syncs */
+#define GPU_CLOCK_SYNC_INTERVAL 60
+
+#define GPU_PASS_NONE ((u32)-1)
+
+typedef struct {
+    const char* name;
+    u32 depth;
+} GpuPassInfo;
+
+typedef struct {
+    u32 queries[GPU_PROFILER_MAX_PASSES * 2];   /* Begin/end timestamp per pass */
+    GpuPassInfo passes[GPU_PROFILER_MAX_PASSES];
+    u32 pass_count;
+    u32 last_query;                             /* Issued last, completes last */
+    bool pending;                               /* Issued, not yet read back */
+} GpuFrame;
+
+typedef struct {
+    bool available;
+    bool recording;
+    GpuFrame frames[GPU_PROFILER_LATENCY];
+    u32 current;
+    u32 stack[GPU_PROFILER_MAX_DEPTH];
+    u32 depth;
+    Mutex results_mutex;                        /* Results are read from any thread */
+    GpuPassTime results[GPU_PROFILER_MAX_PASSES];
+    u32 result_count;
+    f32 frame_ms;
+    bool frame_taken;                           /* frame_ms already handed out */
+    i64 clock_offset_ns;                        /* CPU time minus GPU time */
+    u32 sync_countdown;
+} GpuProfiler;
+
+static GpuProfiler g_gpu = {0};
+
+static void sync_clocks(void) {
+    GLint64 gpu_ns = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_ns);
+    g_gpu.clock_offset_ns = (i64)timer_now_ns() - (i64)gpu_ns;
+    g_gpu.sync_countdown = GPU_CLOCK_SYNC_INTERVAL;
+}
+
+bool gpu_profiler_init(void) {
+    memset(&g_gpu, 0, sizeof(g_gpu));
+    if (renderer_is_headless()) return false;
+
+    GLint bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    if (bits == 0) {
+        printf("GPU timer queries not supported; GPU profiling disabled\n");
+        return false;
+    }
+
+    for (u32 i = 0; i < GPU_PROFILER_LATENCY; i++) {
+        glGenQueries(GPU_PROFILER_MAX_PASSES * 2, g_gpu.frames[i].queries);
+    }
+    sync_clocks();
+    mutex_init(&g_gpu.results_mutex);
+    g_gpu.frame_taken = true;
+    g_gpu.available = true;
+    return true;
+}
+
+void gpu_profiler_shutdown(void) {
+    if (!g_gpu.available) return;
+
+    for (u32 i = 0; i < GPU_PROFILER_LATENCY; i++) {
+        glDeleteQueries(GPU_PROFILER_MAX_PASSES * 2, g_gpu.frames[i].queries);
+    }
+    mutex_destroy(&g_gpu.results_mutex);
+    g_gpu.available = false;
+}
+
+bool gpu_profiler_is_available(void) {
+    return g_gpu.available;
+}
+
+/* Read back a frame if the GPU has finished it; never waits */
+static void resolve_frame(GpuFrame* frame) {
+    frame->pending = false;
+    if (frame->pass_count == 0) return;
+
+    /* Timestamps complete in order, so the last one covers the frame */
+    GLint ready = 0;
+    glGetQueryObjectiv(frame->last_query, GL_QUERY_RESULT_AVAILABLE, &ready);
+    if (!ready) return;
+
+    if (--g_gpu.sync_countdown == 0) {
+        sync_clocks();
+    }
+
+    GpuPassTime results[GPU_PROFILER_MAX_PASSES];
+    u64 first_start = UINT64_MAX;
+    u64 last_end = 0;
+    for (u32 i = 0; i < frame->pass_count; i++) {
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(frame->queries[i * 2], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(frame->queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+        results[i].name = frame->passes[i].name;
+        results[i].depth = frame->passes[i].depth;
+        results[i].ms = end > start ? (f32)((f64)(end - start) * 1e-6) : 0.0f;
+        if (start < first_start) first_start = start;
+        if (end > last_end) last_end = end;
+
+#ifdef ENGINE_PROFILE
+        profiler_record_gpu(frame->passes[i].name, (u64)((i64)start + g_gpu.clock_offset_ns),
+                            (u64)((i64)end + g_gpu.clock_offset_ns));
+#endif
+    }
+
+    mutex_lock(&g_gpu.results_mutex);
+    memcpy(g_gpu.results, results, frame->pass_count * sizeof(GpuPassTime));
+    g_gpu.result_count = frame->pass_count;
+    g_gpu.frame_ms = last_end > first_start ? (f32)((f64)(last_end - first_start) * 1e-6) : 0.0f;
+    g_gpu.frame_taken = false;
+    mutex_unlock(&g_gpu.results_mutex);
+}
+
+void gpu_profiler_begin_frame(void) {
+    if (!g_gpu.available) return;
+
+    /* The slot about to be reused is the oldest in flight */
+    GpuFrame* frame = &g_gpu.frames[g_gpu.current];
+    if (frame->pending) {
+        resolve_frame(frame);
+    }
+
+    frame->pass_count = 0;
+    g_gpu.depth = 0;
+    g_gpu.recording = true;
+}
+
+void gpu_profiler_end_frame(void) {
+    if (!g_gpu.available || !g_gpu.recording) return;
+
+    /* Close passes left open so the frame's queries are complete */
+    while (g_gpu.depth > 0) {
+        gpu_profiler_end();
+    }
+
+    g_gpu.frames[g_gpu.current].pending = true;
+    g_gpu.current = (g_gpu.current + 1) % GPU_PROFILER_LATENCY;
+    g_gpu.recording = false;
+}
+
+void gpu_profiler_begin(const char* name) {
+    if (!g_gpu.available || !g_gpu.recording) return;
+
+    GpuFrame* frame = &g_gpu.frames[g_gpu.current];
+    u32 pass = GPU_PASS_NONE;
+    if (frame->pass_count < GPU_PROFILER_MAX_PASSES && g_gpu.depth < GPU_PROFILER_MAX_DEPTH) {
+        pass = frame->pass_count++;
+        frame->passes[pass].name = name;
+        frame->passes[pass].depth = g_gpu.depth;
+        glQueryCounter(frame->queries[pass * 2], GL_TIMESTAMP);
+        frame->last_query = frame->queries[pass * 2];
+    }
+
+    /* Overflowing passes still take a stack slot so ends stay paired */
+    if (g_gpu.depth < GPU_PROFILER_MAX_DEPTH) {
+        g_gpu.stack[g_gpu.depth] = pass;
+    }
+    g_gpu.depth++;
+}
+
+void gpu_profiler_end(void) {
+    if (!g_gpu.available || !g_gpu.recording || g_gpu.depth == 0) return;
+
+    g_gpu.depth--;
+    if (g_gpu.depth >= GPU_PROFILER_MAX_DEPTH) return;
+
+    u32 pass = g_gpu.stack[g_gpu.depth];
+    if (pass != GPU_PASS_NONE) {
+        GpuFrame* frame = &g_gpu.frames[g_gpu.current];
+        glQueryCounter(frame->queries[pass * 2 + 1], GL_TIMESTAMP);
+        frame->last_query = frame->queries[pass * 2 + 1];
+    }
+}
+
+u32 gpu_profiler_get_timings(GpuPassTime* out, u32 max_passes) {
+    if (!g_gpu.available) return 0;
+
+    mutex_lock(&g_gpu.results_mutex);
+    u32 count = g_gpu.result_count < max_passes ? g_gpu.result_count : max_passes;
+    memcpy(out, g_gpu.results, count * sizeof(GpuPassTime));
+    mutex_unlock(&g_gpu.results_mutex);
+    return count;
+}
+
+bool gpu_profiler_take_frame_ms(f32* ms) {
+    if (!g_gpu.available) return false;
+
+    mutex_lock(&g_gpu.results_mutex);
+    bool fresh = !g_gpu.frame_taken;
+    *ms = g_gpu.frame_ms;
+    g_gpu.frame_taken = true;
+    mutex_unlock(&g_gpu.results_mutex);
+    return fresh;
+}
+
+void gpu_profiler_print(void) {
+    GpuPassTime passes[GPU_PROFILER_MAX_PASSES];
+    u32 count = gpu_profiler_get_timings(passes, GPU_PROFILER_MAX_PASSES);
+    if (count == 0) return;
+
+    printf("GPU passes (last resolved frame):\n");
+    for (u32 i = 0; i < count; i++) {
+        printf("  %*s%-*s %7.3f ms\n", (int)(passes[i].depth * 2), "",
+               (int)(16 - passes[i].depth * 2), passes[i].name, passes[i].ms);
+    }
+}
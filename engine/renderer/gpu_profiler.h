@@ -0,0 +1,59 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include "../core/types.h"
+
+/* GPU pass timing with GL_TIMESTAMP queries. Each frame's queries go into
+ * one slot of a small ring and are read back GPU_PROFILER_LATENCY frames
+ * later, only once the driver reports them available, so reading never
+ * stalls the pipeline. Resolved passes are also sent to the CPU profiler
+ * as a "GPU" track.
+ *
+ * When there is no GL context (headless) or the driver has no timer
+ * support (GL_QUERY_COUNTER_BITS of 0), every call is a no-op. */
+
+#define GPU_PROFILER_MAX_PASSES 32
+#define GPU_PROFILER_MAX_DEPTH 8
+#define GPU_PROFILER_LATENCY 4   /* Frames in flight in the query ring */
+
+typedef struct {
+    const char* name;
+    u32 depth;
+    f32 ms;
+} GpuPassTime;
+
+/* Needs a current GL context; returns whether timing is available */
+bool gpu_profiler_init(void);
+void gpu_profiler_shutdown(void);
+bool gpu_profiler_is_available(void);
+
+/* Frame boundaries, called by the engine */
+void gpu_profiler_begin_frame(void);
+void gpu_profiler_end_frame(void);
+
+/* Passes may nest; name must outlive the profiler */
+void gpu_profiler_begin(const char* name);
+void gpu_profiler_end(void);
+
+/* Timings of the most recently resolved frame; returns the pass count.
+ * Results are resolved on the thread that owns the GL context and may be
+ * read from any thread. */
+u32 gpu_profiler_get_timings(GpuPassTime* out, u32 max_passes);
+
+/* GPU time of the most recently resolved frame, first pass start to last
+ * pass end; false if no frame was resolved since the last call, so each
+ * one is taken once. Any thread. */
+bool gpu_profiler_take_frame_ms(f32* ms);
+
+/* Print the timings of the most recently resolved frame, if any */
+void gpu_profiler_print(void);
+
+#ifdef ENGINE_PROFILE
+#define GPU_PROFILE_BEGIN(name)  gpu_profiler_begin(name)
+#define GPU_PROFILE_END()        gpu_profiler_end()
+#else
+#define GPU_PROFILE_BEGIN(name)  ((void)0)
+#define GPU_PROFILE_END()        ((void)0)
+#endif
+
+#endif /* GPU_PROFILER_H */
@@ -1,20 +1,257 @@
 #include "mesh.h"
+#include "mesh_simplify.h"
+#include "renderer.h"
+#include "../core/arena.h"
+#include "../core/handle_pool.h"
 #include <glad/glad.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <stddef.h>
+#include <string.h>
 #include <math.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
-Mesh* mesh_create(const Vertex* vertices, u32 vertex_count,
-                  const u32* indices, u32 index_count) {
-    Mesh* mesh = (Mesh*)malloc(sizeof(Mesh));
-    if (!mesh) return NULL;
+static HandlePool g_meshes;
+static bool g_meshes_ready = false;
+
+/* AABB plus a bounding sphere centred on it */
+static void mesh_compute_bounds(Mesh* mesh, const Vertex* vertices, u32 vertex_count) {
+    Vec3 min = vec3_create(0.0f, 0.0f, 0.0f);
+    Vec3 max = vec3_create(0.0f, 0.0f, 0.0f);
+    
+    if (vertex_count > 0) {
+        min = max = vertices[0].position;
+        for (u32 i = 1; i < vertex_count; i++) {
+            Vec3 p = vertices[i].position;
+            min = vec3_create(fminf(min.x, p.x), fminf(min.y, p.y), fminf(min.z, p.z));
+            max = vec3_create(fmaxf(max.x, p.x), fmaxf(max.y, p.y), fmaxf(max.z, p.z));
+        }
+    }
+    
+    Vec3 center = vec3_scale(vec3_add(min, max), 0.5f);
+    f32 radius_sq = 0.0f;
+    for (u32 i = 0; i < vertex_count; i++) {
+        f32 d = vec3_length_squared(vec3_sub(vertices[i].position, center));
+        if (d > radius_sq) radius_sq = d;
+    }
+    
+    mesh->bounds_min = min;
+    mesh->bounds_max = max;
+    mesh->bounds_center = center;
+    mesh->bounds_radius = sqrtf(radius_sq);
+}
+
+/* Round to nearest; out-of-range values become infinity, tiny ones zero */
+static u16 half_from_f32(f32 value) {
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    u32 sign = (bits >> 16) & 0x8000;
+    u32 mantissa = bits & 0x7FFFFF;
+    i32 exponent = (i32)((bits >> 23) & 0xFF) - 127 + 15;
+    
+    if (((bits >> 23) & 0xFF) == 0xFF) {
+        return (u16)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+    if (exponent >= 31) return (u16)(sign | 0x7C00);
+    if (exponent <= 0) {
+        if (exponent < -10) return (u16)sign;
+        /* Subnormal: shift the implicit bit down into the mantissa */
+        mantissa |= 0x800000;
+        u32 shift = (u32)(14 - exponent);
+        u32 half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) half++;
+        return (u16)(sign | half);
+    }
+    
+    /* A carry out of the mantissa correctly bumps the exponent */
+    u32 half = sign | ((u32)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) half++;
+    return (u16)half;
+}
+
+static i16 snorm16(f32 value) {
+    if (value > 1.0f) value = 1.0f;
+    if (value < -1.0f) value = -1.0f;
+    return (i16)lrintf(value * 32767.0f);
+}
+
+/* Project onto the octahedron |x|+|y|+|z| = 1 and fold the lower half
+ * over the diagonals, so a unit vector fits in two components */
+static void octahedral_encode(Vec3 n, i16 out[2]) {
+    f32 l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    f32 x = l1 > 0.0f ? n.x / l1 : 0.0f;
+    f32 y = l1 > 0.0f ? n.y / l1 : 0.0f;
+    if (n.z < 0.0f) {
+        f32 folded_x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        f32 folded_y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = folded_x;
+        y = folded_y;
+    }
+    out[0] = snorm16(x);
+    out[1] = snorm16(y);
+}
+
+static u16 quantize_unorm16(f32 value, f32 min, f32 extent) {
+    if (extent <= 0.0f) return 0;
+    f32 t = (value - min) / extent;
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    return (u16)lrintf(t * 65535.0f);
+}
+
+/* Positions are quantized across the bounds, so those must be computed */
+static void mesh_compact_vertices(const Mesh* mesh, const Vertex* vertices, u32 vertex_count,
+                                  CompactVertex* out) {
+    Vec3 min = mesh->bounds_min;
+    Vec3 extent = vec3_sub(mesh->bounds_max, mesh->bounds_min);
+    for (u32 i = 0; i < vertex_count; i++) {
+        const Vertex* v = &vertices[i];
+        out[i].position[0] = quantize_unorm16(v->position.x, min.x, extent.x);
+        out[i].position[1] = quantize_unorm16(v->position.y, min.y, extent.y);
+        out[i].position[2] = quantize_unorm16(v->position.z, min.z, extent.z);
+        out[i].position[3] = 0;
+        octahedral_encode(v->normal, out[i].normal);
+        out[i].texcoord[0] = half_from_f32(v->texcoord.x);
+        out[i].texcoord[1] = half_from_f32(v->texcoord.y);
+    }
+}
+
+static void mesh_set_vertex_attributes(MeshVertexFormat format) {
+    if (format == MESH_VERTEX_COMPACT) {
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex),
+                              (void*)offsetof(CompactVertex, position));
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(CompactVertex),
+                              (void*)offsetof(CompactVertex, normal));
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex),
+                              (void*)offsetof(CompactVertex, texcoord));
+    } else {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texcoord));
+    }
+    
+    /* Position, normal, texture coordinate */
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+}
+
+/* Simplify against the full mesh each time, halving the target, and
+ * append each LOD's indices after the previous ones. Returns the combined
+ * index buffer (indices itself when there is nothing to add). */
+static const u32* mesh_build_lods(Mesh* mesh, const Vertex* vertices, u32 vertex_count,
+                                  const u32* indices, u32 index_count, u32 lod_count,
+                                  Arena* arena, u32* total_count) {
+    mesh->lods[0] = (MeshLod){0, index_count, 0.0f};
+    mesh->lod_count = 1;
+    *total_count = index_count;
+    if (lod_count > MESH_MAX_LODS) lod_count = MESH_MAX_LODS;
+    if (!indices || index_count == 0 || lod_count < 2) return indices;
+    
+    u32* combined = arena_push_array(arena, u32, (size_t)index_count * MESH_MAX_LODS);
+    if (!combined) return indices;
+    memcpy(combined, indices, index_count * sizeof(u32));
+    
+    /* Simplification may not move the surface further than this */
+    f32 max_error = mesh->bounds_radius * 0.25f;
+    u32 total = index_count;
+    u32 previous = index_count;
+    for (u32 lod = 1; lod < lod_count; lod++) {
+        u32 target = (previous / 2) / 3 * 3;
+        f32 error;
+        u32 count = mesh_simplify(vertices, vertex_count, indices, index_count, target, max_error,
+                                  &combined[total], &error);
+        if (count == 0 || count > previous - previous / 4) break;
+        
+        /* Selection assumes error never shrinks down the chain */
+        if (error < mesh->lods[lod - 1].error) error = mesh->lods[lod - 1].error;
+        mesh->lods[lod] = (MeshLod){total, count, error};
+        mesh->lod_count++;
+        total += count;
+        previous = count;
+    }
+    
+    *total_count = total;
+    return combined;
+}
+
+MeshHandle mesh_create(const Vertex* vertices, u32 vertex_count,
+                       const u32* indices, u32 index_count, MeshVertexFormat format) {
+    return mesh_create_lods(vertices, vertex_count, indices, index_count, format, 1);
+}
+
+MeshHandle mesh_create_lods(const Vertex* vertices, u32 vertex_count,
+                            const u32* indices, u32 index_count, MeshVertexFormat format,
+                            u32 lod_count) {
+    MeshHandle handle = {INVALID_HANDLE};
+    if (!g_meshes_ready) {
+        g_meshes_ready = handle_pool_init(&g_meshes, sizeof(Mesh), 64, "Mesh");
+        if (!g_meshes_ready) return handle;
+    }
+    
+    Mesh* mesh = (Mesh*)handle_pool_alloc(&g_meshes, &handle.id);
+    if (!mesh) return handle;
     
     mesh->vertex_count = vertex_count;
     mesh->index_count = index_count;
+    mesh->index_size = vertex_count < 65536 ? sizeof(u16) : sizeof(u32);
+    mesh->format = format;
+    mesh_compute_bounds(mesh, vertices, vertex_count);
+    if (format == MESH_VERTEX_COMPACT) {
+        mesh->position_scale = vec3_sub(mesh->bounds_max, mesh->bounds_min);
+        mesh->position_offset = mesh->bounds_min;
+    } else {
+        mesh->position_scale = vec3_create(1.0f, 1.0f, 1.0f);
+        mesh->position_offset = vec3_create(0.0f, 0.0f, 0.0f);
+    }
+    
+    /* LODs are chosen on the game thread, so headless meshes have them too */
+    Scratch scratch = scratch_begin();
+    u32 total_count;
+    indices = mesh_build_lods(mesh, vertices, vertex_count, indices, index_count, lod_count,
+                              scratch.arena, &total_count);
+    index_count = total_count;
+    
+    /* Headless: keep the CPU-side description, no GPU buffers */
+    if (renderer_is_headless()) {
+        mesh->vao = 0;
+        mesh->vbo = 0;
+        mesh->ebo = 0;
+        scratch_end(scratch);
+        return handle;
+    }
+    
+    /* Re-encode into scratch space when the GPU copy is narrower */
+    bool compact = format == MESH_VERTEX_COMPACT;
+    bool narrow = indices && index_count > 0 && mesh->index_size == sizeof(u16);
+    CompactVertex* compact_vertices = compact
+        ? arena_push_array(scratch.arena, CompactVertex, vertex_count) : NULL;
+    u16* narrow_indices = narrow ? arena_push_array(scratch.arena, u16, index_count) : NULL;
+    if ((compact && !compact_vertices) || (narrow && !narrow_indices)) {
+        fprintf(stderr, "Failed to allocate mesh upload buffers\n");
+        scratch_end(scratch);
+        handle_pool_release(&g_meshes, handle.id);
+        return (MeshHandle){INVALID_HANDLE};
+    }
+    
+    const void* vertex_data = vertices;
+    size_t vertex_size = sizeof(Vertex);
+    if (compact) {
+        mesh_compact_vertices(mesh, vertices, vertex_count, compact_vertices);
+        vertex_data = compact_vertices;
+        vertex_size = sizeof(CompactVertex);
+    }
+    
+    const void* index_data = indices;
+    if (narrow) {
+        for (u32 i = 0; i < index_count; i++) {
+            narrow_indices[i] = (u16)indices[i];
+        }
+        index_data = narrow_indices;
+    }
     
     glGenVertexArrays(1, &mesh->vao);
     glGenBuffers(1, &mesh->vbo);
@@ -22,60 +259,175 @@ Mesh* mesh_create(const Vertex* vertices, u32 vertex_count,
     glBindVertexArray(mesh->vao);
     
     glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertex_count * sizeof(Vertex), vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertex_count * vertex_size, vertex_data, GL_STATIC_DRAW);
     
     if (indices && index_count > 0) {
         glGenBuffers(1, &mesh->ebo);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(u32), indices, GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * mesh->index_size, index_data, GL_STATIC_DRAW);
     } else {
         mesh->ebo = 0;
     }
     
-    /* Position attribute */
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    /* Normal attribute */
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(1);
-    
-    /* Texture coordinate attribute */
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texcoord));
-    glEnableVertexAttribArray(2);
+    mesh_set_vertex_attributes(format);
     
     glBindVertexArray(0);
+    scratch_end(scratch);
     
-    return mesh;
+    return handle;
 }
 
-void mesh_destroy(Mesh* mesh) {
-    if (!mesh) return;
-    
-    glDeleteVertexArrays(1, &mesh->vao);
-    glDeleteBuffers(1, &mesh->vbo);
+static void mesh_release_buffers(Mesh* mesh) {
+    if (mesh->vao) {
+        glDeleteVertexArrays(1, &mesh->vao);
+        glDeleteBuffers(1, &mesh->vbo);
+    }
     if (mesh->ebo) {
         glDeleteBuffers(1, &mesh->ebo);
     }
+    if (mesh->instance_vbo) {
+        glDeleteBuffers(1, &mesh->instance_vbo);
+    }
+}
+
+void mesh_destroy(MeshHandle handle) {
+    if (!g_meshes_ready || !HANDLE_IS_VALID(handle)) return;
     
-    free(mesh);
+    Mesh* mesh = (Mesh*)handle_pool_get(&g_meshes, handle.id);
+    if (mesh) {
+        mesh_release_buffers(mesh);
+    }
+    handle_pool_release(&g_meshes, handle.id);
+}
+
+Mesh* mesh_get(MeshHandle handle) {
+    return g_meshes_ready ? (Mesh*)handle_pool_get(&g_meshes, handle.id) : NULL;
+}
+
+u32 mesh_live_count(void) {
+    return g_meshes_ready ? handle_pool_count(&g_meshes) : 0;
+}
+
+void mesh_shutdown(void) {
+    if (!g_meshes_ready) return;
+    
+    u32 leaked = handle_pool_count(&g_meshes);
+    if (leaked > 0) {
+        fprintf(stderr, "%u mesh(es) still alive at shutdown\n", leaked);
+    }
+    for (u32 i = 0; i < leaked; i++) {
+        mesh_release_buffers((Mesh*)handle_pool_item_at(&g_meshes, i));
+    }
+    handle_pool_free(&g_meshes);
+    g_meshes_ready = false;
+}
+
+
+static GLenum mesh_index_type(const Mesh* mesh) {
+    return mesh->index_size == sizeof(u16) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+void mesh_bind(const Mesh* mesh) {
+    if (mesh && mesh->vao) {
+        glBindVertexArray(mesh->vao);
+    }
+}
+
+u32 mesh_select_lod(const Mesh* mesh, f32 screen_size, f32 lod_bias) {
+    f32 diameter = 2.0f * mesh->bounds_radius;
+    if (diameter <= 0.0f) return 0;
+    
+    /* Errors grow down the chain, so stop at the first that shows */
+    f32 allowed = MESH_LOD_SCREEN_ERROR * lod_bias;
+    u32 lod = 0;
+    for (u32 i = 1; i < mesh->lod_count; i++) {
+        if (mesh->lods[i].error / diameter * screen_size > allowed) break;
+        lod = i;
+    }
+    return lod;
+}
+
+static const MeshLod* mesh_lod(const Mesh* mesh, u32 lod) {
+    return &mesh->lods[lod < mesh->lod_count ? lod : mesh->lod_count - 1];
+}
+
+void mesh_draw_bound(const Mesh* mesh, u32 lod) {
+    if (!mesh || !mesh->vao) return;
+    
+    if (mesh->ebo && mesh->index_count > 0) {
+        const MeshLod* range = mesh_lod(mesh, lod);
+        glDrawElements(GL_TRIANGLES, range->index_count, mesh_index_type(mesh),
+                       (void*)((size_t)range->first_index * mesh->index_size));
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, mesh->vertex_count);
+    }
+}
+
+void mesh_unbind(void) {
+    glBindVertexArray(0);
 }
 
 void mesh_draw(const Mesh* mesh) {
-    if (!mesh) return;
+    if (!mesh || !mesh->vao) return;
+    
+    mesh_bind(mesh);
+    mesh_draw_bound(mesh, 0);
+    mesh_unbind();
+}
+
+/* Attach the instance buffer to the VAO, which must be bound */
+static void mesh_create_instance_buffer(Mesh* mesh) {
+    glGenBuffers(1, &mesh->instance_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->instance_vbo);
+    
+    for (u32 row = 0; row < 3; row++) {
+        u32 location = MESH_INSTANCE_ATTRIB_MODEL + row;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+                              (void*)(offsetof(MeshInstance, model) + row * 4 * sizeof(f32)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    glVertexAttribPointer(MESH_INSTANCE_ATTRIB_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+                          (void*)offsetof(MeshInstance, color));
+    glEnableVertexAttribArray(MESH_INSTANCE_ATTRIB_COLOR);
+    glVertexAttribDivisor(MESH_INSTANCE_ATTRIB_COLOR, 1);
+    
+    mesh->instance_capacity = 0;
+}
+
+void mesh_draw_instanced(Mesh* mesh, u32 lod, const MeshInstance* instances, u32 count) {
+    if (!mesh || !mesh->vao || count == 0) return;
     
     glBindVertexArray(mesh->vao);
     
+    if (!mesh->instance_vbo) {
+        mesh_create_instance_buffer(mesh);
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->instance_vbo);
+    }
+    
+    /* Respecify the store every frame so the driver can hand out fresh
+     * memory instead of waiting for last frame's draw to finish with it */
+    if (count > mesh->instance_capacity) {
+        u32 capacity = mesh->instance_capacity ? mesh->instance_capacity : 64;
+        while (capacity < count) capacity *= 2;
+        mesh->instance_capacity = capacity;
+    }
+    glBufferData(GL_ARRAY_BUFFER, mesh->instance_capacity * sizeof(MeshInstance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(MeshInstance), instances);
+    
     if (mesh->ebo && mesh->index_count > 0) {
-        glDrawElements(GL_TRIANGLES, mesh->index_count, GL_UNSIGNED_INT, 0);
+        const MeshLod* range = mesh_lod(mesh, lod);
+        glDrawElementsInstanced(GL_TRIANGLES, range->index_count, mesh_index_type(mesh),
+                                (void*)((size_t)range->first_index * mesh->index_size), count);
     } else {
-        glDrawArrays(GL_TRIANGLES, 0, mesh->vertex_count);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, mesh->vertex_count, count);
     }
     
     glBindVertexArray(0);
 }
 
-Mesh* mesh_create_cube(f32 size) {
+MeshHandle mesh_create_cube(f32 size) {
     f32 h = size / 2.0f;
     
     Vertex vertices[] = {
@@ -120,21 +472,21 @@ Mesh* mesh_create_cube(f32 size) {
         20, 21, 22, 22, 23, 20, /* Left */
     };
     
-    return mesh_create(vertices, 24, indices, 36);
+    return mesh_create(vertices, 24, indices, 36, MESH_VERTEX_COMPACT);
 }
 
-Mesh* mesh_create_plane(f32 width, f32 depth, u32 subdivisions) {
+MeshHandle mesh_create_plane(f32 width, f32 depth, u32 subdivisions) {
     u32 grid_size = subdivisions + 1;
     u32 vertex_count = grid_size * grid_size;
     u32 index_count = subdivisions * subdivisions * 6;
     
-    Vertex* vertices = (Vertex*)malloc(vertex_count * sizeof(Vertex));
-    u32* indices = (u32*)malloc(index_count * sizeof(u32));
+    Scratch scratch = scratch_begin();
+    Vertex* vertices = arena_push_array(scratch.arena, Vertex, vertex_count);
+    u32* indices = arena_push_array(scratch.arena, u32, index_count);
     
     if (!vertices || !indices) {
-        free(vertices);
-        free(indices);
-        return NULL;
+        scratch_end(scratch);
+        return (MeshHandle){INVALID_HANDLE};
     }
     
     f32 half_width = width / 2.0f;
@@ -178,25 +530,24 @@ Mesh* mesh_create_plane(f32 width, f32 depth, u32 subdivisions) {
         }
     }
     
-    Mesh* mesh = mesh_create(vertices, vertex_count, indices, index_count);
+    MeshHandle mesh = mesh_create(vertices, vertex_count, indices, index_count, MESH_VERTEX_COMPACT);
     
-    free(vertices);
-    free(indices);
+    scratch_end(scratch);
     
     return mesh;
 }
 
-Mesh* mesh_create_sphere(f32 radius, u32 rings, u32 segments) {
+MeshHandle mesh_create_sphere(f32 radius, u32 rings, u32 segments) {
     u32 vertex_count = (rings + 1) * (segments + 1);
     u32 index_count = rings * segments * 6;
     
-    Vertex* vertices = (Vertex*)malloc(vertex_count * sizeof(Vertex));
-    u32* indices = (u32*)malloc(index_count * sizeof(u32));
+    Scratch scratch = scratch_begin();
+    Vertex* vertices = arena_push_array(scratch.arena, Vertex, vertex_count);
+    u32* indices = arena_push_array(scratch.arena, u32, index_count);
     
     if (!vertices || !indices) {
-        free(vertices);
-        free(indices);
-        return NULL;
+        scratch_end(scratch);
+        return (MeshHandle){INVALID_HANDLE};
     }
     
     /* Generate vertices */
@@ -234,10 +585,10 @@ Mesh* mesh_create_sphere(f32 radius, u32 rings, u32 segments) {
         }
     }
     
-    Mesh* mesh = mesh_create(vertices, vertex_count, indices, index_count);
+    MeshHandle mesh = mesh_create_lods(vertices, vertex_count, indices, index_count, MESH_VERTEX_COMPACT,
+                                       MESH_DEFAULT_LODS);
     
-    free(vertices);
-    free(indices);
+    scratch_end(scratch);
     
     return mesh;
 }
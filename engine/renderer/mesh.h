@@ -4,6 +4,7 @@
 #include "../core/types.h"
 #include "../math/vec3.h"
 #include "../math/vec2.h"
+#include "../math/transform.h"
 
 /* Vertex structure */
 typedef struct {
@@ -12,26 +13,137 @@ typedef struct {
     Vec2 texcoord;
 } Vertex;
 
+/* How mesh_create stores vertices on the GPU. Meshes are always built from
+ * Vertex; the compact format is half the size at a small loss of precision:
+ *   position  3 x unorm16 across the mesh bounds (plus 2 bytes padding)
+ *   normal    2 x snorm16, octahedral
+ *   texcoord  2 x half float */
+typedef enum {
+    MESH_VERTEX_COMPACT,   /* 16 bytes */
+    MESH_VERTEX_FULL       /* 32 bytes, Vertex as given */
+} MeshVertexFormat;
+
+typedef struct {
+    u16 position[4];
+    i16 normal[2];
+    u16 texcoord[2];
+} CompactVertex;
+
+/* Vertex inputs and decoding for shaders that draw meshes of either
+ * format; the draw list sets the mesh* uniforms for each mesh */
+#define MESH_VERTEX_GLSL \
+    "layout (location = 0) in vec3 aPos;\n" \
+    "layout (location = 1) in vec3 aNormal;\n" \
+    "layout (location = 2) in vec2 aTexCoord;\n" \
+    "uniform vec3 meshPositionScale;\n" \
+    "uniform vec3 meshPositionOffset;\n" \
+    "uniform bool meshOctNormals;\n" \
+    "vec3 meshPosition() {\n" \
+    "    return meshPositionOffset + aPos * meshPositionScale;\n" \
+    "}\n" \
+    "vec3 meshNormal() {\n" \
+    "    if (!meshOctNormals) return aNormal;\n" \
+    "    vec3 n = vec3(aNormal.xy, 1.0 - abs(aNormal.x) - abs(aNormal.y));\n" \
+    "    float t = max(-n.z, 0.0);\n" \
+    "    n.x += n.x >= 0.0 ? -t : t;\n" \
+    "    n.y += n.y >= 0.0 ? -t : t;\n" \
+    "    return normalize(n);\n" \
+    "}\n"
+
+/* Per-instance attributes for mesh_draw_instanced. The vertex shader reads
+ * the model rows at locations 3-5 (as in a mat3x4 uniform, see Mat3x4)
+ * and the color at location 6. */
+#define MESH_INSTANCE_ATTRIB_MODEL 3
+#define MESH_INSTANCE_ATTRIB_COLOR 6
+
+typedef struct {
+    Mat3x4 model;
+    Color color;
+} MeshInstance;
+
+/* Levels of detail share the mesh's vertex buffer; each is a range of its
+ * index buffer, built by mesh_simplify with about half the triangles of
+ * the one before */
+#define MESH_MAX_LODS 5
+#define MESH_DEFAULT_LODS 4
+
+/* Largest geometric error a LOD may show, as a fraction of the viewport
+ * height, at LOD bias 1 (about a pixel at 1080p) */
+#define MESH_LOD_SCREEN_ERROR 0.001f
+
+typedef struct {
+    u32 first_index;
+    u32 index_count;
+    f32 error;              /* Furthest the surface moved, in mesh units */
+} MeshLod;
+
 /* Mesh structure */
 typedef struct {
     u32 vao;      /* Vertex Array Object */
     u32 vbo;      /* Vertex Buffer Object */
     u32 ebo;      /* Element Buffer Object */
+    u32 instance_vbo;       /* Created by the first instanced draw */
+    u32 instance_capacity;  /* Instances instance_vbo has room for */
     u32 vertex_count;
-    u32 index_count;
+    u32 index_count;        /* Of the full-detail LOD */
+    u32 index_size;         /* 2 bytes when vertex_count < 65536, else 4 */
+    MeshVertexFormat format;
+    /* Stored positions map to offset + value * scale (1 and 0 when full) */
+    Vec3 position_scale;
+    Vec3 position_offset;
+    /* Local-space bounds, computed at creation */
+    Vec3 bounds_min;
+    Vec3 bounds_max;
+    Vec3 bounds_center;
+    f32 bounds_radius;
+    MeshLod lods[MESH_MAX_LODS];
+    u32 lod_count;          /* At least 1; LOD 0 is the mesh as given */
 } Mesh;
 
-/* Mesh creation and destruction */
-Mesh* mesh_create(const Vertex* vertices, u32 vertex_count, 
-                  const u32* indices, u32 index_count);
-void mesh_destroy(Mesh* mesh);
+/* Meshes live in a pool owned by this module and are referred to by
+ * handle. mesh_create returns a null handle on failure; destroying a null
+ * or already-destroyed handle does nothing (the latter is reported). */
+MeshHandle mesh_create(const Vertex* vertices, u32 vertex_count, 
+                       const u32* indices, u32 index_count, MeshVertexFormat format);
+void mesh_destroy(MeshHandle mesh);
+
+/* mesh_create plus up to lod_count - 1 simplified LODs. The chain stops
+ * early once simplifying no longer removes a quarter of the triangles
+ * (open borders and seams don't move). */
+MeshHandle mesh_create_lods(const Vertex* vertices, u32 vertex_count,
+                            const u32* indices, u32 index_count, MeshVertexFormat format,
+                            u32 lod_count);
+
+/* Coarsest LOD whose error stays below MESH_LOD_SCREEN_ERROR * lod_bias on
+ * screen. screen_size is the projected diameter of the mesh's bounding
+ * sphere as a fraction of the viewport height. */
+u32 mesh_select_lod(const Mesh* mesh, f32 screen_size, f32 lod_bias);
+
+/* NULL once the mesh is destroyed. The pointer is good until the next
+ * mesh_create or mesh_destroy. */
+Mesh* mesh_get(MeshHandle mesh);
+u32 mesh_live_count(void);
+
+/* Free the pool, reporting and releasing meshes still alive; called by the
+ * engine at shutdown with the GL context current */
+void mesh_shutdown(void);
 
 /* Mesh rendering */
 void mesh_draw(const Mesh* mesh);
 
+/* mesh_draw in parts, for drawing one mesh several times with a single
+ * VAO bind: bind, draw as often as needed, then unbind */
+void mesh_bind(const Mesh* mesh);
+void mesh_draw_bound(const Mesh* mesh, u32 lod);
+void mesh_unbind(void);
+
+/* Draw count instances of a LOD with one call, streaming their attributes
+ * into the mesh's instance buffer. Needs a shader that reads MeshInstance. */
+void mesh_draw_instanced(Mesh* mesh, u32 lod, const MeshInstance* instances, u32 count);
+
 /* Primitive mesh creation */
-Mesh* mesh_create_cube(f32 size);
-Mesh* mesh_create_plane(f32 width, f32 depth, u32 subdivisions);
-Mesh* mesh_create_sphere(f32 radius, u32 rings, u32 segments);
+MeshHandle mesh_create_cube(f32 size);
+MeshHandle mesh_create_plane(f32 width, f32 depth, u32 subdivisions);
+MeshHandle mesh_create_sphere(f32 radius, u32 rings, u32 segments);
 
 #endif /* MESH_H */
@@ -0,0 +1,315 @@
+#include "mesh_simplify.h"
+#include "render_queue.h"
+#include "../core/arena.h"
+#include <math.h>
+#include <string.h>
+
+#define NO_VERTEX 0xFFFFFFFFu
+
+/* Attribute differences count as this fraction of the mesh extent per
+ * unit, so a small crease or UV stretch costs about as much as moving a
+ * vertex a small fraction of the mesh size */
+#define ATTRIBUTE_WEIGHT 0.02f
+
+/* Reject collapses that turn a triangle further than this (cosine) */
+#define MIN_NORMAL_DOT 0.2f
+
+/* Symmetric 4x4 plane quadric and the area it was built from */
+typedef struct {
+    f32 a00, a01, a02, a11, a12, a22;
+    f32 b0, b1, b2;
+    f32 c;
+    f32 weight;
+} Quadric;
+
+static void quadric_add_plane(Quadric* q, Vec3 n, f32 d, f32 weight) {
+    q->a00 += weight * n.x * n.x;
+    q->a01 += weight * n.x * n.y;
+    q->a02 += weight * n.x * n.z;
+    q->a11 += weight * n.y * n.y;
+    q->a12 += weight * n.y * n.z;
+    q->a22 += weight * n.z * n.z;
+    q->b0 += weight * n.x * d;
+    q->b1 += weight * n.y * d;
+    q->b2 += weight * n.z * d;
+    q->c += weight * d * d;
+    q->weight += weight;
+}
+
+static void quadric_add(Quadric* q, const Quadric* other) {
+    q->a00 += other->a00;
+    q->a01 += other->a01;
+    q->a02 += other->a02;
+    q->a11 += other->a11;
+    q->a12 += other->a12;
+    q->a22 += other->a22;
+    q->b0 += other->b0;
+    q->b1 += other->b1;
+    q->b2 += other->b2;
+    q->c += other->c;
+    q->weight += other->weight;
+}
+
+/* Mean squared distance of p from the quadric's planes */
+static f32 quadric_error(const Quadric* q, Vec3 p) {
+    f32 e = q->a00 * p.x * p.x + q->a11 * p.y * p.y + q->a22 * p.z * p.z +
+            2.0f * (q->a01 * p.x * p.y + q->a02 * p.x * p.z + q->a12 * p.y * p.z) +
+            2.0f * (q->b0 * p.x + q->b1 * p.y + q->b2 * p.z) + q->c;
+    if (e < 0.0f) e = 0.0f;
+    return q->weight > 0.0f ? e / q->weight : e;
+}
+
+static Vec3 triangle_normal(Vec3 a, Vec3 b, Vec3 c) {
+    return vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+}
+
+static u32 hash_u32(u32 x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    return x ^ (x >> 16);
+}
+
+static u32 hash_position(Vec3 p) {
+    u32 bits[3];
+    memcpy(bits, &p, sizeof(bits));
+    return hash_u32(bits[0] ^ hash_u32(bits[1] ^ hash_u32(bits[2])));
+}
+
+static u32 table_size(u32 count) {
+    u32 size = 16;
+    while (size < count * 2) size *= 2;
+    return size;
+}
+
+/* First vertex with each vertex's position; vertices that share a
+ * position with another are seams */
+static bool find_seams(const Vertex* vertices, u32 vertex_count, Arena* arena, bool* locked) {
+    u32 size = table_size(vertex_count);
+    u32* table = arena_push_array(arena, u32, size);
+    u32* first = arena_push_array(arena, u32, vertex_count);
+    if (!table || !first) return false;
+    for (u32 i = 0; i < size; i++) table[i] = NO_VERTEX;
+    
+    for (u32 v = 0; v < vertex_count; v++) {
+        Vec3 p = vertices[v].position;
+        u32 slot = hash_position(p) & (size - 1);
+        while (table[slot] != NO_VERTEX && memcmp(&vertices[table[slot]].position, &p, sizeof(Vec3)) != 0) {
+            slot = (slot + 1) & (size - 1);
+        }
+        if (table[slot] == NO_VERTEX) {
+            table[slot] = v;
+            first[v] = v;
+        } else {
+            first[v] = table[slot];
+            locked[v] = true;
+            locked[table[slot]] = true;
+        }
+    }
+    return true;
+}
+
+/* An edge with no twin running the other way bounds an open surface.
+ * Seam vertices are already locked, so edges are compared by vertex. */
+static bool find_borders(const u32* indices, u32 index_count, Arena* arena, bool* locked) {
+    u32 size = table_size(index_count);
+    u64* table = arena_push_array(arena, u64, size);
+    if (!table) return false;
+    memset(table, 0xFF, size * sizeof(u64));
+    
+    for (u32 i = 0; i < index_count; i++) {
+        u32 a = indices[i];
+        u32 b = indices[i % 3 == 2 ? i - 2 : i + 1];
+        u64 key = ((u64)a << 32) | b;
+        u32 slot = hash_u32(a * 0x9E3779B1u ^ b) & (size - 1);
+        while (table[slot] != ~0ull && table[slot] != key) slot = (slot + 1) & (size - 1);
+        table[slot] = key;
+    }
+    for (u32 i = 0; i < index_count; i++) {
+        u32 a = indices[i];
+        u32 b = indices[i % 3 == 2 ? i - 2 : i + 1];
+        u64 twin = ((u64)b << 32) | a;
+        u32 slot = hash_u32(b * 0x9E3779B1u ^ a) & (size - 1);
+        while (table[slot] != ~0ull && table[slot] != twin) slot = (slot + 1) & (size - 1);
+        if (table[slot] == ~0ull) {
+            locked[a] = true;
+            locked[b] = true;
+        }
+    }
+    return true;
+}
+
+static f32 attribute_error(const Vertex* a, const Vertex* b, f32 scale) {
+    Vec3 dn = vec3_sub(a->normal, b->normal);
+    f32 du = a->texcoord.x - b->texcoord.x;
+    f32 dv = a->texcoord.y - b->texcoord.y;
+    return (vec3_dot(dn, dn) + du * du + dv * dv) * scale * scale;
+}
+
+/* Would moving vertex from onto to turn any of its other triangles over? */
+static bool collapse_flips(const Vertex* vertices, const u32* indices, const u32* adjacency,
+                           u32 first, u32 count, u32 from, u32 to) {
+    Vec3 target = vertices[to].position;
+    for (u32 i = 0; i < count; i++) {
+        const u32* tri = &indices[adjacency[first + i] * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+        
+        Vec3 p[3];
+        for (u32 k = 0; k < 3; k++) p[k] = vertices[tri[k]].position;
+        Vec3 before = triangle_normal(p[0], p[1], p[2]);
+        for (u32 k = 0; k < 3; k++) {
+            if (tri[k] == from) p[k] = target;
+        }
+        Vec3 after = triangle_normal(p[0], p[1], p[2]);
+        
+        f32 dot = vec3_dot(before, after);
+        f32 lengths = sqrtf(vec3_dot(before, before) * vec3_dot(after, after));
+        if (dot <= MIN_NORMAL_DOT * lengths) return true;
+    }
+    return false;
+}
+
+/* Keeps the triangles that did not lose an edge, remapping collapsed
+ * vertices; returns the new index count */
+static u32 apply_collapses(u32* indices, u32 index_count, const u32* collapse) {
+    u32 count = 0;
+    for (u32 i = 0; i < index_count; i += 3) {
+        u32 a = collapse[indices[i]];
+        u32 b = collapse[indices[i + 1]];
+        u32 c = collapse[indices[i + 2]];
+        if (a == b || b == c || a == c) continue;
+        indices[count++] = a;
+        indices[count++] = b;
+        indices[count++] = c;
+    }
+    return count;
+}
+
+u32 mesh_simplify(const Vertex* vertices, u32 vertex_count, const u32* indices, u32 index_count,
+                  u32 target_index_count, f32 max_error, u32* out, f32* result_error) {
+    memcpy(out, indices, index_count * sizeof(u32));
+    *result_error = 0.0f;
+    if (index_count <= target_index_count || vertex_count == 0) return index_count;
+    
+    Scratch scratch = scratch_begin();
+    Arena* arena = scratch.arena;
+    Quadric* quadrics = arena_push_array(arena, Quadric, vertex_count);
+    bool* locked = arena_push_array(arena, bool, vertex_count);
+    bool* touched = arena_push_array(arena, bool, vertex_count);
+    u32* collapse = arena_push_array(arena, u32, vertex_count);
+    u32* adjacency_start = arena_push_array(arena, u32, vertex_count + 1);
+    u32* adjacency = arena_push_array(arena, u32, index_count);
+    RenderSortEntry* candidates = arena_push_array(arena, RenderSortEntry, index_count);
+    RenderSortEntry* sort_scratch = arena_push_array(arena, RenderSortEntry, index_count);
+    u32* candidate_targets = arena_push_array(arena, u32, index_count);
+    if (!quadrics || !locked || !touched || !collapse || !adjacency_start || !adjacency ||
+        !candidates || !sort_scratch || !candidate_targets) {
+        scratch_end(scratch);
+        return index_count;
+    }
+    
+    memset(quadrics, 0, vertex_count * sizeof(Quadric));
+    memset(locked, 0, vertex_count * sizeof(bool));
+    if (!find_seams(vertices, vertex_count, arena, locked) ||
+        !find_borders(indices, index_count, arena, locked)) {
+        scratch_end(scratch);
+        return index_count;
+    }
+    
+    Vec3 min = vertices[0].position;
+    Vec3 max = min;
+    for (u32 v = 1; v < vertex_count; v++) {
+        Vec3 p = vertices[v].position;
+        min = vec3_create(fminf(min.x, p.x), fminf(min.y, p.y), fminf(min.z, p.z));
+        max = vec3_create(fmaxf(max.x, p.x), fmaxf(max.y, p.y), fmaxf(max.z, p.z));
+    }
+    f32 attribute_scale = vec3_length(vec3_sub(max, min)) * ATTRIBUTE_WEIGHT;
+    
+    for (u32 i = 0; i < index_count; i += 3) {
+        Vec3 p0 = vertices[indices[i]].position;
+        Vec3 normal = triangle_normal(p0, vertices[indices[i + 1]].position,
+                                      vertices[indices[i + 2]].position);
+        f32 length = vec3_length(normal);
+        if (length <= 0.0f) continue;
+        Vec3 n = vec3_scale(normal, 1.0f / length);
+        for (u32 k = 0; k < 3; k++) {
+            quadric_add_plane(&quadrics[indices[i + k]], n, -vec3_dot(n, p0), length * 0.5f);
+        }
+    }
+    
+    f32 max_error_sq = max_error * max_error;
+    u32 count = index_count;
+    
+    /* Each pass collapses an independent set of the cheapest edges, so no
+     * two collapses in a pass touch the same triangle */
+    while (count > target_index_count) {
+        memset(adjacency_start, 0, (vertex_count + 1) * sizeof(u32));
+        for (u32 i = 0; i < count; i++) adjacency_start[out[i] + 1]++;
+        for (u32 v = 0; v < vertex_count; v++) adjacency_start[v + 1] += adjacency_start[v];
+        /* collapse doubles as the fill cursor until the collapses start */
+        for (u32 v = 0; v < vertex_count; v++) collapse[v] = adjacency_start[v];
+        for (u32 i = 0; i < count; i++) adjacency[collapse[out[i]]++] = i / 3;
+        
+        u32 candidate_count = 0;
+        for (u32 i = 0; i < count; i++) {
+            u32 from = out[i];
+            u32 to = out[i % 3 == 2 ? i - 2 : i + 1];
+            if (locked[from]) continue;
+            
+            f32 error = quadric_error(&quadrics[from], vertices[to].position) +
+                        attribute_error(&vertices[from], &vertices[to], attribute_scale);
+            if (error > max_error_sq) continue;
+            
+            /* Non-negative floats sort correctly by their bits */
+            u32 bits;
+            memcpy(&bits, &error, sizeof(bits));
+            candidates[candidate_count] = (RenderSortEntry){bits, candidate_count};
+            candidate_targets[candidate_count] = i;
+            candidate_count++;
+        }
+        if (candidate_count == 0) break;
+        render_queue_sort(candidates, sort_scratch, candidate_count);
+        
+        for (u32 v = 0; v < vertex_count; v++) {
+            collapse[v] = v;
+            touched[v] = false;
+        }
+        
+        /* A collapse removes about two triangles */
+        u32 wanted = (count - target_index_count) / 6 + 1;
+        u32 done = 0;
+        for (u32 c = 0; c < candidate_count && done < wanted; c++) {
+            u32 i = candidate_targets[candidates[c].item];
+            u32 from = out[i];
+            u32 to = out[i % 3 == 2 ? i - 2 : i + 1];
+            if (touched[from] || touched[to]) continue;
+            
+            u32 first = adjacency_start[from];
+            u32 valence = adjacency_start[from + 1] - first;
+            if (collapse_flips(vertices, out, adjacency, first, valence, from, to)) continue;
+            
+            collapse[from] = to;
+            quadric_add(&quadrics[to], &quadrics[from]);
+            for (u32 t = 0; t < valence; t++) {
+                const u32* tri = &out[adjacency[first + t] * 3];
+                touched[tri[0]] = true;
+                touched[tri[1]] = true;
+                touched[tri[2]] = true;
+            }
+            
+            f32 error;
+            u32 bits = (u32)candidates[c].key;
+            memcpy(&error, &bits, sizeof(error));
+            if (error > *result_error) *result_error = error;
+            done++;
+        }
+        if (done == 0) break;
+        
+        count = apply_collapses(out, count, collapse);
+    }
+    
+    *result_error = sqrtf(*result_error);
+    scratch_end(scratch);
+    return count;
+}
@@ -0,0 +1,27 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include "../core/types.h"
+#include "mesh.h"
+
+/* Triangle reduction by edge collapse with quadric error metrics (Garland
+ * and Heckbert). A vertex is only ever collapsed onto one of its
+ * neighbours, so the result indexes the same vertex array and a mesh's
+ * LODs can share one vertex buffer.
+ *
+ * Each vertex accumulates the area-weighted planes of its triangles; the
+ * cost of moving it is the mean squared distance from those planes, plus
+ * a penalty for the normal and texture coordinate change. Vertices on
+ * open borders and on attribute seams (one position, several vertices)
+ * never move, so outlines and UV charts stay closed. */
+
+/* Write the simplified indices to out, at most index_count of them,
+ * collapsing cheapest first while the error stays within max_error (mesh
+ * units). Stops at target_index_count, or a few indices under it, when
+ * collapses can reach it, and otherwise where none is left allowed.
+ * Returns the index count written; *result_error gets the largest error
+ * introduced. */
+u32 mesh_simplify(const Vertex* vertices, u32 vertex_count, const u32* indices, u32 index_count,
+                  u32 target_index_count, f32 max_error, u32* out, f32* result_error);
+
+#endif /* MESH_SIMPLIFY_H */
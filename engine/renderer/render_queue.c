@@ -0,0 +1,83 @@
+#include "render_queue.h"
+#include "../core/handle_pool.h"
+#include <string.h>
+
+#define KEY_SHADER_BITS 11
+#define KEY_MATERIAL_BITS 12
+#define KEY_MESH_BITS 16
+#define KEY_DEPTH_BITS 24
+
+static inline u64 key_field(u32 value, u32 bits) {
+    return (u64)(value & ((1u << bits) - 1));
+}
+
+/* The bit pattern of a non-negative float orders the same way as its
+ * value, so the top bits make a range-free fixed-point depth */
+static u32 depth_bits(f32 depth) {
+    if (!(depth > 0.0f)) return 0;
+    u32 bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    return bits >> (32 - KEY_DEPTH_BITS);
+}
+
+u64 render_queue_key(u32 shader_id, u32 material, u32 mesh_id, f32 depth, bool translucent) {
+    u64 shader = key_field(shader_id & (HANDLE_MAX_SLOTS - 1), KEY_SHADER_BITS);
+    u64 mat = key_field(material, KEY_MATERIAL_BITS);
+    u64 mesh = key_field(mesh_id & (HANDLE_MAX_SLOTS - 1), KEY_MESH_BITS);
+    u64 z = depth_bits(depth);
+
+    if (!translucent) {
+        return (shader << (KEY_MATERIAL_BITS + KEY_MESH_BITS + KEY_DEPTH_BITS)) |
+               (mat << (KEY_MESH_BITS + KEY_DEPTH_BITS)) |
+               (mesh << KEY_DEPTH_BITS) |
+               z;
+    }
+
+    u64 far_first = key_field(~(u32)z, KEY_DEPTH_BITS);
+    return (1ull << 63) |
+           (far_first << (KEY_SHADER_BITS + KEY_MATERIAL_BITS + KEY_MESH_BITS)) |
+           (shader << (KEY_MATERIAL_BITS + KEY_MESH_BITS)) |
+           (mat << KEY_MESH_BITS) |
+           mesh;
+}
+
+void render_queue_sort(RenderSortEntry* entries, RenderSortEntry* scratch, u32 count) {
+    if (count < 2) return;
+
+    /* Byte histograms for all eight passes in one sweep */
+    u32 counts[8][256];
+    memset(counts, 0, sizeof(counts));
+    for (u32 i = 0; i < count; i++) {
+        u64 key = entries[i].key;
+        for (u32 b = 0; b < 8; b++) {
+            counts[b][(key >> (b * 8)) & 0xFF]++;
+        }
+    }
+
+    RenderSortEntry* src = entries;
+    RenderSortEntry* dst = scratch;
+    for (u32 b = 0; b < 8; b++) {
+        /* Nothing to reorder when every key has the same byte here */
+        u32 first_byte = (u32)(src[0].key >> (b * 8)) & 0xFF;
+        if (counts[b][first_byte] == count) continue;
+
+        u32 offsets[256];
+        u32 sum = 0;
+        for (u32 v = 0; v < 256; v++) {
+            offsets[v] = sum;
+            sum += counts[b][v];
+        }
+        for (u32 i = 0; i < count; i++) {
+            u32 byte = (u32)(src[i].key >> (b * 8)) & 0xFF;
+            dst[offsets[byte]++] = src[i];
+        }
+
+        RenderSortEntry* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != entries) {
+        memcpy(entries, src, count * sizeof(RenderSortEntry));
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "../core/types.h"
+
+/* Sort keys for draw submission. Every draw gets a 64-bit key that packs
+ * the state it needs, most expensive to change in the highest bits, and
+ * the draws are radix-sorted by it before submission:
+ *
+ *   opaque       0 | shader:11 | material:12 | mesh:16 | depth:24
+ *   translucent  1 | ~depth:24 | shader:11 | material:12 | mesh:16
+ *
+ * Opaque draws come first, grouped by shader, material and mesh so each
+ * is bound once, and front to back within a group so early depth testing
+ * rejects hidden pixels. Translucent draws follow, back to front, which
+ * blending needs more than it needs fewer state changes.
+ *
+ * Shaders and meshes are keyed by their pool slot; materials by a 12-bit
+ * id the caller derives from the material's state. */
+
+typedef struct {
+    u64 key;
+    u32 item;      /* Caller's index of the draw */
+} RenderSortEntry;
+
+/* depth is any non-negative value that grows away from the camera, such
+ * as squared distance; only its ordering matters */
+u64 render_queue_key(u32 shader_id, u32 material, u32 mesh_id, f32 depth, bool translucent);
+
+static inline bool render_queue_key_translucent(u64 key) {
+    return (key >> 63) != 0;
+}
+
+/* Stable LSD radix sort by key, eight bits per pass; passes in which every
+ * key has the same byte are skipped. scratch must hold count entries. */
+void render_queue_sort(RenderSortEntry* entries, RenderSortEntry* scratch, u32 count);
+
+#endif /* RENDER_QUEUE_H */
@@ -0,0 +1,179 @@
+#include "render_thread.h"
+#include "../core/thread.h"
+#include "../core/profiler.h"
+#include "../core/timer.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+/* Commands each list starts with; lists grow as needed and keep their size */
+#define RENDER_THREAD_INITIAL_COMMANDS 256
+
+struct RenderThread {
+    RenderContext context;
+    Thread thread;
+    Mutex mutex;
+    Cond submitted_cond;      /* Signalled when a list is submitted or on stop */
+    Cond completed_cond;      /* Signalled when a list has been presented */
+    DrawList lists[RENDER_THREAD_MAX_QUEUE_DEPTH + 1];
+    u32 list_count;
+    u64 submitted;            /* Lists handed over; the next to fill is submitted % list_count */
+    u64 completed;            /* Lists presented; the next to draw is completed % list_count */
+    u64 untaken_ns;           /* Render time not yet collected by take_frame_time */
+    u32 untaken_frames;
+    u64 untaken_input_ns;     /* Input age at present, summed over lists that had input */
+    u32 untaken_input_frames;
+    bool running;
+};
+
+static void render_thread_main(void* data) {
+    RenderThread* render_thread = (RenderThread*)data;
+    RenderContext* context = &render_thread->context;
+    PROFILE_THREAD_NAME("Render");
+
+    if (context->bind) context->bind(context->user);
+
+    mutex_lock(&render_thread->mutex);
+    for (;;) {
+        while (render_thread->running && render_thread->completed == render_thread->submitted) {
+            cond_wait(&render_thread->submitted_cond, &render_thread->mutex);
+        }
+        /* Stopping only once everything submitted has been drawn */
+        if (render_thread->completed == render_thread->submitted) break;
+
+        DrawList* list = &render_thread->lists[render_thread->completed % render_thread->list_count];
+        mutex_unlock(&render_thread->mutex);
+
+        PROFILE_BEGIN("render_frame");
+        u64 start_ns = timer_now_ns();
+        draw_list_execute(list);
+        if (context->present) context->present(context->user);
+        u64 end_ns = timer_now_ns();
+        PROFILE_END();
+
+        mutex_lock(&render_thread->mutex);
+        render_thread->untaken_ns += end_ns - start_ns;
+        render_thread->untaken_frames++;
+        if (list->input_time_ns) {
+            render_thread->untaken_input_ns += end_ns - list->input_time_ns;
+            render_thread->untaken_input_frames++;
+        }
+        render_thread->completed++;
+        cond_signal(&render_thread->completed_cond);
+    }
+    mutex_unlock(&render_thread->mutex);
+
+    if (context->unbind) context->unbind(context->user);
+}
+
+RenderThread* render_thread_create(const RenderContext* context, u32 queue_depth) {
+    RenderThread* render_thread = (RenderThread*)calloc(1, sizeof(RenderThread));
+    if (!render_thread) return NULL;
+
+    if (queue_depth < 1) queue_depth = 1;
+    if (queue_depth > RENDER_THREAD_MAX_QUEUE_DEPTH) queue_depth = RENDER_THREAD_MAX_QUEUE_DEPTH;
+    render_thread->list_count = queue_depth + 1;
+    render_thread->context = *context;
+    render_thread->running = true;
+
+    for (u32 i = 0; i < render_thread->list_count; i++) {
+        if (!draw_list_init(&render_thread->lists[i], RENDER_THREAD_INITIAL_COMMANDS)) {
+            fprintf(stderr, "Failed to allocate draw list\n");
+            for (u32 j = 0; j <= i; j++) {
+                draw_list_free(&render_thread->lists[j]);
+            }
+            free(render_thread);
+            return NULL;
+        }
+    }
+
+    mutex_init(&render_thread->mutex);
+    cond_init(&render_thread->submitted_cond);
+    cond_init(&render_thread->completed_cond);
+
+    /* A context can only be current on one thread at a time */
+    if (context->unbind) context->unbind(context->user);
+
+    if (!thread_start(&render_thread->thread, render_thread_main, render_thread)) {
+        fprintf(stderr, "Failed to start render thread\n");
+        if (context->bind) context->bind(context->user);
+        cond_destroy(&render_thread->completed_cond);
+        cond_destroy(&render_thread->submitted_cond);
+        mutex_destroy(&render_thread->mutex);
+        for (u32 i = 0; i < render_thread->list_count; i++) {
+            draw_list_free(&render_thread->lists[i]);
+        }
+        free(render_thread);
+        return NULL;
+    }
+
+    return render_thread;
+}
+
+void render_thread_destroy(RenderThread* render_thread) {
+    if (!render_thread) return;
+
+    mutex_lock(&render_thread->mutex);
+    render_thread->running = false;
+    cond_signal(&render_thread->submitted_cond);
+    mutex_unlock(&render_thread->mutex);
+
+    thread_join(&render_thread->thread);
+
+    RenderContext* context = &render_thread->context;
+    if (context->bind) context->bind(context->user);
+
+    cond_destroy(&render_thread->completed_cond);
+    cond_destroy(&render_thread->submitted_cond);
+    mutex_destroy(&render_thread->mutex);
+    for (u32 i = 0; i < render_thread->list_count; i++) {
+        draw_list_free(&render_thread->lists[i]);
+    }
+    free(render_thread);
+}
+
+DrawList* render_thread_acquire(RenderThread* render_thread) {
+    mutex_lock(&render_thread->mutex);
+    /* Up to queue_depth lists submitted and not yet presented; the extra
+     * buffer is the one handed out here for recording */
+    while (render_thread->submitted - render_thread->completed >= render_thread->list_count - 1) {
+        cond_wait(&render_thread->completed_cond, &render_thread->mutex);
+    }
+    DrawList* list = &render_thread->lists[render_thread->submitted % render_thread->list_count];
+    mutex_unlock(&render_thread->mutex);
+
+    draw_list_reset(list);
+    return list;
+}
+
+void render_thread_submit(RenderThread* render_thread, DrawList* list) {
+    mutex_lock(&render_thread->mutex);
+    if (list == &render_thread->lists[render_thread->submitted % render_thread->list_count]) {
+        render_thread->submitted++;
+        cond_signal(&render_thread->submitted_cond);
+    }
+    mutex_unlock(&render_thread->mutex);
+}
+
+u32 render_thread_queue_depth(const RenderThread* render_thread) {
+    return render_thread->list_count - 1;
+}
+
+bool render_thread_take_frame_time(RenderThread* render_thread, f64* ms) {
+    mutex_lock(&render_thread->mutex);
+    bool any = render_thread->untaken_frames > 0;
+    *ms = (f64)render_thread->untaken_ns * 1e-6;
+    render_thread->untaken_ns = 0;
+    render_thread->untaken_frames = 0;
+    mutex_unlock(&render_thread->mutex);
+    return any;
+}
+
+bool render_thread_take_input_latency(RenderThread* render_thread, f64* ms) {
+    mutex_lock(&render_thread->mutex);
+    u32 frames = render_thread->untaken_input_frames;
+    *ms = frames ? (f64)render_thread->untaken_input_ns * 1e-6 / frames : 0.0;
+    render_thread->untaken_input_ns = 0;
+    render_thread->untaken_input_frames = 0;
+    mutex_unlock(&render_thread->mutex);
+    return frames > 0;
+}
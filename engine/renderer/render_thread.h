@@ -0,0 +1,57 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include "../core/types.h"
+#include "draw_list.h"
+
+/* Dedicated thread that owns the GL context and executes draw lists, so
+ * the game thread can simulate frame N+1 while frame N is submitted.
+ *
+ * Draw lists cycle through a ring of queue_depth + 1 buffers: the game
+ * thread fills one while the render thread works through up to
+ * queue_depth submitted ones. Acquiring a list blocks once the game thread
+ * is that far ahead; deeper queues smooth out hitches at the cost of
+ * input-to-display latency. */
+
+#define RENDER_THREAD_MAX_QUEUE_DEPTH 3
+
+/* Windowing-layer hooks; called on the render thread except where noted.
+ * Any may be NULL (headless). */
+typedef struct {
+    void (*bind)(void* user);     /* Make the context current on the calling thread */
+    void (*unbind)(void* user);   /* Release it; also called on the creating thread */
+    void (*present)(void* user);  /* Swap buffers after each list */
+    void* user;
+} RenderContext;
+
+typedef struct RenderThread RenderThread;
+
+/* Call on the thread that holds the context; the context moves to the
+ * render thread. queue_depth is clamped to [1, RENDER_THREAD_MAX_QUEUE_DEPTH]. */
+RenderThread* render_thread_create(const RenderContext* context, u32 queue_depth);
+
+/* Finish every submitted list, stop the thread and make the context
+ * current on the calling thread again */
+void render_thread_destroy(RenderThread* render_thread);
+
+/* List for the next frame, reset and ready to record; blocks while
+ * queue_depth lists are submitted and not yet presented, so the game
+ * thread never records more than queue_depth frames ahead of the display.
+ * Game thread only. */
+DrawList* render_thread_acquire(RenderThread* render_thread);
+
+/* Hand the acquired list to the render thread; it must not be touched
+ * again until acquired again */
+void render_thread_submit(RenderThread* render_thread, DrawList* list);
+
+u32 render_thread_queue_depth(const RenderThread* render_thread);
+
+/* Time spent executing and presenting the lists completed since the last
+ * call, in milliseconds; false if none completed */
+bool render_thread_take_frame_time(RenderThread* render_thread, f64* ms);
+
+/* Mean time from DrawList.input_time_ns to present over the lists completed
+ * since the last call that carried input; false if none did */
+bool render_thread_take_input_latency(RenderThread* render_thread, f64* ms);
+
+#endif /* RENDER_THREAD_H */
@@ -0,0 +1,11 @@
+#include "renderer.h"
+
+static bool g_headless = false;
+
+void renderer_set_headless(bool headless) {
+    g_headless = headless;
+}
+
+bool renderer_is_headless(void) {
+    return g_headless;
+}
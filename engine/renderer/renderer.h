@@ -0,0 +1,13 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "../core/types.h"
+#include <stdbool.h>
+
+/* Rendering backend state shared by the renderer modules. In headless mode
+ * there is no GL context: meshes and shaders become CPU-only handles and
+ * draw calls are no-ops. Set by the engine at creation. */
+void renderer_set_headless(bool headless);
+bool renderer_is_headless(void);
+
+#endif /* RENDERER_H */
@@ -1,19 +1,50 @@
 #include "shader.h"
+#include "renderer.h"
+#include "frame_uniforms.h"
+#include "shader_cache.h"
+#include "../core/handle_pool.h"
+#include "../core/timer.h"
 #include <glad/glad.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-static u32 compile_shader(const char* source, GLenum type) {
-    u32 shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
+/* Sources get the defines right after their #version line, which has to
+ * stay first */
+static void set_source(u32 shader, const char* source, const char* defines) {
+    if (!defines || !*defines) {
+        glShaderSource(shader, 1, &source, NULL);
+        return;
+    }
     
+    const char* body = source;
+    if (strncmp(source, "#version", 8) == 0) {
+        const char* newline = strchr(source, '\n');
+        body = newline ? newline + 1 : source + strlen(source);
+    }
+    const char* strings[3] = { source, defines, body };
+    const i32 lengths[3] = { (i32)(body - source), -1, -1 };
+    glShaderSource(shader, 3, strings, lengths);
+}
+
+/* Report a failed compile; true if it compiled */
+static bool check_compiled(u32 shader) {
     i32 success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success) {
         char info_log[512];
         glGetShaderInfoLog(shader, 512, NULL, info_log);
         fprintf(stderr, "Shader compilation error: %s\n", info_log);
+    }
+    return success != 0;
+}
+
+static u32 compile_shader(const char* source, const char* defines, GLenum type) {
+    u32 shader = glCreateShader(type);
+    set_source(shader, source, defines);
+    glCompileShader(shader);
+    
+    if (!check_compiled(shader)) {
         glDeleteShader(shader);
         return 0;
     }
@@ -21,74 +52,552 @@ static u32 compile_shader(const char* source, GLenum type) {
     return shader;
 }
 
-Shader* shader_create(const char* vertex_source, const char* fragment_source) {
-    Shader* shader = (Shader*)malloc(sizeof(Shader));
-    if (!shader) return NULL;
-    
-    u32 vertex_shader = compile_shader(vertex_source, GL_VERTEX_SHADER);
-    u32 fragment_shader = compile_shader(fragment_source, GL_FRAGMENT_SHADER);
+static HandlePool g_shaders;
+static bool g_shaders_ready = false;
+static bool g_parallel_compile = false;   /* GL_KHR_parallel_shader_compile is on */
+static bool g_cache_reported = false;
+
+typedef enum {
+    VARIANT_EMPTY,        /* Free slot of the table */
+    VARIANT_BUILDING,     /* Compiling and linking on driver threads */
+    VARIANT_READY,
+    VARIANT_FAILED
+} VariantStatus;
+
+typedef struct {
+    u32 features;
+    VariantStatus status;
+    u32 vertex_shader;       /* Held while building, for the error logs */
+    u32 fragment_shader;
+    u64 cache_key;
+    u64 build_start;
+    u64 seen_building;       /* Last poll that found it still compiling */
+    Shader shader;
+} ShaderVariant;
+
+struct ShaderVariants {
+    char* vertex_source;
+    char* fragment_source;
+    char* feature_names[SHADER_MAX_FEATURES];
+    u32 feature_count;
+    u32 interface_features;  /* Stand-ins must match these exactly */
+    ShaderVariant* table;    /* Open addressing on the mask; at most half full */
+    u32 capacity;            /* Power of two */
+    u32 count;
+};
+
+/* Compile and link; 0 on failure */
+static u32 link_program(const char* vertex_source, const char* fragment_source, const char* defines) {
+    u32 vertex_shader = compile_shader(vertex_source, defines, GL_VERTEX_SHADER);
+    u32 fragment_shader = compile_shader(fragment_source, defines, GL_FRAGMENT_SHADER);
     
     if (!vertex_shader || !fragment_shader) {
         if (vertex_shader) glDeleteShader(vertex_shader);
         if (fragment_shader) glDeleteShader(fragment_shader);
-        free(shader);
-        return NULL;
+        return 0;
     }
     
-    shader->program = glCreateProgram();
-    glAttachShader(shader->program, vertex_shader);
-    glAttachShader(shader->program, fragment_shader);
-    glLinkProgram(shader->program);
+    u32 program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    shader_cache_prepare(program);
+    glLinkProgram(program);
     
     i32 success;
-    glGetProgramiv(shader->program, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
         char info_log[512];
-        glGetProgramInfoLog(shader->program, 512, NULL, info_log);
+        glGetProgramInfoLog(program, 512, NULL, info_log);
         fprintf(stderr, "Shader link error: %s\n", info_log);
-        glDeleteProgram(shader->program);
-        free(shader);
-        shader = NULL;
+        glDeleteProgram(program);
+        program = 0;
     }
     
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
     
-    return shader;
+    return program;
+}
+
+/* Record where each active uniform lives and attach the frame uniform
+ * block, if the program declares it, to its shared binding */
+static void resolve_uniforms(Shader* shader) {
+    u32 program = shader->program;
+    shader->uniform_count = 0;
+    
+    i32 active = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &active);
+    for (i32 i = 0; i < active; i++) {
+        char name[128];
+        i32 size;
+        GLenum type;
+        glGetActiveUniform(program, (u32)i, sizeof(name), NULL, &size, &type, name);
+        
+        /* Members of uniform blocks have no location */
+        i32 location = glGetUniformLocation(program, name);
+        if (location < 0) continue;
+        if (shader->uniform_count == SHADER_MAX_UNIFORMS) {
+            fprintf(stderr, "Shader has more than %d uniforms; ignoring %s\n",
+                    SHADER_MAX_UNIFORMS, name);
+            continue;
+        }
+        
+        char* bracket = strchr(name, '[');
+        if (bracket) *bracket = '\0';
+        ShaderUniform* uniform = &shader->uniforms[shader->uniform_count++];
+        uniform->hash = uniform_id(name).hash;
+        uniform->location = location;
+    }
+    
+    u32 block = glGetUniformBlockIndex(program, FRAME_UNIFORMS_BLOCK);
+    if (block != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, block, FRAME_UNIFORMS_BINDING);
+    }
+}
+
+/* From the program cache when it has these sources, else compiled,
+ * linked and added to it; 0 on failure */
+static u32 build_program(const char* vertex_source, const char* fragment_source) {
+    const char* parts[] = { vertex_source, fragment_source };
+    u64 key = shader_cache_key(parts, 2);
+    u32 program = shader_cache_load(key);
+    if (program) return program;
+    
+    u64 start = timer_now_ns();
+    program = link_program(vertex_source, fragment_source, NULL);
+    if (program) shader_cache_store(key, program, timer_now_ns() - start);
+    return program;
 }
 
-void shader_destroy(Shader* shader) {
-    if (!shader) return;
-    glDeleteProgram(shader->program);
-    free(shader);
+static bool shaders_ready(void) {
+    if (!g_shaders_ready) {
+        g_shaders_ready = handle_pool_init(&g_shaders, sizeof(Shader), 16, "Shader");
+    }
+    return g_shaders_ready;
+}
+
+ShaderHandle shader_create(const char* vertex_source, const char* fragment_source) {
+    ShaderHandle handle = {INVALID_HANDLE};
+    if (!shaders_ready()) return handle;
+    
+    /* Headless: a null program; use and the setters become no-ops */
+    u32 program = 0;
+    if (!renderer_is_headless()) {
+        program = build_program(vertex_source, fragment_source);
+        if (!program) return handle;
+    }
+    
+    Shader* shader = (Shader*)handle_pool_alloc(&g_shaders, &handle.id);
+    if (!shader) {
+        if (program) glDeleteProgram(program);
+        return handle;
+    }
+    shader->program = program;
+    if (program) resolve_uniforms(shader);
+    return handle;
+}
+
+/* "#define NAME\n" for each feature in the mask */
+static void feature_defines(const ShaderVariants* variants, u32 features, char* defines, size_t size) {
+    size_t length = 0;
+    defines[0] = '\0';
+    for (u32 i = 0; i < variants->feature_count; i++) {
+        if (!(features & (1u << i))) continue;
+        i32 written = snprintf(defines + length, size - length, "#define %s\n", variants->feature_names[i]);
+        if (written < 0 || (size_t)written >= size - length) break;
+        length += (size_t)written;
+    }
+}
+
+/* Check a finished build and read its uniforms, or report what failed.
+ * Waits for the driver if it is still compiling; waited says whether it
+ * may be, i.e. whether the build ends with this call or was already seen
+ * done by a poll. */
+static void finish_variant(const ShaderVariants* variants, ShaderVariant* variant, bool waited) {
+    u32 program = variant->shader.program;
+    i32 success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    
+    /* A poll only shows the build ended since the previous one, so its
+     * time is taken up to that one: at most a frame short with polls every
+     * frame, and never counting whatever ran in between as compiling */
+    u64 built = waited ? timer_now_ns() : variant->seen_building;
+    if (success) {
+        resolve_uniforms(&variant->shader);
+        variant->status = VARIANT_READY;
+        shader_cache_store(variant->cache_key, program, built - variant->build_start);
+    } else {
+        char defines[SHADER_MAX_FEATURES * (SHADER_FEATURE_NAME_MAX + 9)];
+        feature_defines(variants, variant->features, defines, sizeof(defines));
+        fprintf(stderr, "Shader variant failed to build with:\n%s", defines);
+        bool compiled = check_compiled(variant->vertex_shader);
+        compiled = check_compiled(variant->fragment_shader) && compiled;
+        if (compiled) {
+            char info_log[512];
+            glGetProgramInfoLog(program, 512, NULL, info_log);
+            fprintf(stderr, "Shader link error: %s\n", info_log);
+        }
+        glDeleteProgram(program);
+        variant->shader.program = 0;
+        variant->status = VARIANT_FAILED;
+    }
+    
+    glDeleteShader(variant->vertex_shader);
+    glDeleteShader(variant->fragment_shader);
+    variant->vertex_shader = 0;
+    variant->fragment_shader = 0;
+}
+
+/* Load the variant from the program cache or set the driver compiling it.
+ * Without parallel compilation the first status query would block anyway,
+ * so it is finished straight away. */
+static void start_variant(const ShaderVariants* variants, ShaderVariant* variant) {
+    /* Headless: a null program, like shader_create */
+    if (renderer_is_headless()) {
+        variant->status = VARIANT_READY;
+        return;
+    }
+    
+    char defines[SHADER_MAX_FEATURES * (SHADER_FEATURE_NAME_MAX + 9)];
+    feature_defines(variants, variant->features, defines, sizeof(defines));
+    const char* parts[] = { variants->vertex_source, variants->fragment_source, defines };
+    variant->cache_key = shader_cache_key(parts, 3);
+    u32 program = shader_cache_load(variant->cache_key);
+    if (program) {
+        variant->shader.program = program;
+        resolve_uniforms(&variant->shader);
+        variant->status = VARIANT_READY;
+        return;
+    }
+    
+    variant->build_start = timer_now_ns();
+    variant->seen_building = variant->build_start;
+    variant->vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    set_source(variant->vertex_shader, variants->vertex_source, defines);
+    glCompileShader(variant->vertex_shader);
+    variant->fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    set_source(variant->fragment_shader, variants->fragment_source, defines);
+    glCompileShader(variant->fragment_shader);
+    
+    program = glCreateProgram();
+    glAttachShader(program, variant->vertex_shader);
+    glAttachShader(program, variant->fragment_shader);
+    shader_cache_prepare(program);
+    glLinkProgram(program);
+    variant->shader.program = program;
+    variant->status = VARIANT_BUILDING;
+    
+    if (!g_parallel_compile) finish_variant(variants, variant, true);
+}
+
+/* Finish the variant if the driver is done with it; true unless it is
+ * still building */
+static bool poll_variant(const ShaderVariants* variants, ShaderVariant* variant) {
+    if (variant->status != VARIANT_BUILDING) return true;
+    
+    i32 done = GL_FALSE;
+    glGetProgramiv(variant->shader.program, GL_COMPLETION_STATUS_KHR, &done);
+    if (!done) {
+        variant->seen_building = timer_now_ns();
+        return false;
+    }
+    finish_variant(variants, variant, false);
+    return true;
+}
+
+/* Finish the variant, blocking until the driver is done with it */
+static void wait_variant(const ShaderVariants* variants, ShaderVariant* variant) {
+    if (!poll_variant(variants, variant)) finish_variant(variants, variant, true);
+}
+
+/* The variant for features, or the empty slot it goes in */
+static ShaderVariant* find_variant(const ShaderVariants* variants, u32 features) {
+    u32 mask = variants->capacity - 1;
+    u32 hash = features * 2654435761u;
+    for (u32 i = (hash ^ (hash >> 16)) & mask;; i = (i + 1) & mask) {
+        ShaderVariant* variant = &variants->table[i];
+        if (variant->status == VARIANT_EMPTY || variant->features == features) return variant;
+    }
+}
+
+/* Double the table; pointers to variants go stale */
+static bool grow_variants(ShaderVariants* variants) {
+    ShaderVariant* old_table = variants->table;
+    u32 old_capacity = variants->capacity;
+    ShaderVariant* table = (ShaderVariant*)calloc(old_capacity * 2, sizeof(ShaderVariant));
+    if (!table) return false;
+    
+    variants->table = table;
+    variants->capacity = old_capacity * 2;
+    for (u32 i = 0; i < old_capacity; i++) {
+        if (old_table[i].status != VARIANT_EMPTY) {
+            *find_variant(variants, old_table[i].features) = old_table[i];
+        }
+    }
+    free(old_table);
+    return true;
+}
+
+/* The variant for features, started if it is new; NULL if out of memory */
+static ShaderVariant* request_variant(ShaderVariants* variants, u32 features) {
+    features &= (1u << variants->feature_count) - 1;
+    ShaderVariant* variant = find_variant(variants, features);
+    if (variant->status != VARIANT_EMPTY) return variant;
+    
+    if ((variants->count + 1) * 2 > variants->capacity) {
+        if (!grow_variants(variants)) return NULL;
+        variant = find_variant(variants, features);
+    }
+    variants->count++;
+    variant->features = features;
+    start_variant(variants, variant);
+    return variant;
+}
+
+static void free_variants(ShaderVariants* variants) {
+    if (!variants) return;
+    
+    for (u32 i = 0; variants->table && i < variants->capacity; i++) {
+        ShaderVariant* variant = &variants->table[i];
+        if (variant->vertex_shader) glDeleteShader(variant->vertex_shader);
+        if (variant->fragment_shader) glDeleteShader(variant->fragment_shader);
+        if (variant->shader.program) glDeleteProgram(variant->shader.program);
+    }
+    free(variants->table);
+    free(variants->vertex_source);
+    free(variants->fragment_source);
+    for (u32 i = 0; i < variants->feature_count; i++) {
+        free(variants->feature_names[i]);
+    }
+    free(variants);
+}
+
+static char* copy_string(const char* text) {
+    size_t size = strlen(text) + 1;
+    char* copy = (char*)malloc(size);
+    if (copy) memcpy(copy, text, size);
+    return copy;
+}
+
+ShaderHandle shader_create_variants(const char* vertex_source, const char* fragment_source,
+                                    const char* const* feature_names, u32 feature_count,
+                                    u32 interface_features) {
+    ShaderHandle handle = {INVALID_HANDLE};
+    if (feature_count > SHADER_MAX_FEATURES) {
+        fprintf(stderr, "Shader has %u features; at most %d are supported\n",
+                feature_count, SHADER_MAX_FEATURES);
+        return handle;
+    }
+    for (u32 i = 0; i < feature_count; i++) {
+        if (!feature_names[i] || !*feature_names[i] || strlen(feature_names[i]) >= SHADER_FEATURE_NAME_MAX) {
+            fprintf(stderr, "Shader feature %u needs a name shorter than %d characters\n",
+                    i, SHADER_FEATURE_NAME_MAX);
+            return handle;
+        }
+    }
+    if (!shaders_ready()) return handle;
+    
+    /* Sources and names are copied, since variants build long after this */
+    ShaderVariants* variants = (ShaderVariants*)calloc(1, sizeof(ShaderVariants));
+    if (!variants) return handle;
+    variants->capacity = 8;
+    variants->table = (ShaderVariant*)calloc(variants->capacity, sizeof(ShaderVariant));
+    variants->vertex_source = copy_string(vertex_source);
+    variants->fragment_source = copy_string(fragment_source);
+    bool copied = variants->table && variants->vertex_source && variants->fragment_source;
+    for (u32 i = 0; i < feature_count; i++) {
+        variants->feature_names[i] = copy_string(feature_names[i]);
+        copied = copied && variants->feature_names[i];
+    }
+    variants->feature_count = feature_count;
+    variants->interface_features = interface_features;
+    
+    Shader* shader = copied ? (Shader*)handle_pool_alloc(&g_shaders, &handle.id) : NULL;
+    if (!shader) {
+        free_variants(variants);
+        return handle;
+    }
+    shader->variants = variants;
+    
+    /* Let the driver use as many compiler threads as it likes */
+    if (!g_parallel_compile && !renderer_is_headless() && GLAD_GL_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        g_parallel_compile = true;
+    }
+    return handle;
+}
+
+void shader_prepare_variants(ShaderHandle handle, const u32* feature_masks, u32 count) {
+    Shader* shader = shader_get(handle);
+    if (!shader || !shader->variants) return;
+    
+    for (u32 i = 0; i < count; i++) {
+        request_variant(shader->variants, feature_masks[i]);
+    }
+}
+
+/* Delete the program, or every variant's */
+static void release_shader(Shader* shader) {
+    if (shader->program) glDeleteProgram(shader->program);
+    free_variants(shader->variants);
+    shader->variants = NULL;
+}
+
+void shader_destroy(ShaderHandle handle) {
+    if (!g_shaders_ready || !HANDLE_IS_VALID(handle)) return;
+    
+    Shader* shader = (Shader*)handle_pool_get(&g_shaders, handle.id);
+    if (shader) release_shader(shader);
+    handle_pool_release(&g_shaders, handle.id);
+}
+
+Shader* shader_get(ShaderHandle handle) {
+    return g_shaders_ready ? (Shader*)handle_pool_get(&g_shaders, handle.id) : NULL;
+}
+
+Shader* shader_get_variant(ShaderHandle handle, u32 features) {
+    Shader* shader = shader_get(handle);
+    if (!shader || !shader->variants) return shader;
+    
+    ShaderVariant* variant = request_variant(shader->variants, features);
+    if (!variant) return NULL;
+    wait_variant(shader->variants, variant);
+    return variant->status == VARIANT_READY ? &variant->shader : NULL;
+}
+
+u32 shader_poll_variants(void) {
+    u32 building = 0;
+    u32 count = g_shaders_ready ? handle_pool_count(&g_shaders) : 0;
+    for (u32 i = 0; i < count; i++) {
+        ShaderVariants* variants = ((Shader*)handle_pool_item_at(&g_shaders, i))->variants;
+        for (u32 v = 0; variants && v < variants->capacity; v++) {
+            if (!poll_variant(variants, &variants->table[v])) building++;
+        }
+    }
+    
+    /* Startup's compiling is over once nothing is left building */
+    if (building == 0 && !g_cache_reported) {
+        shader_cache_report();
+        g_cache_reported = true;
+    }
+    return building;
+}
+
+/* Bits set in a mask */
+static u32 feature_bits(u32 features) {
+    u32 bits = 0;
+    for (; features; features &= features - 1) bits++;
+    return bits;
+}
+
+Shader* shader_select_variant(ShaderHandle handle, u32 features) {
+    Shader* shader = shader_get(handle);
+    if (!shader || !shader->variants) return shader;
+    
+    ShaderVariants* variants = shader->variants;
+    ShaderVariant* variant = request_variant(variants, features);
+    if (!variant) return NULL;
+    if (poll_variant(variants, variant)) {
+        return variant->status == VARIANT_READY ? &variant->shader : NULL;
+    }
+    
+    /* Extra features cost some fragment time for the few frames until the
+     * exact variant is done, rather than a stall now. Interface features
+     * change what the draw has to supply, so those can't be extra. */
+    features = variant->features;
+    u32 interface = features & variants->interface_features;
+    ShaderVariant* cheapest = NULL;
+    for (u32 i = 0; i < variants->capacity; i++) {
+        ShaderVariant* candidate = &variants->table[i];
+        if (candidate->status == VARIANT_EMPTY || (candidate->features & features) != features ||
+            (candidate->features & variants->interface_features) != interface) {
+            continue;
+        }
+        if (!poll_variant(variants, candidate) || candidate->status != VARIANT_READY) continue;
+        if (!cheapest || feature_bits(candidate->features) < feature_bits(cheapest->features)) {
+            cheapest = candidate;
+        }
+    }
+    if (cheapest) return &cheapest->shader;
+    
+    wait_variant(variants, variant);
+    return variant->status == VARIANT_READY ? &variant->shader : NULL;
+}
+
+void shader_shutdown(void) {
+    if (!g_shaders_ready) return;
+    
+    u32 leaked = handle_pool_count(&g_shaders);
+    if (leaked > 0) {
+        fprintf(stderr, "%u shader(s) still alive at shutdown\n", leaked);
+    }
+    for (u32 i = 0; i < leaked; i++) {
+        release_shader((Shader*)handle_pool_item_at(&g_shaders, i));
+    }
+    handle_pool_free(&g_shaders);
+    g_shaders_ready = false;
+    g_parallel_compile = false;
+    g_cache_reported = false;
 }
 
 void shader_use(const Shader* shader) {
-    if (shader) {
+    if (shader && shader->program) {
         glUseProgram(shader->program);
     }
 }
 
-i32 shader_get_uniform_location(const Shader* shader, const char* name) {
-    return glGetUniformLocation(shader->program, name);
+i32 shader_get_uniform_location(const Shader* shader, UniformId id) {
+    for (u32 i = 0; i < shader->uniform_count; i++) {
+        if (shader->uniforms[i].hash == id.hash) return shader->uniforms[i].location;
+    }
+    return -1;
+}
+
+void shader_set_int(const Shader* shader, UniformId id, i32 value) {
+    i32 location = shader_get_uniform_location(shader, id);
+    if (location < 0) return;
+    glUniform1i(location, value);
+}
+
+void shader_set_float(const Shader* shader, UniformId id, f32 value) {
+    i32 location = shader_get_uniform_location(shader, id);
+    if (location < 0) return;
+    glUniform1f(location, value);
+}
+
+void shader_set_vec2(const Shader* shader, UniformId id, Vec2 value) {
+    i32 location = shader_get_uniform_location(shader, id);
+    if (location < 0) return;
+    glUniform2f(location, value.x, value.y);
 }
 
-void shader_set_int(const Shader* shader, const char* name, i32 value) {
-    glUniform1i(shader_get_uniform_location(shader, name), value);
+void shader_set_vec3(const Shader* shader, UniformId id, Vec3 value) {
+    i32 location = shader_get_uniform_location(shader, id);
+    if (location < 0) return;
+    glUniform3f(location, value.x, value.y, value.z);
 }
 
-void shader_set_float(const Shader* shader, const char* name, f32 value) {
-    glUniform1f(shader_get_uniform_location(shader, name), value);
+void shader_set_mat4(const Shader* shader, UniformId id, const Mat4* value) {
+    i32 location = shader_get_uniform_location(shader, id);
+    if (location < 0) return;
+    glUniformMatrix4fv(location, 1, GL_FALSE, value->m);
 }
 
-void shader_set_vec3(const Shader* shader, const char* name, Vec3 value) {
-    glUniform3f(shader_get_uniform_location(shader, name), value.x, value.y, value.z);
+void shader_set_mat3(const Shader* shader, UniformId id, const Mat3* value) {
+    i32 location = shader_get_uniform_location(shader, id);
+    if (location < 0) return;
+    glUniformMatrix3fv(location, 1, GL_FALSE, value->m);
 }
 
-void shader_set_mat4(const Shader* shader, const char* name, const Mat4* value) {
-    glUniformMatrix4fv(shader_get_uniform_location(shader, name), 1, GL_FALSE, value->m);
+void shader_set_mat3x4(const Shader* shader, UniformId id, const Mat3x4* value) {
+    i32 location = shader_get_uniform_location(shader, id);
+    if (location < 0) return;
+    /* Rows of the affine matrix become the columns of a GLSL mat3x4 */
+    glUniformMatrix3x4fv(location, 1, GL_FALSE, value->m);
 }
 
-void shader_set_color(const Shader* shader, const char* name, Color value) {
-    glUniform4f(shader_get_uniform_location(shader, name), value.r, value.g, value.b, value.a);
+void shader_set_color(const Shader* shader, UniformId id, Color value) {
+    i32 location = shader_get_uniform_location(shader, id);
+    if (location < 0) return;
+    glUniform4f(location, value.r, value.g, value.b, value.a);
 }
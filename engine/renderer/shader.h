@@ -2,29 +2,111 @@
 #define SHADER_H
 
 #include "../core/types.h"
+#include "../math/vec2.h"
 #include "../math/vec3.h"
 #include "../math/mat4.h"
+#include "../math/transform.h"
+
+#define SHADER_MAX_UNIFORMS 32
+#define SHADER_MAX_FEATURES 8          /* Feature bits of a variant shader */
+#define SHADER_FEATURE_NAME_MAX 32
+
+/* A uniform name hashed once, up front, so setting it is a table lookup
+ * rather than a string search in the driver */
+typedef struct {
+    u32 hash;
+} UniformId;
 
-/* Shader structure */
+typedef struct {
+    u32 hash;
+    i32 location;
+} ShaderUniform;
+
+typedef struct ShaderVariants ShaderVariants;
+
+/* Shader structure. The locations of the program's active uniforms are
+ * read once, when it links. */
 typedef struct {
     u32 program;
+    u32 uniform_count;
+    ShaderUniform uniforms[SHADER_MAX_UNIFORMS];
+    ShaderVariants* variants;    /* Set by shader_create_variants; program is 0 then */
 } Shader;
 
-/* Shader creation and destruction */
-Shader* shader_create(const char* vertex_source, const char* fragment_source);
-void shader_destroy(Shader* shader);
+/* FNV-1a of the name; array uniforms are named without the "[0]" */
+static inline UniformId uniform_id(const char* name) {
+    u32 hash = 2166136261u;
+    while (*name) {
+        hash = (hash ^ (u8)*name++) * 16777619u;
+    }
+    return (UniformId){hash};
+}
+
+/* Shaders live in a pool owned by this module and are referred to by
+ * handle; shader_create returns a null handle when compiling or linking
+ * fails */
+ShaderHandle shader_create(const char* vertex_source, const char* fragment_source);
+void shader_destroy(ShaderHandle shader);
+
+/* One source built as variants that differ in compile-time features
+ * rather than uniform branches, so a draw pays only for the effects it
+ * uses. Bit i of a feature mask puts "#define <feature_names[i]>" after
+ * the #version line of both stages. Variants are kept in a table hashed on
+ * the mask and built the first time they are asked for; with
+ * GL_KHR_parallel_shader_compile they compile on driver threads while
+ * draws make do with a built stand-in that has all of their features.
+ * Features in interface_features change the shader's inputs (attributes,
+ * uniforms), so a stand-in must have exactly those the draw asked for.
+ * A null handle when there are more than SHADER_MAX_FEATURES names. */
+ShaderHandle shader_create_variants(const char* vertex_source, const char* fragment_source,
+                                    const char* const* feature_names, u32 feature_count,
+                                    u32 interface_features);
+
+/* Start building these variants now, e.g. while loading, rather than at
+ * their first draw */
+void shader_prepare_variants(ShaderHandle shader, const u32* feature_masks, u32 count);
+
+/* NULL once the shader is destroyed; good until the next create or destroy */
+Shader* shader_get(ShaderHandle shader);
+
+/* The variant with exactly these features, waiting for its build, e.g. to
+ * set uniforms that stay with it; a shader from shader_create itself.
+ * Uniforms set here are not carried over to stand-ins, but once this has
+ * built the variant, draws with these features never need one. NULL if
+ * it failed to build. Good until the next variant is added. */
+Shader* shader_get_variant(ShaderHandle shader, u32 features);
+
+/* The variant to draw with: the exact one once built, until then the
+ * built one with the fewest features that include these and the same
+ * interface features, waiting only when there is none. Starts the exact one if needed, so call it on the
+ * thread that owns the GL context. */
+Shader* shader_select_variant(ShaderHandle shader, u32 features);
+
+/* Finish the variants the driver is done with and return how many are
+ * still building. draw_list_execute calls it every frame on the GL thread,
+ * so a build's end is seen within a frame. The first time nothing is
+ * building it prints the shader cache report, as startup's shaders are
+ * all compiled by then. */
+u32 shader_poll_variants(void);
+
+/* Free the pool, reporting and deleting shaders still alive */
+void shader_shutdown(void);
 
 /* Shader usage */
 void shader_use(const Shader* shader);
 
-/* Uniform setters */
-void shader_set_int(const Shader* shader, const char* name, i32 value);
-void shader_set_float(const Shader* shader, const char* name, f32 value);
-void shader_set_vec3(const Shader* shader, const char* name, Vec3 value);
-void shader_set_mat4(const Shader* shader, const char* name, const Mat4* value);
-void shader_set_color(const Shader* shader, const char* name, Color value);
+/* Uniform setters; uniforms the program does not use are skipped. Per-frame
+ * values belong in the frame uniform buffer (frame_uniforms.h) instead. */
+void shader_set_int(const Shader* shader, UniformId id, i32 value);
+void shader_set_float(const Shader* shader, UniformId id, f32 value);
+void shader_set_vec2(const Shader* shader, UniformId id, Vec2 value);
+void shader_set_vec3(const Shader* shader, UniformId id, Vec3 value);
+void shader_set_mat4(const Shader* shader, UniformId id, const Mat4* value);
+void shader_set_mat3(const Shader* shader, UniformId id, const Mat3* value);
+void shader_set_mat3x4(const Shader* shader, UniformId id, const Mat3x4* value);
+void shader_set_color(const Shader* shader, UniformId id, Color value);
 
-/* Get uniform location */
-i32 shader_get_uniform_location(const Shader* shader, const char* name);
+/* Cached uniform location; -1 if the program has no such active uniform */
+i32 shader_get_uniform_location(const Shader* shader, UniformId id);
 
 #endif /* SHADER_H */
@@ -0,0 +1,229 @@
+/* mkdir under strict -std=c11 */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "shader_cache.h"
+#include "../core/timer.h"
+#include <glad/glad.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define make_directory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define make_directory(path) mkdir(path, 0755)
+#endif
+
+#define SHADER_CACHE_MAGIC 0x48534345u   /* "ECSH" */
+#define SHADER_CACHE_VERSION 1
+#define SHADER_CACHE_PATH_MAX 512
+
+/* Start of every cache file; the binary follows */
+typedef struct {
+    u32 magic;
+    u32 version;
+    u64 key;
+    u32 format;        /* Binary format glGetProgramBinary reported */
+    u32 length;
+    u64 build_ns;      /* Compile and link time the binary stands for */
+} ShaderCacheHeader;
+
+static struct {
+    bool enabled;
+    char directory[SHADER_CACHE_PATH_MAX - 32];   /* Room for the entry name */
+    u64 driver_hash;
+    ShaderCacheStats stats;
+} g_cache;
+
+static u64 hash_bytes(u64 hash, const void* data, size_t size) {
+    const u8* bytes = (const u8*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+/* Strings end with their terminator, so ("ab", "c") and ("a", "bc") differ */
+static u64 hash_string(u64 hash, const char* text) {
+    return hash_bytes(hash, text, strlen(text) + 1);
+}
+
+void shader_cache_init(const char* directory) {
+    memset(&g_cache, 0, sizeof(g_cache));
+    if (!directory || !*directory) return;
+    if (strlen(directory) >= sizeof(g_cache.directory)) {
+        fprintf(stderr, "Shader cache path too long: %s\n", directory);
+        return;
+    }
+
+    /* Core in 4.1; some drivers expose the calls but no formats */
+    if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary) return;
+    i32 formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) {
+        printf("Shader cache off: the driver has no program binary formats\n");
+        return;
+    }
+
+    /* Fails harmlessly when the directory exists; a real failure shows
+     * up as stores that can't be written */
+    make_directory(directory);
+    strcpy(g_cache.directory, directory);
+
+    u64 hash = 14695981039346656037ull;
+    const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (u32 i = 0; i < sizeof(strings) / sizeof(strings[0]); i++) {
+        const char* value = (const char*)glGetString(strings[i]);
+        hash = hash_string(hash, value ? value : "");
+    }
+    g_cache.driver_hash = hash;
+    g_cache.enabled = true;
+}
+
+void shader_cache_shutdown(void) {
+    g_cache.enabled = false;
+}
+
+bool shader_cache_enabled(void) {
+    return g_cache.enabled;
+}
+
+u64 shader_cache_key(const char* const* parts, u32 count) {
+    u64 hash = g_cache.driver_hash;
+    for (u32 i = 0; i < count; i++) {
+        hash = hash_string(hash, parts[i] ? parts[i] : "");
+    }
+    return hash;
+}
+
+static void entry_path(char* path, u64 key) {
+    snprintf(path, SHADER_CACHE_PATH_MAX, "%s/%016llx.bin", g_cache.directory, (unsigned long long)key);
+}
+
+/* The binary of the entry for key; NULL if missing or malformed */
+static void* read_entry(u64 key, ShaderCacheHeader* header) {
+    char path[SHADER_CACHE_PATH_MAX];
+    entry_path(path, key);
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    void* binary = NULL;
+    if (fread(header, sizeof(*header), 1, file) == 1 &&
+        header->magic == SHADER_CACHE_MAGIC && header->version == SHADER_CACHE_VERSION &&
+        header->key == key && header->length > 0) {
+        binary = malloc(header->length);
+        if (binary && fread(binary, 1, header->length, file) != header->length) {
+            free(binary);
+            binary = NULL;
+        }
+    }
+    fclose(file);
+    return binary;
+}
+
+u32 shader_cache_load(u64 key) {
+    if (!g_cache.enabled) return 0;
+
+    u64 start = timer_now_ns();
+    ShaderCacheHeader header;
+    void* binary = read_entry(key, &header);
+    if (!binary) {
+        g_cache.stats.misses++;
+        return 0;
+    }
+
+    u32 program = glCreateProgram();
+    glProgramBinary(program, header.format, binary, (i32)header.length);
+    free(binary);
+
+    i32 success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        /* Stale after a driver change the strings don't show; rebuilt
+         * from source and overwritten by the next store */
+        glDeleteProgram(program);
+        g_cache.stats.misses++;
+        g_cache.stats.rejected++;
+        return 0;
+    }
+
+    u64 load_ns = timer_now_ns() - start;
+    g_cache.stats.hits++;
+    g_cache.stats.load_ns += load_ns;
+    if (header.build_ns > load_ns) {
+        g_cache.stats.saved_ns += header.build_ns - load_ns;
+    }
+    return program;
+}
+
+void shader_cache_prepare(u32 program) {
+    if (g_cache.enabled) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void shader_cache_store(u64 key, u32 program, u64 build_ns) {
+    if (!g_cache.enabled) return;
+    g_cache.stats.compile_ns += build_ns;
+
+    i32 length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    void* binary = malloc((size_t)length);
+    if (!binary) return;
+
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary);
+
+    ShaderCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SHADER_CACHE_MAGIC;
+    header.version = SHADER_CACHE_VERSION;
+    header.key = key;
+    header.format = format;
+    header.length = (u32)length;
+    header.build_ns = build_ns;
+
+    /* Written aside and renamed into place, so a crash mid-write leaves no
+     * truncated entry behind */
+    char path[SHADER_CACHE_PATH_MAX];
+    char temp_path[SHADER_CACHE_PATH_MAX + 4];
+    entry_path(path, key);
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to write shader cache entry %s\n", temp_path);
+        free(binary);
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(binary, 1, header.length, file) == header.length;
+    written = fclose(file) == 0 && written;
+    free(binary);
+
+    remove(path);
+    if (!written || rename(temp_path, path) != 0) {
+        fprintf(stderr, "Failed to write shader cache entry %s\n", path);
+        remove(temp_path);
+    }
+}
+
+const ShaderCacheStats* shader_cache_stats(void) {
+    return &g_cache.stats;
+}
+
+void shader_cache_report(void) {
+    const ShaderCacheStats* stats = &g_cache.stats;
+    if (!g_cache.enabled || stats->hits + stats->misses == 0) return;
+
+    printf("Shader cache: %u hit(s), %u miss(es)", stats->hits, stats->misses);
+    if (stats->rejected > 0) {
+        printf(" (%u rejected by the driver)", stats->rejected);
+    }
+    printf("; loading took %.1f ms, compiling %.1f ms, %.1f ms saved\n",
+           stats->load_ns * 1e-6, stats->compile_ns * 1e-6, stats->saved_ns * 1e-6);
+}
@@ -0,0 +1,51 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include "../core/types.h"
+
+/* On-disk cache of linked program binaries (glGetProgramBinary), so a
+ * program is compiled from source once per driver instead of on every
+ * launch. Entries are keyed by a hash of everything the program is built
+ * from plus the driver's vendor, renderer and version strings: editing a
+ * shader or updating the driver misses rather than loading a stale
+ * binary. A driver may still refuse a binary it wrote; that is a miss,
+ * and the entry is rewritten from the fresh build.
+ *
+ * shader_create and shader variants use the cache when it is enabled. */
+
+typedef struct {
+    u32 hits;
+    u32 misses;
+    u32 rejected;          /* Binaries the driver refused, also counted as misses */
+    u64 load_ns;           /* Spent loading the hits */
+    u64 compile_ns;        /* Spent compiling and linking the misses */
+    u64 saved_ns;          /* Build time recorded with the hits, less their load time */
+} ShaderCacheStats;
+
+/* Needs the GL context. Stays disabled when directory is NULL or the
+ * driver offers no binary formats; the directory is created if missing. */
+void shader_cache_init(const char* directory);
+void shader_cache_shutdown(void);
+bool shader_cache_enabled(void);
+
+/* Key for a program built from these strings (sources, defines) on this
+ * driver; NULL entries are skipped */
+u64 shader_cache_key(const char* const* parts, u32 count);
+
+/* Linked program for key, or 0 on a miss */
+u32 shader_cache_load(u64 key);
+
+/* Call on a new program before linking it, so the driver keeps a binary
+ * to retrieve */
+void shader_cache_prepare(u32 program);
+
+/* Save a linked program; build_ns is how long building it took, reported
+ * as the time saved when it is loaded later */
+void shader_cache_store(u64 key, u32 program, u64 build_ns);
+
+const ShaderCacheStats* shader_cache_stats(void);
+
+/* Print the counts and time saved, if anything was looked up */
+void shader_cache_report(void);
+
+#endif /* SHADER_CACHE_H */
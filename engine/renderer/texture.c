@@ -0,0 +1,83 @@
+#include "texture.h"
+#include "renderer.h"
+#include "../core/handle_pool.h"
+#include <glad/glad.h>
+#include <stdio.h>
+
+static HandlePool g_textures;
+static bool g_textures_ready = false;
+
+TextureHandle texture_create(u32 width, u32 height, TextureFormat format, const void* data) {
+    TextureHandle handle = {INVALID_HANDLE};
+    if (width == 0 || height == 0) return handle;
+    if (!g_textures_ready) {
+        g_textures_ready = handle_pool_init(&g_textures, sizeof(Texture), 16, "Texture");
+        if (!g_textures_ready) return handle;
+    }
+
+    Texture* texture = (Texture*)handle_pool_alloc(&g_textures, &handle.id);
+    if (!texture) return handle;
+    texture->width = width;
+    texture->height = height;
+    texture->format = format;
+
+    /* Headless: size only, bind becomes a no-op */
+    if (renderer_is_headless()) {
+        texture->id = 0;
+        return handle;
+    }
+
+    glGenTextures(1, &texture->id);
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    /* Rows of R32F texels are 4-byte aligned, RGBA8 ones always are */
+    if (format == TEXTURE_R32F) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, (i32)width, (i32)height, 0, GL_RED, GL_FLOAT, data);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, (i32)width, (i32)height, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, data);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return handle;
+}
+
+void texture_destroy(TextureHandle handle) {
+    if (!g_textures_ready || !HANDLE_IS_VALID(handle)) return;
+
+    Texture* texture = (Texture*)handle_pool_get(&g_textures, handle.id);
+    if (texture && texture->id) {
+        glDeleteTextures(1, &texture->id);
+    }
+    handle_pool_release(&g_textures, handle.id);
+}
+
+Texture* texture_get(TextureHandle handle) {
+    return g_textures_ready ? (Texture*)handle_pool_get(&g_textures, handle.id) : NULL;
+}
+
+void texture_shutdown(void) {
+    if (!g_textures_ready) return;
+
+    u32 leaked = handle_pool_count(&g_textures);
+    if (leaked > 0) {
+        fprintf(stderr, "%u texture(s) still alive at shutdown\n", leaked);
+    }
+    for (u32 i = 0; i < leaked; i++) {
+        Texture* texture = (Texture*)handle_pool_item_at(&g_textures, i);
+        if (texture->id) glDeleteTextures(1, &texture->id);
+    }
+    handle_pool_free(&g_textures);
+    g_textures_ready = false;
+}
+
+void texture_bind(const Texture* texture, u32 unit) {
+    if (texture && texture->id) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture->id);
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include "../core/types.h"
+
+typedef enum {
+    TEXTURE_R32F,     /* One float per texel, e.g. heights */
+    TEXTURE_RGBA8
+} TextureFormat;
+
+/* 2D texture, linearly filtered and clamped to its edges */
+typedef struct {
+    u32 id;
+    u32 width;
+    u32 height;
+    TextureFormat format;
+} Texture;
+
+/* Textures live in a pool owned by this module and are referred to by
+ * handle, like meshes and shaders. data holds width * height texels, rows
+ * in order; headless textures keep their size but no GPU storage. */
+TextureHandle texture_create(u32 width, u32 height, TextureFormat format, const void* data);
+void texture_destroy(TextureHandle texture);
+
+/* NULL once the texture is destroyed; good until the next create or destroy */
+Texture* texture_get(TextureHandle texture);
+
+/* Free the pool, reporting and deleting textures still alive */
+void texture_shutdown(void);
+
+/* Bind to texture unit `unit` for the sampler uniform set to it */
+void texture_bind(const Texture* texture, u32 unit);
+
+#endif /* TEXTURE_H */
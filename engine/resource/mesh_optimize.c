@@ -0,0 +1,202 @@
+#include "mesh_optimize.h"
+#include "../core/arena.h"
+#include <math.h>
+#include <string.h>
+
+#define NO_ENTRY 0xFFFFFFFFu
+
+/* Forsyth's scoring: a vertex is worth more the more recently it was used
+ * (the last triangle's three are held back slightly so the strip does not
+ * fold over itself) and the fewer triangles it has left, so stragglers
+ * get finished off instead of coming back out of the cache later */
+#define SCORE_CACHE_DECAY_POWER 1.5f
+#define SCORE_LAST_TRIANGLE 0.75f
+#define SCORE_VALENCE_BOOST_SCALE 2.0f
+#define SCORE_VALENCE_BOOST_POWER 0.5f
+
+f32 mesh_optimize_acmr(const u32* indices, u32 index_count, u32 vertex_count, u32 cache_size) {
+    if (index_count < 3) return 0.0f;
+    
+    /* A vertex is cached while fewer than cache_size misses followed its
+     * own, which is what a FIFO of that size holds */
+    Scratch scratch = scratch_begin();
+    u32* missed_at = arena_push_array(scratch.arena, u32, vertex_count);
+    if (!missed_at) {
+        scratch_end(scratch);
+        return 0.0f;
+    }
+    for (u32 i = 0; i < vertex_count; i++) missed_at[i] = NO_ENTRY;
+    
+    u32 misses = 0;
+    for (u32 i = 0; i < index_count; i++) {
+        u32 v = indices[i];
+        if (missed_at[v] == NO_ENTRY || misses - missed_at[v] >= cache_size) {
+            missed_at[v] = misses++;
+        }
+    }
+    
+    scratch_end(scratch);
+    return (f32)misses / (f32)(index_count / 3);
+}
+
+static f32 vertex_score(i32 cache_position, u32 remaining) {
+    if (remaining == 0) return -1.0f;
+    
+    f32 score = 0.0f;
+    if (cache_position >= 0) {
+        if (cache_position < 3) {
+            score = SCORE_LAST_TRIANGLE;
+        } else {
+            f32 scale = 1.0f / (MESH_OPTIMIZE_CACHE_SIZE - 3);
+            score = powf(1.0f - (cache_position - 3) * scale, SCORE_CACHE_DECAY_POWER);
+        }
+    }
+    return score + SCORE_VALENCE_BOOST_SCALE * powf((f32)remaining, -SCORE_VALENCE_BOOST_POWER);
+}
+
+bool mesh_optimize_vertex_cache(u32* indices, u32 index_count, u32 vertex_count) {
+    u32 triangle_count = index_count / 3;
+    if (triangle_count < 2) return true;
+    
+    Scratch scratch = scratch_begin();
+    u32* adjacency_start = arena_push_array(scratch.arena, u32, vertex_count + 1);
+    u32* remaining = arena_push_array(scratch.arena, u32, vertex_count);
+    i32* cache_position = arena_push_array(scratch.arena, i32, vertex_count);
+    f32* scores = arena_push_array(scratch.arena, f32, vertex_count);
+    u32* adjacency = arena_push_array(scratch.arena, u32, triangle_count * 3);
+    f32* triangle_scores = arena_push_array(scratch.arena, f32, triangle_count);
+    bool* emitted = arena_push_array(scratch.arena, bool, triangle_count);
+    u32* output = arena_push_array(scratch.arena, u32, triangle_count * 3);
+    if (!adjacency_start || !remaining || !cache_position || !scores || !adjacency ||
+        !triangle_scores || !emitted || !output) {
+        scratch_end(scratch);
+        return false;
+    }
+    
+    /* Triangles using each vertex; a vertex's first remaining[v] entries
+     * are the ones not yet emitted */
+    memset(remaining, 0, vertex_count * sizeof(u32));
+    for (u32 i = 0; i < triangle_count * 3; i++) {
+        remaining[indices[i]]++;
+    }
+    adjacency_start[0] = 0;
+    for (u32 v = 0; v < vertex_count; v++) {
+        adjacency_start[v + 1] = adjacency_start[v] + remaining[v];
+        remaining[v] = 0;
+    }
+    for (u32 t = 0; t < triangle_count; t++) {
+        for (u32 k = 0; k < 3; k++) {
+            u32 v = indices[t * 3 + k];
+            adjacency[adjacency_start[v] + remaining[v]++] = t;
+        }
+    }
+    
+    for (u32 v = 0; v < vertex_count; v++) {
+        cache_position[v] = -1;
+        scores[v] = vertex_score(-1, remaining[v]);
+    }
+    u32 best = 0;
+    for (u32 t = 0; t < triangle_count; t++) {
+        const u32* tri = &indices[t * 3];
+        triangle_scores[t] = scores[tri[0]] + scores[tri[1]] + scores[tri[2]];
+        emitted[t] = false;
+        if (triangle_scores[t] > triangle_scores[best]) best = t;
+    }
+    
+    /* Three spare entries hold what the newest triangle pushes out */
+    u32 cache[MESH_OPTIMIZE_CACHE_SIZE + 3];
+    u32 cache_count = 0;
+    u32 scan = 0;
+    
+    for (u32 out = 0; out < triangle_count; out++) {
+        if (best == NO_ENTRY) {
+            /* Nothing in the cache has triangles left: take the next one
+             * in input order, which is usually near the last */
+            while (emitted[scan]) scan++;
+            best = scan;
+        }
+        
+        const u32* tri = &indices[best * 3];
+        memcpy(&output[out * 3], tri, 3 * sizeof(u32));
+        emitted[best] = true;
+        
+        for (u32 k = 0; k < 3; k++) {
+            u32 v = tri[k];
+            u32* list = &adjacency[adjacency_start[v]];
+            for (u32 i = 0; i < remaining[v]; i++) {
+                if (list[i] == best) {
+                    list[i] = list[--remaining[v]];
+                    break;
+                }
+            }
+        }
+        
+        /* Move the triangle's vertices to the front, keeping the order of
+         * the rest */
+        u32 new_cache[MESH_OPTIMIZE_CACHE_SIZE + 3];
+        u32 new_count = 0;
+        for (u32 k = 0; k < 3; k++) {
+            new_cache[new_count++] = tri[k];
+        }
+        for (u32 i = 0; i < cache_count; i++) {
+            u32 v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) new_cache[new_count++] = v;
+        }
+        
+        for (u32 i = 0; i < new_count; i++) {
+            u32 v = new_cache[i];
+            cache_position[v] = i < MESH_OPTIMIZE_CACHE_SIZE ? (i32)i : -1;
+            scores[v] = vertex_score(cache_position[v], remaining[v]);
+        }
+        
+        /* Only triangles of vertices whose score changed can become best */
+        best = NO_ENTRY;
+        f32 best_score = -1.0f;
+        for (u32 i = 0; i < new_count; i++) {
+            u32 v = new_cache[i];
+            const u32* list = &adjacency[adjacency_start[v]];
+            for (u32 j = 0; j < remaining[v]; j++) {
+                u32 t = list[j];
+                const u32* other = &indices[t * 3];
+                triangle_scores[t] = scores[other[0]] + scores[other[1]] + scores[other[2]];
+                if (triangle_scores[t] > best_score) {
+                    best_score = triangle_scores[t];
+                    best = t;
+                }
+            }
+        }
+        
+        cache_count = new_count < MESH_OPTIMIZE_CACHE_SIZE ? new_count : MESH_OPTIMIZE_CACHE_SIZE;
+        memcpy(cache, new_cache, cache_count * sizeof(u32));
+    }
+    
+    memcpy(indices, output, triangle_count * 3 * sizeof(u32));
+    scratch_end(scratch);
+    return true;
+}
+
+u32 mesh_optimize_vertex_fetch(Vertex* vertices, u32 vertex_count, u32* indices, u32 index_count) {
+    Scratch scratch = scratch_begin();
+    u32* remap = arena_push_array(scratch.arena, u32, vertex_count);
+    Vertex* original = arena_push_array(scratch.arena, Vertex, vertex_count);
+    if (!remap || !original) {
+        scratch_end(scratch);
+        return vertex_count;
+    }
+    
+    memcpy(original, vertices, vertex_count * sizeof(Vertex));
+    for (u32 v = 0; v < vertex_count; v++) remap[v] = NO_ENTRY;
+    
+    u32 next = 0;
+    for (u32 i = 0; i < index_count; i++) {
+        u32 v = indices[i];
+        if (remap[v] == NO_ENTRY) {
+            remap[v] = next;
+            vertices[next++] = original[v];
+        }
+        indices[i] = remap[v];
+    }
+    
+    scratch_end(scratch);
+    return next;
+}
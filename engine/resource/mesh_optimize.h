@@ -0,0 +1,31 @@
+#ifndef MESH_OPTIMIZE_H
+#define MESH_OPTIMIZE_H
+
+#include "../core/types.h"
+#include "../renderer/mesh.h"
+
+/* Index and vertex reordering for indexed triangle lists, run once when a
+ * mesh is loaded. Reordering triangles so recently used vertices are used
+ * again (Forsyth's linear-speed vertex cache optimisation) cuts vertex
+ * shader invocations; renumbering vertices in first-use order then keeps
+ * vertex fetches close together. */
+
+/* Cache modelled by the optimizer (LRU) and by the ACMR report (FIFO, as
+ * in most hardware post-transform caches) */
+#define MESH_OPTIMIZE_CACHE_SIZE 32
+#define MESH_OPTIMIZE_FIFO_SIZE 16
+
+/* Average cache miss ratio: vertex shader runs per triangle with a FIFO
+ * cache of cache_size entries. 3.0 means no reuse, 0.5 is about the best
+ * a regular grid can do. */
+f32 mesh_optimize_acmr(const u32* indices, u32 index_count, u32 vertex_count, u32 cache_size);
+
+/* Reorder triangles in place; false (indices untouched) if out of memory */
+bool mesh_optimize_vertex_cache(u32* indices, u32 index_count, u32 vertex_count);
+
+/* Renumber vertices in the order the indices first use them, rewriting
+ * both arrays in place. Unreferenced vertices are dropped; returns the new
+ * vertex count, or vertex_count unchanged if out of memory. */
+u32 mesh_optimize_vertex_fetch(Vertex* vertices, u32 vertex_count, u32* indices, u32 index_count);
+
+#endif /* MESH_OPTIMIZE_H */
@@ -1,21 +1,39 @@
 #include "obj_loader.h"
+#include "mesh_optimize.h"
+#include "../core/profiler.h"
+#include "../core/arena.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_VERTICES 100000
-#define MAX_FACES 100000
-
+/* Element counts from a first pass, used to size the scratch buffers */
 typedef struct {
-    Vec3* positions;
-    Vec3* normals;
-    Vec2* texcoords;
     u32 position_count;
     u32 normal_count;
     u32 texcoord_count;
-} ObjData;
+    u32 face_count;
+} ObjCounts;
+
+static ObjCounts count_elements(const char* data) {
+    ObjCounts counts = {0, 0, 0, 0};
+    const char* ptr = data;
+    
+    while (*ptr) {
+        if (ptr[0] == 'v' && ptr[1] == ' ') counts.position_count++;
+        else if (ptr[0] == 'v' && ptr[1] == 'n') counts.normal_count++;
+        else if (ptr[0] == 'v' && ptr[1] == 't') counts.texcoord_count++;
+        else if (ptr[0] == 'f' && ptr[1] == ' ') counts.face_count++;
+        
+        const char* line_end = strchr(ptr, '\n');
+        if (!line_end) break;
+        ptr = line_end + 1;
+    }
+    
+    return counts;
+}
 
-static char* read_file(const char* filepath, u32* out_size) {
+/* File contents are allocated from arena */
+static char* read_file(Arena* arena, const char* filepath, u32* out_size) {
     FILE* file = fopen(filepath, "rb");
     if (!file) {
         fprintf(stderr, "Failed to open file: %s\n", filepath);
@@ -26,7 +44,7 @@ static char* read_file(const char* filepath, u32* out_size) {
     long size = ftell(file);
     fseek(file, 0, SEEK_SET);
     
-    char* buffer = (char*)malloc(size + 1);
+    char* buffer = (char*)arena_alloc(arena, size + 1, 1);
     if (!buffer) {
         fclose(file);
         return NULL;
@@ -65,29 +83,103 @@ static void parse_face_vertex(const char* str, i32* pos_idx, i32* tex_idx, i32*
     *norm_idx = atoi(slash2 + 1);
 }
 
-Mesh* obj_loader_parse(const char* data, u32 data_size) {
+/* Face corners with the same position/texcoord/normal indices share one
+ * vertex; the table maps each distinct triple to it */
+typedef struct {
+    i32 position;    /* Resolved 0-based indices, -1 when absent or out of range */
+    i32 texcoord;
+    i32 normal;
+    u32 vertex;      /* WELD_EMPTY for an unused slot */
+} WeldSlot;
+
+#define WELD_EMPTY 0xFFFFFFFFu
+
+typedef struct {
+    const Vec3* positions;
+    const Vec3* normals;
+    const Vec2* texcoords;
+    u32 pos_count;
+    u32 norm_count;
+    u32 tex_count;
+    Vertex* vertices;
+    u32 vertex_count;
+    WeldSlot* slots;
+    u32 slot_mask;
+} ObjBuilder;
+
+/* OBJ indices are 1-based, negative ones count back from the end */
+static i32 resolve_index(i32 index, u32 count) {
+    i32 resolved = index > 0 ? index - 1 : (i32)count + index;
+    return resolved >= 0 && resolved < (i32)count ? resolved : -1;
+}
+
+static u32 weld_hash(i32 position, i32 texcoord, i32 normal) {
+    u32 h = (u32)position * 0x9E3779B1u;
+    h ^= (u32)texcoord * 0x85EBCA77u + (h << 6) + (h >> 2);
+    h ^= (u32)normal * 0xC2B2AE3Du + (h << 6) + (h >> 2);
+    return h ^ (h >> 16);
+}
+
+/* Vertex index for a face corner, adding the vertex on first use */
+static u32 obj_add_corner(ObjBuilder* builder, i32 pos_idx, i32 tex_idx, i32 norm_idx) {
+    i32 pi = resolve_index(pos_idx, builder->pos_count);
+    i32 ti = resolve_index(tex_idx, builder->tex_count);
+    i32 ni = resolve_index(norm_idx, builder->norm_count);
+    
+    /* The table has more slots than there can be corners, so this ends */
+    u32 slot = weld_hash(pi, ti, ni) & builder->slot_mask;
+    while (builder->slots[slot].vertex != WELD_EMPTY) {
+        const WeldSlot* entry = &builder->slots[slot];
+        if (entry->position == pi && entry->texcoord == ti && entry->normal == ni) {
+            return entry->vertex;
+        }
+        slot = (slot + 1) & builder->slot_mask;
+    }
+    
+    Vertex* vert = &builder->vertices[builder->vertex_count];
+    vert->position = pi >= 0 ? builder->positions[pi] : vec3_create(0, 0, 0);
+    vert->texcoord = ti >= 0 ? builder->texcoords[ti] : vec2_create(0, 0);
+    vert->normal = ni >= 0 ? builder->normals[ni] : vec3_create(0, 1, 0);
+    
+    WeldSlot* entry = &builder->slots[slot];
+    entry->position = pi;
+    entry->texcoord = ti;
+    entry->normal = ni;
+    entry->vertex = builder->vertex_count++;
+    return entry->vertex;
+}
+
+MeshHandle obj_loader_parse(const char* data, u32 data_size) {
     (void)data_size;
     
-    /* Allocate temporary storage */
-    Vec3* positions = (Vec3*)malloc(MAX_VERTICES * sizeof(Vec3));
-    Vec3* normals = (Vec3*)malloc(MAX_VERTICES * sizeof(Vec3));
-    Vec2* texcoords = (Vec2*)malloc(MAX_VERTICES * sizeof(Vec2));
-    Vertex* vertices = (Vertex*)malloc(MAX_FACES * 3 * sizeof(Vertex));
-    u32* indices = (u32*)malloc(MAX_FACES * 3 * sizeof(u32));
-    
-    if (!positions || !normals || !texcoords || !vertices || !indices) {
-        free(positions);
-        free(normals);
-        free(texcoords);
-        free(vertices);
-        free(indices);
-        return NULL;
+    PROFILE_BEGIN("obj_loader_parse");
+    
+    /* Size temporary storage exactly; a face yields at most two triangles */
+    ObjCounts counts = count_elements(data);
+    u32 max_corners = counts.face_count * 6;
+    u32 slot_count = 16;
+    while (slot_count < max_corners * 2) slot_count *= 2;
+    
+    Scratch scratch = scratch_begin();
+    Vec3* positions = arena_push_array(scratch.arena, Vec3, counts.position_count);
+    Vec3* normals = arena_push_array(scratch.arena, Vec3, counts.normal_count);
+    Vec2* texcoords = arena_push_array(scratch.arena, Vec2, counts.texcoord_count);
+    Vertex* vertices = arena_push_array(scratch.arena, Vertex, max_corners);
+    u32* indices = arena_push_array(scratch.arena, u32, max_corners);
+    WeldSlot* slots = arena_push_array(scratch.arena, WeldSlot, slot_count);
+    
+    if (!positions || !normals || !texcoords || !vertices || !indices || !slots) {
+        scratch_end(scratch);
+        PROFILE_END();
+        return (MeshHandle){INVALID_HANDLE};
     }
     
-    u32 pos_count = 0;
-    u32 norm_count = 0;
-    u32 tex_count = 0;
-    u32 vertex_count = 0;
+    for (u32 i = 0; i < slot_count; i++) {
+        slots[i].vertex = WELD_EMPTY;
+    }
+    ObjBuilder builder = {
+        positions, normals, texcoords, 0, 0, 0, vertices, 0, slots, slot_count - 1
+    };
     u32 index_count = 0;
     
     /* Parse line by line */
@@ -114,98 +206,48 @@ Mesh* obj_loader_parse(const char* data, u32 data_size) {
             /* Vertex position */
             Vec3 v;
             sscanf(line + 2, "%f %f %f", &v.x, &v.y, &v.z);
-            if (pos_count < MAX_VERTICES) {
-                positions[pos_count++] = v;
+            if (builder.pos_count < counts.position_count) {
+                positions[builder.pos_count++] = v;
             }
         } else if (line[0] == 'v' && line[1] == 'n') {
             /* Vertex normal */
             Vec3 n;
             sscanf(line + 3, "%f %f %f", &n.x, &n.y, &n.z);
-            if (norm_count < MAX_VERTICES) {
-                normals[norm_count++] = n;
+            if (builder.norm_count < counts.normal_count) {
+                normals[builder.norm_count++] = n;
             }
         } else if (line[0] == 'v' && line[1] == 't') {
             /* Texture coordinate */
             Vec2 t;
             sscanf(line + 3, "%f %f", &t.x, &t.y);
-            if (tex_count < MAX_VERTICES) {
-                texcoords[tex_count++] = t;
+            if (builder.tex_count < counts.texcoord_count) {
+                texcoords[builder.tex_count++] = t;
             }
         } else if (line[0] == 'f' && line[1] == ' ') {
             /* Face */
             char v1[64], v2[64], v3[64], v4[64];
             int matches = sscanf(line + 2, "%s %s %s %s", v1, v2, v3, v4);
             
-            if (matches >= 3) {
-                i32 pos_idx[4], tex_idx[4], norm_idx[4];
-                
-                parse_face_vertex(v1, &pos_idx[0], &tex_idx[0], &norm_idx[0]);
-                parse_face_vertex(v2, &pos_idx[1], &tex_idx[1], &norm_idx[1]);
-                parse_face_vertex(v3, &pos_idx[2], &tex_idx[2], &norm_idx[2]);
+            if (matches >= 3 && index_count + 6 <= max_corners) {
+                const char* corner_text[4] = {v1, v2, v3, v4};
+                u32 corner_count = matches >= 4 ? 4 : 3;
+                u32 corners[4];
+                for (u32 i = 0; i < corner_count; i++) {
+                    i32 pos_idx, tex_idx, norm_idx;
+                    parse_face_vertex(corner_text[i], &pos_idx, &tex_idx, &norm_idx);
+                    corners[i] = obj_add_corner(&builder, pos_idx, tex_idx, norm_idx);
+                }
                 
                 /* Add first triangle */
-                for (int i = 0; i < 3 && vertex_count < MAX_FACES * 3; i++) {
-                    Vertex* vert = &vertices[vertex_count];
-                    
-                    /* Handle negative indices (relative to end) */
-                    i32 pi = pos_idx[i] > 0 ? pos_idx[i] - 1 : (i32)pos_count + pos_idx[i];
-                    i32 ti = tex_idx[i] > 0 ? tex_idx[i] - 1 : (i32)tex_count + tex_idx[i];
-                    i32 ni = norm_idx[i] > 0 ? norm_idx[i] - 1 : (i32)norm_count + norm_idx[i];
-                    
-                    if (pi >= 0 && pi < (i32)pos_count) {
-                        vert->position = positions[pi];
-                    } else {
-                        vert->position = vec3_create(0, 0, 0);
-                    }
-                    
-                    if (ti >= 0 && ti < (i32)tex_count) {
-                        vert->texcoord = texcoords[ti];
-                    } else {
-                        vert->texcoord = vec2_create(0, 0);
-                    }
-                    
-                    if (ni >= 0 && ni < (i32)norm_count) {
-                        vert->normal = normals[ni];
-                    } else {
-                        vert->normal = vec3_create(0, 1, 0);
-                    }
-                    
-                    indices[index_count++] = vertex_count++;
-                }
+                indices[index_count++] = corners[0];
+                indices[index_count++] = corners[1];
+                indices[index_count++] = corners[2];
                 
                 /* Handle quad (4 vertices) - add second triangle */
-                if (matches >= 4) {
-                    parse_face_vertex(v4, &pos_idx[3], &tex_idx[3], &norm_idx[3]);
-                    
-                    int quad_indices[] = {0, 2, 3};
-                    for (int i = 0; i < 3 && vertex_count < MAX_FACES * 3; i++) {
-                        int vi = quad_indices[i];
-                        Vertex* vert = &vertices[vertex_count];
-                        
-                        i32 pi = pos_idx[vi] > 0 ? pos_idx[vi] - 1 : (i32)pos_count + pos_idx[vi];
-                        i32 ti = tex_idx[vi] > 0 ? tex_idx[vi] - 1 : (i32)tex_count + tex_idx[vi];
-                        i32 ni = norm_idx[vi] > 0 ? norm_idx[vi] - 1 : (i32)norm_count + norm_idx[vi];
-                        
-                        if (pi >= 0 && pi < (i32)pos_count) {
-                            vert->position = positions[pi];
-                        } else {
-                            vert->position = vec3_create(0, 0, 0);
-                        }
-                        
-                        if (ti >= 0 && ti < (i32)tex_count) {
-                            vert->texcoord = texcoords[ti];
-                        } else {
-                            vert->texcoord = vec2_create(0, 0);
-                        }
-                        
-                        if (ni >= 0 && ni < (i32)norm_count) {
-                            vert->normal = normals[ni];
-                        } else {
-                            vert->normal = vec3_create(0, 1, 0);
-                        }
-                        
-                        indices[index_count++] = vertex_count++;
-                    }
+                if (corner_count == 4) {
+                    indices[index_count++] = corners[0];
+                    indices[index_count++] = corners[2];
+                    indices[index_count++] = corners[3];
                 }
             }
         }
@@ -214,28 +256,45 @@ Mesh* obj_loader_parse(const char* data, u32 data_size) {
         ptr = *line_end ? line_end + 1 : line_end;
     }
     
+    u32 vertex_count = builder.vertex_count;
+    if (index_count > 0) {
+        f32 acmr_before = mesh_optimize_acmr(indices, index_count, vertex_count,
+                                             MESH_OPTIMIZE_FIFO_SIZE);
+        mesh_optimize_vertex_cache(indices, index_count, vertex_count);
+        vertex_count = mesh_optimize_vertex_fetch(vertices, vertex_count, indices, index_count);
+        f32 acmr_after = mesh_optimize_acmr(indices, index_count, vertex_count,
+                                            MESH_OPTIMIZE_FIFO_SIZE);
+        printf("OBJ: %u triangles, %u corners welded to %u vertices, ACMR %.3f -> %.3f\n",
+               index_count / 3, index_count, vertex_count, acmr_before, acmr_after);
+    }
+    
     /* Create mesh */
-    Mesh* mesh = NULL;
+    MeshHandle mesh = {INVALID_HANDLE};
     if (vertex_count > 0) {
-        mesh = mesh_create(vertices, vertex_count, indices, index_count);
+        mesh = mesh_create_lods(vertices, vertex_count, indices, index_count, MESH_VERTEX_COMPACT,
+                                MESH_DEFAULT_LODS);
     }
     
-    free(positions);
-    free(normals);
-    free(texcoords);
-    free(vertices);
-    free(indices);
+    scratch_end(scratch);
     
+    PROFILE_END();
     return mesh;
 }
 
-Mesh* obj_loader_load(const char* filepath) {
+MeshHandle obj_loader_load(const char* filepath) {
+    PROFILE_BEGIN("obj_loader_load");
+    
+    Scratch scratch = scratch_begin();
+    
     u32 size;
-    char* data = read_file(filepath, &size);
-    if (!data) return NULL;
+    char* data = read_file(scratch.arena, filepath, &size);
+    MeshHandle mesh = {INVALID_HANDLE};
+    if (data) {
+        mesh = obj_loader_parse(data, size);
+    }
     
-    Mesh* mesh = obj_loader_parse(data, size);
-    free(data);
+    scratch_end(scratch);
     
+    PROFILE_END();
     return mesh;
 }
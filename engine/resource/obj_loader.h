@@ -3,10 +3,10 @@
 
 #include "../renderer/mesh.h"
 
-/* Load mesh from OBJ file */
-Mesh* obj_loader_load(const char* filepath);
+/* Load mesh from OBJ file; null handle on failure */
+MeshHandle obj_loader_load(const char* filepath);
 
 /* Parse OBJ from memory buffer */
-Mesh* obj_loader_parse(const char* data, u32 data_size);
+MeshHandle obj_loader_parse(const char* data, u32 data_size);
 
 #endif /* OBJ_LOADER_H */
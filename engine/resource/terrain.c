@@ -1,5 +1,11 @@
 #include "terrain.h"
+#include "mesh_optimize.h"
+#include "../core/profiler.h"
+#include "../core/arena.h"
+#include "../renderer/texture.h"
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #ifndef M_PI
@@ -64,39 +70,151 @@ static f32 perlin_noise2d(f32 x, f32 y, i32 octaves, f32 persistence) {
     return total / max_value;
 }
 
-static void calculate_normals(Terrain* terrain, Vertex* vertices) {
-    u32 grid_size = terrain->width;
-    
-    for (u32 z = 0; z < terrain->depth; z++) {
-        for (u32 x = 0; x < terrain->width; x++) {
-            f32 hL = (x > 0) ? terrain->heights[(z * grid_size) + (x - 1)] : terrain->heights[(z * grid_size) + x];
-            f32 hR = (x < terrain->width - 1) ? terrain->heights[(z * grid_size) + (x + 1)] : terrain->heights[(z * grid_size) + x];
-            f32 hD = (z > 0) ? terrain->heights[((z - 1) * grid_size) + x] : terrain->heights[(z * grid_size) + x];
-            f32 hU = (z < terrain->depth - 1) ? terrain->heights[((z + 1) * grid_size) + x] : terrain->heights[(z * grid_size) + x];
+/* Grid of quads x quads squares with unit spacing in x and z; the chunk
+ * shader places it over the heightmap per node */
+static MeshHandle create_grid_mesh(u32 quads) {
+    Scratch scratch = scratch_begin();
+    u32 side = quads + 1;
+    u32 vertex_count = side * side;
+    u32 index_count = quads * quads * 6;
+    Vertex* vertices = arena_push_array(scratch.arena, Vertex, vertex_count);
+    u32* indices = arena_push_array(scratch.arena, u32, index_count);
+    if (!vertices || !indices) {
+        scratch_end(scratch);
+        return (MeshHandle){INVALID_HANDLE};
+    }
+    
+    for (u32 z = 0; z < side; z++) {
+        for (u32 x = 0; x < side; x++) {
+            Vertex* v = &vertices[z * side + x];
+            v->position = vec3_create((f32)x, 0.0f, (f32)z);
+            v->normal = vec3_create(0.0f, 1.0f, 0.0f);
+            v->texcoord = vec2_create((f32)x / quads, (f32)z / quads);
+        }
+    }
+    
+    u32 idx = 0;
+    for (u32 z = 0; z < quads; z++) {
+        for (u32 x = 0; x < quads; x++) {
+            u32 top_left = z * side + x;
+            u32 top_right = top_left + 1;
+            u32 bottom_left = (z + 1) * side + x;
+            u32 bottom_right = bottom_left + 1;
+            
+            indices[idx++] = top_left;
+            indices[idx++] = bottom_left;
+            indices[idx++] = top_right;
             
-            Vec3 normal = vec3_create(hL - hR, 2.0f, hD - hU);
-            vertices[(z * grid_size) + x].normal = vec3_normalize(normal);
+            indices[idx++] = top_right;
+            indices[idx++] = bottom_left;
+            indices[idx++] = bottom_right;
         }
     }
+    
+    /* Every node draws it, so the cache order pays off many times a frame */
+    mesh_optimize_vertex_cache(indices, index_count, vertex_count);
+    MeshHandle mesh = mesh_create(vertices, vertex_count, indices, index_count, MESH_VERTEX_COMPACT);
+    scratch_end(scratch);
+    return mesh;
+}
+
+/* Range of level 0; level n reaches 2^n times as far */
+static f32 terrain_lod_range(const Terrain* terrain) {
+    f32 spacing = terrain->scale_x > terrain->scale_z ? terrain->scale_x : terrain->scale_z;
+    return TERRAIN_LOD_RANGE * TERRAIN_CHUNK_QUADS * spacing;
+}
+
+/* Height ranges of every quadtree node: leaves from their samples, edges
+ * shared with the next leaf included, and each level up from the four
+ * nodes below it */
+static bool build_node_bounds(Terrain* terrain) {
+    u32 quads_x = terrain->width - 1;
+    u32 quads_z = terrain->depth - 1;
+    
+    u32 total = 0;
+    u32 rows[TERRAIN_MAX_LEVELS];
+    for (u32 level = 0; level < terrain->lod_levels; level++) {
+        u32 size = (u32)TERRAIN_CHUNK_QUADS << level;
+        terrain->level_offset[level] = total;
+        terrain->level_columns[level] = (quads_x + size - 1) / size;
+        rows[level] = (quads_z + size - 1) / size;
+        total += terrain->level_columns[level] * rows[level];
+    }
+    
+    terrain->node_bounds = (TerrainNodeBounds*)malloc(total * sizeof(TerrainNodeBounds));
+    if (!terrain->node_bounds) return false;
+    
+    TerrainNodeBounds* leaves = terrain->node_bounds;
+    for (u32 row = 0; row < rows[0]; row++) {
+        for (u32 column = 0; column < terrain->level_columns[0]; column++) {
+            u32 x0 = column * TERRAIN_CHUNK_QUADS;
+            u32 z0 = row * TERRAIN_CHUNK_QUADS;
+            u32 x1 = x0 + TERRAIN_CHUNK_QUADS < quads_x ? x0 + TERRAIN_CHUNK_QUADS : quads_x;
+            u32 z1 = z0 + TERRAIN_CHUNK_QUADS < quads_z ? z0 + TERRAIN_CHUNK_QUADS : quads_z;
+            
+            TerrainNodeBounds bounds = { terrain->heights[z0 * terrain->width + x0],
+                                         terrain->heights[z0 * terrain->width + x0] };
+            for (u32 z = z0; z <= z1; z++) {
+                const f32* row_heights = &terrain->heights[z * terrain->width];
+                for (u32 x = x0; x <= x1; x++) {
+                    if (row_heights[x] < bounds.min) bounds.min = row_heights[x];
+                    if (row_heights[x] > bounds.max) bounds.max = row_heights[x];
+                }
+            }
+            leaves[row * terrain->level_columns[0] + column] = bounds;
+        }
+    }
+    
+    for (u32 level = 1; level < terrain->lod_levels; level++) {
+        const TerrainNodeBounds* below = &terrain->node_bounds[terrain->level_offset[level - 1]];
+        TerrainNodeBounds* nodes = &terrain->node_bounds[terrain->level_offset[level]];
+        u32 below_columns = terrain->level_columns[level - 1];
+        u32 below_rows = rows[level - 1];
+        
+        for (u32 row = 0; row < rows[level]; row++) {
+            for (u32 column = 0; column < terrain->level_columns[level]; column++) {
+                /* The first child always exists; the others may be past the edge */
+                TerrainNodeBounds bounds = below[(row * 2) * below_columns + column * 2];
+                for (u32 child = 1; child < 4; child++) {
+                    u32 child_column = column * 2 + (child & 1u);
+                    u32 child_row = row * 2 + (child >> 1);
+                    if (child_column >= below_columns || child_row >= below_rows) continue;
+                    
+                    const TerrainNodeBounds* c = &below[child_row * below_columns + child_column];
+                    if (c->min < bounds.min) bounds.min = c->min;
+                    if (c->max > bounds.max) bounds.max = c->max;
+                }
+                nodes[row * terrain->level_columns[level] + column] = bounds;
+            }
+        }
+    }
+    
+    /* The root holds the whole terrain's range */
+    const TerrainNodeBounds* root = &terrain->node_bounds[terrain->level_offset[terrain->lod_levels - 1]];
+    terrain->min_height = root->min;
+    terrain->max_height = root->max;
+    return true;
 }
 
 Terrain* terrain_create_from_heightmap(const u8* heightmap_data, u32 width, u32 height,
                                        f32 scale_x, f32 scale_y, f32 scale_z) {
-    Terrain* terrain = (Terrain*)malloc(sizeof(Terrain));
+    if (width < 2 || height < 2) return NULL;
+    
+    Terrain* terrain = (Terrain*)calloc(1, sizeof(Terrain));
     if (!terrain) return NULL;
     
+    PROFILE_BEGIN("terrain_create_from_heightmap");
+    
     terrain->width = width;
     terrain->depth = height;
     terrain->scale_x = scale_x;
     terrain->scale_y = scale_y;
     terrain->scale_z = scale_z;
-    terrain->min_height = 0.0f;
-    terrain->max_height = scale_y;
-    
     /* Allocate heights array */
     terrain->heights = (f32*)malloc(width * height * sizeof(f32));
     if (!terrain->heights) {
         free(terrain);
+        PROFILE_END();
         return NULL;
     }
     
@@ -105,82 +223,47 @@ Terrain* terrain_create_from_heightmap(const u8* heightmap_data, u32 width, u32
         terrain->heights[i] = (f32)heightmap_data[i] / 255.0f * scale_y;
     }
     
-    /* Create vertices */
-    u32 vertex_count = width * height;
-    Vertex* vertices = (Vertex*)malloc(vertex_count * sizeof(Vertex));
-    if (!vertices) {
-        free(terrain->heights);
-        free(terrain);
-        return NULL;
+    /* Enough levels for the root to cover every quad */
+    u32 quads = (width > height ? width : height) - 1;
+    terrain->lod_levels = 1;
+    while (((u32)TERRAIN_CHUNK_QUADS << (terrain->lod_levels - 1)) < quads &&
+           terrain->lod_levels < TERRAIN_MAX_LEVELS) {
+        terrain->lod_levels++;
     }
-    
-    f32 half_width = (width - 1) * scale_x / 2.0f;
-    f32 half_depth = (height - 1) * scale_z / 2.0f;
-    
-    for (u32 z = 0; z < height; z++) {
-        for (u32 x = 0; x < width; x++) {
-            u32 i = z * width + x;
-            vertices[i].position = vec3_create(
-                x * scale_x - half_width,
-                terrain->heights[i],
-                z * scale_z - half_depth
-            );
-            vertices[i].texcoord = vec2_create(
-                (f32)x / (width - 1),
-                (f32)z / (height - 1)
-            );
-        }
-    }
-    
-    /* Calculate normals */
-    calculate_normals(terrain, vertices);
-    
-    /* Create indices */
-    u32 index_count = (width - 1) * (height - 1) * 6;
-    u32* indices = (u32*)malloc(index_count * sizeof(u32));
-    if (!indices) {
-        free(vertices);
-        free(terrain->heights);
-        free(terrain);
+    if (!build_node_bounds(terrain)) {
+        fprintf(stderr, "Failed to allocate terrain quadtree\n");
+        terrain_destroy(terrain);
+        PROFILE_END();
         return NULL;
     }
     
-    u32 idx = 0;
-    for (u32 z = 0; z < height - 1; z++) {
-        for (u32 x = 0; x < width - 1; x++) {
-            u32 top_left = z * width + x;
-            u32 top_right = top_left + 1;
-            u32 bottom_left = (z + 1) * width + x;
-            u32 bottom_right = bottom_left + 1;
-            
-            indices[idx++] = top_left;
-            indices[idx++] = bottom_left;
-            indices[idx++] = top_right;
-            
-            indices[idx++] = top_right;
-            indices[idx++] = bottom_left;
-            indices[idx++] = bottom_right;
-        }
-    }
-    
-    terrain->mesh = mesh_create(vertices, vertex_count, indices, index_count);
-    
-    free(vertices);
-    free(indices);
-    
-    if (!terrain->mesh) {
-        free(terrain->heights);
-        free(terrain);
+    /* The heights go to the GPU once; chunks only carry grid positions */
+    terrain->chunk_mesh = create_grid_mesh(TERRAIN_CHUNK_QUADS);
+    terrain->half_chunk_mesh = create_grid_mesh(TERRAIN_CHUNK_QUADS / 2);
+    terrain->height_texture = texture_create(width, height, TEXTURE_R32F, terrain->heights);
+    if (!HANDLE_IS_VALID(terrain->chunk_mesh) || !HANDLE_IS_VALID(terrain->half_chunk_mesh) ||
+        !HANDLE_IS_VALID(terrain->height_texture)) {
+        fprintf(stderr, "Failed to create terrain chunks\n");
+        terrain_destroy(terrain);
+        PROFILE_END();
         return NULL;
     }
     
+    PROFILE_END();
     return terrain;
 }
 
 Terrain* terrain_create_procedural(u32 width, u32 depth, f32 scale_x, f32 scale_y, f32 scale_z) {
+    PROFILE_BEGIN("terrain_create_procedural");
+    
     /* Generate procedural heightmap */
-    u8* heightmap = (u8*)malloc(width * depth);
-    if (!heightmap) return NULL;
+    Scratch scratch = scratch_begin();
+    u8* heightmap = arena_push_array(scratch.arena, u8, width * depth);
+    if (!heightmap) {
+        scratch_end(scratch);
+        PROFILE_END();
+        return NULL;
+    }
     
     for (u32 z = 0; z < depth; z++) {
         for (u32 x = 0; x < width; x++) {
@@ -192,17 +275,21 @@ Terrain* terrain_create_procedural(u32 width, u32 depth, f32 scale_x, f32 scale_
     }
     
     Terrain* terrain = terrain_create_from_heightmap(heightmap, width, depth, scale_x, scale_y, scale_z);
-    free(heightmap);
+    scratch_end(scratch);
     
+    PROFILE_END();
     return terrain;
 }
 
 void terrain_destroy(Terrain* terrain) {
     if (!terrain) return;
     
-    if (terrain->mesh) {
-        mesh_destroy(terrain->mesh);
-    }
+    mesh_destroy(terrain->chunk_mesh);
+    mesh_destroy(terrain->half_chunk_mesh);
+    texture_destroy(terrain->height_texture);
+    free(terrain->nodes.instances);
+    free(terrain->quarter_nodes.instances);
+    free(terrain->node_bounds);
     free(terrain->heights);
     free(terrain);
 }
@@ -253,8 +340,157 @@ Vec3 terrain_get_normal_at(const Terrain* terrain, f32 world_x, f32 world_z) {
     return vec3_normalize(normal);
 }
 
-void terrain_draw(const Terrain* terrain) {
-    if (terrain && terrain->mesh) {
-        mesh_draw(terrain->mesh);
+void terrain_setup_shader(const Terrain* terrain, ShaderHandle handle, u32 features) {
+    Shader* shader = shader_get_variant(handle, features);
+    if (!terrain || !shader) return;
+    
+    f32 half_width = (terrain->width - 1) * terrain->scale_x / 2.0f;
+    f32 half_depth = (terrain->depth - 1) * terrain->scale_z / 2.0f;
+    f32 range = terrain_lod_range(terrain);
+    
+    shader_use(shader);
+    shader_set_int(shader, uniform_id("terrainHeights"), 0);
+    shader_set_vec2(shader, uniform_id("terrainOrigin"), vec2_create(-half_width, -half_depth));
+    shader_set_vec2(shader, uniform_id("terrainSpacing"), vec2_create(terrain->scale_x, terrain->scale_z));
+    shader_set_vec2(shader, uniform_id("terrainMorph"), vec2_create(range * TERRAIN_MORPH_START, range));
+}
+
+/* State of one terrain_draw walk */
+typedef struct {
+    Terrain* terrain;
+    const Frustum* frustum;
+    Vec3 camera;
+    f32 origin_x;      /* World x and z of sample 0, 0 */
+    f32 origin_z;
+    f32 range;         /* Of level 0 */
+    Color color;
+} NodeSelection;
+
+/* World bounds of a node from its stored height range; nodes on the far
+ * edges of the terrain are cut to the heightmap */
+static void node_world_bounds(const NodeSelection* selection, u32 x, u32 z, u32 level,
+                              Vec3* min, Vec3* max) {
+    const Terrain* terrain = selection->terrain;
+    u32 size = (u32)TERRAIN_CHUNK_QUADS << level;
+    u32 end_x = x + size < terrain->width - 1 ? x + size : terrain->width - 1;
+    u32 end_z = z + size < terrain->depth - 1 ? z + size : terrain->depth - 1;
+    
+    u32 index = terrain->level_offset[level] + (z / size) * terrain->level_columns[level] + x / size;
+    const TerrainNodeBounds* bounds = &terrain->node_bounds[index];
+    *min = vec3_create(selection->origin_x + x * terrain->scale_x, bounds->min,
+                       selection->origin_z + z * terrain->scale_z);
+    *max = vec3_create(selection->origin_x + end_x * terrain->scale_x, bounds->max,
+                       selection->origin_z + end_z * terrain->scale_z);
+}
+
+/* Whether the camera is within range of the bounds for a level's detail */
+static bool bounds_in_range(const NodeSelection* selection, Vec3 min, Vec3 max, u32 level) {
+    f32 box_min[3] = { min.x, min.y, min.z };
+    f32 box_max[3] = { max.x, max.y, max.z };
+    f32 camera[3] = { selection->camera.x, selection->camera.y, selection->camera.z };
+    
+    f32 distance_sq = 0.0f;
+    for (u32 axis = 0; axis < 3; axis++) {
+        f32 d = 0.0f;
+        if (camera[axis] < box_min[axis]) d = box_min[axis] - camera[axis];
+        else if (camera[axis] > box_max[axis]) d = camera[axis] - box_max[axis];
+        distance_sq += d * d;
+    }
+    
+    f32 range = selection->range * (f32)(1u << level);
+    return distance_sq <= range * range;
+}
+
+/* Record a node drawn at level's sample spacing */
+static void add_node(const NodeSelection* selection, TerrainNodeList* nodes, u32 x, u32 z, u32 level) {
+    if (nodes->count == nodes->capacity) {
+        u32 capacity = nodes->capacity ? nodes->capacity * 2 : 64;
+        MeshInstance* instances = (MeshInstance*)realloc(nodes->instances,
+                                                         capacity * sizeof(MeshInstance));
+        if (!instances) return;
+        nodes->instances = instances;
+        nodes->capacity = capacity;
     }
+    
+    f32 spacing = (f32)(1u << level);
+    MeshInstance* instance = &nodes->instances[nodes->count++];
+    instance->model = (Mat3x4){{spacing, 0.0f, 0.0f, (f32)x,
+                                0.0f, 1.0f, 0.0f, 0.0f,
+                                0.0f, 0.0f, spacing, (f32)z}};
+    instance->color = selection->color;
+}
+
+/* Draw the node at the lowest level whose range reaches it. False when
+ * even this level's range falls short, leaving the node to its parent;
+ * nodes out of view count as done, so nothing draws them. */
+static bool select_node(NodeSelection* selection, u32 x, u32 z, u32 level) {
+    Terrain* terrain = selection->terrain;
+    Vec3 min, max;
+    node_world_bounds(selection, x, z, level, &min, &max);
+    if (!frustum_test_aabb(selection->frustum, min, max)) return true;
+    if (!bounds_in_range(selection, min, max, level)) return false;
+    
+    u32 size = (u32)TERRAIN_CHUNK_QUADS << level;
+    if (level == 0 || !bounds_in_range(selection, min, max, level - 1)) {
+        add_node(selection, &terrain->nodes, x, z, level);
+        return true;
+    }
+    
+    /* Nearest quarter first, so chunks come out roughly front to back */
+    u32 half = size / 2;
+    f32 center_x = selection->origin_x + (x + half) * terrain->scale_x;
+    f32 center_z = selection->origin_z + (z + half) * terrain->scale_z;
+    u32 nearest = (selection->camera.x > center_x ? 1u : 0u) | (selection->camera.z > center_z ? 2u : 0u);
+    for (u32 i = 0; i < 4; i++) {
+        u32 quarter = i ^ nearest;
+        u32 child_x = x + (quarter & 1u) * half;
+        u32 child_z = z + (quarter >> 1) * half;
+        if (child_x >= terrain->width - 1 || child_z >= terrain->depth - 1) continue;
+        
+        /* Out of the finer level's range: this level draws the quarter */
+        if (!select_node(selection, child_x, child_z, level - 1)) {
+            add_node(selection, &terrain->quarter_nodes, child_x, child_z, level);
+        }
+    }
+    return true;
+}
+
+static void add_node_batch(DrawList* list, ShaderHandle shader, u32 features, MeshHandle mesh,
+                           TextureHandle texture, const TerrainNodeList* nodes) {
+    MeshInstance* instances = draw_list_add_textured_instances(list, shader, features, mesh, texture,
+                                                               0, nodes->count);
+    if (instances) {
+        memcpy(instances, nodes->instances, nodes->count * sizeof(MeshInstance));
+    }
+}
+
+void terrain_draw(Terrain* terrain, DrawList* list, const Frustum* frustum, ShaderHandle shader,
+                  u32 features, Color color) {
+    if (!terrain) return;
+    
+    PROFILE_BEGIN("terrain_draw");
+    
+    NodeSelection selection;
+    selection.terrain = terrain;
+    selection.frustum = frustum;
+    selection.camera = list->view_position;
+    selection.origin_x = -(f32)(terrain->width - 1) * terrain->scale_x / 2.0f;
+    selection.origin_z = -(f32)(terrain->depth - 1) * terrain->scale_z / 2.0f;
+    selection.range = terrain_lod_range(terrain);
+    selection.color = color;
+    
+    /* Past the root's range the terrain is drawn at its coarsest, if at all */
+    terrain->nodes.count = 0;
+    terrain->quarter_nodes.count = 0;
+    u32 root = terrain->lod_levels - 1;
+    if (!select_node(&selection, 0, 0, root)) {
+        add_node(&selection, &terrain->nodes, 0, 0, root);
+    }
+    
+    add_node_batch(list, shader, features, terrain->chunk_mesh, terrain->height_texture,
+                   &terrain->nodes);
+    add_node_batch(list, shader, features, terrain->half_chunk_mesh, terrain->height_texture,
+                   &terrain->quarter_nodes);
+    
+    PROFILE_END();
 }
@@ -3,19 +3,106 @@
 
 #include "../core/types.h"
 #include "../renderer/mesh.h"
+#include "../renderer/draw_list.h"
+#include "../renderer/culling.h"
 #include "../math/vec3.h"
 
+/* Terrain is drawn in chunks with continuous distance-dependent LOD
+ * (CDLOD). A quadtree covers the heightmap: its leaves are chunks of
+ * TERRAIN_CHUNK_QUADS quads a side, and each level up doubles the area a
+ * node covers and the spacing of the samples it draws. Every node draws
+ * the same grid mesh, instanced, and the vertex shader reads the heights
+ * from a texture.
+ *
+ * Each level has a range around the camera, TERRAIN_LOD_RANGE of its own
+ * node sizes, so the ranges double per level. The finest level covering an
+ * area is the lowest whose range reaches it, which keeps the triangles per
+ * level roughly constant: the count grows with the view distance's log,
+ * not with the heightmap. Over the last part of its range a level's
+ * vertices slide onto the grid of the next level up, so levels meet
+ * without cracks and a node changing level does not pop. */
+
+#define TERRAIN_CHUNK_QUADS 32       /* Even, so a node halves into quarters */
+#define TERRAIN_LOD_RANGE 4.0f       /* Range of a level in node sizes of that level */
+#define TERRAIN_MORPH_START 0.7f     /* Fraction of the range where morphing starts */
+#define TERRAIN_MAX_LEVELS 16        /* The root then spans TERRAIN_CHUNK_QUADS << 15 quads */
+
+/* Vertex shader code for terrain chunks; include after MESH_VERTEX_GLSL
+ * and FRAME_UNIFORMS_GLSL. terrainVertex gives the world position, normal
+ * and texture coordinate of the current vertex, morphed. Instances are
+ * nodes whose model rows take grid vertices to heightmap samples;
+ * terrain_setup_shader sets the terrain* uniforms. */
+#define TERRAIN_VERTEX_GLSL \
+    "layout (location = 3) in vec4 aModelRow0;\n" \
+    "layout (location = 4) in vec4 aModelRow1;\n" \
+    "layout (location = 5) in vec4 aModelRow2;\n" \
+    "layout (location = 6) in vec4 aColor;\n" \
+    "uniform sampler2D terrainHeights;\n" \
+    "uniform vec2 terrainOrigin;\n"   /* World x and z of sample 0, 0 */ \
+    "uniform vec2 terrainSpacing;\n"  /* World distance between samples */ \
+    "uniform vec2 terrainMorph;\n"    /* Level 0 morph start and end distance */ \
+    "vec2 terrainSample(vec2 grid) {\n" \
+    "    vec2 s = (vec4(grid.x, 0.0, grid.y, 1.0) * mat3x4(aModelRow0, aModelRow1, aModelRow2)).xz;\n" \
+    "    return clamp(s, vec2(0.0), vec2(textureSize(terrainHeights, 0) - 1));\n" \
+    "}\n" \
+    "float terrainHeight(vec2 s) {\n" \
+    "    return texture(terrainHeights, (s + 0.5) / vec2(textureSize(terrainHeights, 0))).r;\n" \
+    "}\n" \
+    "vec3 terrainWorld(vec2 s) {\n" \
+    "    return vec3(terrainOrigin.x + s.x * terrainSpacing.x, terrainHeight(s),\n" \
+    "                terrainOrigin.y + s.y * terrainSpacing.y);\n" \
+    "}\n" \
+    "void terrainVertex(out vec3 position, out vec3 normal, out vec2 texcoord) {\n" \
+    "    vec2 grid = floor(meshPosition().xz + 0.5);\n" \
+    "    float spacing = aModelRow0.x;\n" \
+    "    float dist = distance(terrainWorld(terrainSample(grid)), viewPos.xyz);\n" \
+    "    vec2 morph = terrainMorph * spacing;\n" \
+    "    float t = clamp((dist - morph.x) / (morph.y - morph.x), 0.0, 1.0);\n" \
+    "    vec2 s = terrainSample(grid - fract(grid * 0.5) * 2.0 * t);\n" \
+    "    position = terrainWorld(s);\n" \
+    "    vec2 dx = vec2(spacing, 0.0);\n" \
+    "    vec2 dz = vec2(0.0, spacing);\n" \
+    "    float slope_x = (terrainHeight(s + dx) - terrainHeight(s - dx)) / (2.0 * spacing * terrainSpacing.x);\n" \
+    "    float slope_z = (terrainHeight(s + dz) - terrainHeight(s - dz)) / (2.0 * spacing * terrainSpacing.y);\n" \
+    "    normal = normalize(vec3(-slope_x, 1.0, -slope_z));\n" \
+    "    texcoord = s / vec2(textureSize(terrainHeights, 0) - 1);\n" \
+    "}\n"
+
+/* Nodes picked by terrain_draw, as instances of the chunk meshes: model
+ * rows take grid vertex (x, 0, z) to heightmap sample coordinates (x
+ * spacing plus the node's first sample), and the color is the terrain's */
+typedef struct {
+    MeshInstance* instances;
+    u32 count;
+    u32 capacity;
+} TerrainNodeList;
+
+/* Lowest and highest sample under a quadtree node, its bounds' y extent */
+typedef struct {
+    f32 min;
+    f32 max;
+} TerrainNodeBounds;
+
 /* Terrain structure */
 typedef struct {
-    Mesh* mesh;
     f32* heights;
     u32 width;
     u32 depth;
     f32 scale_x;
     f32 scale_y;
     f32 scale_z;
-    f32 min_height;
+    f32 min_height;                /* Of all samples, the root's bounds */
     f32 max_height;
+    
+    MeshHandle chunk_mesh;         /* TERRAIN_CHUNK_QUADS grid drawn by every node */
+    MeshHandle half_chunk_mesh;    /* Half that, for a quarter of a node */
+    TextureHandle height_texture;  /* heights, one R32F texel per sample */
+    u32 lod_levels;                /* The root is level lod_levels - 1 */
+    TerrainNodeBounds* node_bounds;             /* All levels, finest first, row by row */
+    u32 level_offset[TERRAIN_MAX_LEVELS];       /* First node of each level in node_bounds */
+    u32 level_columns[TERRAIN_MAX_LEVELS];      /* Nodes per row of each level */
+    TerrainNodeList nodes;         /* Last frame's selection */
+    TerrainNodeList quarter_nodes;
 } Terrain;
 
 /* Create terrain from heightmap data (grayscale, 8-bit per pixel) */
@@ -34,7 +121,16 @@ f32 terrain_get_height_at(const Terrain* terrain, f32 world_x, f32 world_z);
 /* Get normal at world position */
 Vec3 terrain_get_normal_at(const Terrain* terrain, f32 world_x, f32 world_z);
 
-/* Draw terrain */
-void terrain_draw(const Terrain* terrain);
+/* Point the terrain* uniforms of a shader using TERRAIN_VERTEX_GLSL at
+ * this terrain; for a variant shader, of the variant with these features,
+ * which terrain_draw must then be given. Uses GL, so call before the
+ * first frame. */
+void terrain_setup_shader(const Terrain* terrain, ShaderHandle shader, u32 features);
+
+/* Pick the nodes to draw from the list's camera and add them to the list,
+ * as two instanced batches of shader. Nodes whose bounds are outside the
+ * frustum are skipped along with everything under them. */
+void terrain_draw(Terrain* terrain, DrawList* list, const Frustum* frustum, ShaderHandle shader,
+                  u32 features, Color color);
 
 #endif /* TERRAIN_H */
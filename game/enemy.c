@@ -1,5 +1,7 @@
 #include "enemy.h"
+#include "../engine/core/profiler.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #ifndef M_PI
@@ -11,14 +13,29 @@ EnemyManager* enemy_manager_create(u32 initial_capacity) {
     if (!manager) return NULL;
     
     manager->enemies = (Enemy*)malloc(initial_capacity * sizeof(Enemy));
-    if (!manager->enemies) {
+    manager->distances = (f32*)malloc(initial_capacity * sizeof(f32));
+    manager->bounds_radii = (f32*)malloc(initial_capacity * sizeof(f32));
+    manager->visible = (u32*)malloc(initial_capacity * sizeof(u32));
+    manager->to_player = (Vec3Stream){0};
+    manager->bounds_centers = (Vec3Stream){0};
+    if (!manager->enemies || !manager->distances || !manager->bounds_radii || !manager->visible ||
+        !vec3_stream_reserve(&manager->to_player, initial_capacity) ||
+        !vec3_stream_reserve(&manager->bounds_centers, initial_capacity)) {
+        vec3_stream_free(&manager->to_player);
+        vec3_stream_free(&manager->bounds_centers);
+        free(manager->enemies);
+        free(manager->distances);
+        free(manager->bounds_radii);
+        free(manager->visible);
         free(manager);
         return NULL;
     }
     
     manager->count = 0;
     manager->capacity = initial_capacity;
-    manager->shared_mesh = NULL;
+    manager->shared_mesh = (MeshHandle){INVALID_HANDLE};
+    manager->jobs = NULL;
+    manager->visible_count = 0;
     
     return manager;
 }
@@ -26,11 +43,16 @@ EnemyManager* enemy_manager_create(u32 initial_capacity) {
 void enemy_manager_destroy(EnemyManager* manager) {
     if (!manager) return;
     
+    vec3_stream_free(&manager->to_player);
+    vec3_stream_free(&manager->bounds_centers);
+    free(manager->distances);
+    free(manager->bounds_radii);
+    free(manager->visible);
     free(manager->enemies);
     free(manager);
 }
 
-void enemy_manager_set_mesh(EnemyManager* manager, Mesh* mesh) {
+void enemy_manager_set_mesh(EnemyManager* manager, MeshHandle mesh) {
     if (!manager) return;
     
     manager->shared_mesh = mesh;
@@ -41,6 +63,12 @@ void enemy_manager_set_mesh(EnemyManager* manager, Mesh* mesh) {
     }
 }
 
+void enemy_manager_set_jobs(EnemyManager* manager, JobSystem* jobs) {
+    if (!manager) return;
+    
+    manager->jobs = jobs;
+}
+
 Enemy* enemy_manager_spawn(EnemyManager* manager, Vec3 position, f32 health) {
     if (!manager) return NULL;
     
@@ -49,8 +77,23 @@ Enemy* enemy_manager_spawn(EnemyManager* manager, Vec3 position, f32 health) {
         u32 new_capacity = manager->capacity * 2;
         Enemy* new_enemies = (Enemy*)realloc(manager->enemies, new_capacity * sizeof(Enemy));
         if (!new_enemies) return NULL;
-        
         manager->enemies = new_enemies;
+        
+        f32* new_distances = (f32*)realloc(manager->distances, new_capacity * sizeof(f32));
+        if (!new_distances) return NULL;
+        manager->distances = new_distances;
+        
+        f32* new_radii = (f32*)realloc(manager->bounds_radii, new_capacity * sizeof(f32));
+        if (!new_radii) return NULL;
+        manager->bounds_radii = new_radii;
+        
+        u32* new_visible = (u32*)realloc(manager->visible, new_capacity * sizeof(u32));
+        if (!new_visible) return NULL;
+        manager->visible = new_visible;
+        
+        if (!vec3_stream_reserve(&manager->to_player, new_capacity)) return NULL;
+        if (!vec3_stream_reserve(&manager->bounds_centers, new_capacity)) return NULL;
+        
         manager->capacity = new_capacity;
     }
     
@@ -59,6 +102,8 @@ Enemy* enemy_manager_spawn(EnemyManager* manager, Vec3 position, f32 health) {
     enemy->position = position;
     enemy->velocity = vec3_create(0, 0, 0);
     enemy->yaw = 0.0f;
+    enemy->previous_position = position;
+    enemy->previous_yaw = 0.0f;
     enemy->move_speed = 4.0f;
     enemy->health = health;
     enemy->max_health = health;
@@ -74,14 +119,14 @@ Enemy* enemy_manager_spawn(EnemyManager* manager, Vec3 position, f32 health) {
     return enemy;
 }
 
-static void enemy_update_single(Enemy* enemy, Vec3 player_position, 
+/* distance and dir are the horizontal distance and direction to the player,
+ * computed for all enemies up front by enemy_manager_update */
+static void enemy_update_single(Enemy* enemy, f32 distance, Vec3 dir,
                                 const Terrain* terrain, f32 delta_time) {
     if (enemy->state == ENEMY_STATE_DEAD) return;
     
-    /* Calculate distance to player */
-    Vec3 to_player = vec3_sub(player_position, enemy->position);
-    to_player.y = 0.0f; /* Ignore vertical distance for AI */
-    f32 distance = vec3_length(to_player);
+    enemy->previous_position = enemy->position;
+    enemy->previous_yaw = enemy->yaw;
     
     /* Update state based on distance */
     if (distance < enemy->attack_range) {
@@ -98,7 +143,6 @@ static void enemy_update_single(Enemy* enemy, Vec3 player_position,
         case ENEMY_STATE_ATTACK: {
             /* Face player */
             if (distance > 0.001f) {
-                Vec3 dir = vec3_normalize(to_player);
                 enemy->yaw = atan2f(dir.x, dir.z) * 180.0f / M_PI;
                 
                 /* Move towards player if chasing */
@@ -142,15 +186,52 @@ static void enemy_update_single(Enemy* enemy, Vec3 player_position,
     }
 }
 
+/* Enemies per job; below this the update stays on the calling thread */
+#define ENEMY_UPDATE_BATCH 256
+
+typedef struct {
+    EnemyManager* manager;
+    const Terrain* terrain;
+    f32 delta_time;
+} EnemyUpdateJob;
+
+/* Each enemy only writes its own state, so ranges run independently */
+static void enemy_update_range(void* data, u32 begin, u32 end) {
+    EnemyUpdateJob* job = (EnemyUpdateJob*)data;
+    EnemyManager* manager = job->manager;
+    
+    for (u32 i = begin; i < end; i++) {
+        enemy_update_single(&manager->enemies[i], manager->distances[i],
+                            vec3_stream_get(&manager->to_player, i), job->terrain, job->delta_time);
+    }
+}
+
 void enemy_manager_update(EnemyManager* manager, Vec3 player_position, 
                           const Terrain* terrain, f32 delta_time, f32 current_time) {
     (void)current_time;
     
     if (!manager) return;
     
+    PROFILE_BEGIN("enemy_manager_update");
+    
+    /* Batch pass: horizontal offsets to the player (vertical distance is
+     * ignored for AI), then their lengths and directions in one sweep each */
+    Vec3Stream* to_player = &manager->to_player;
     for (u32 i = 0; i < manager->count; i++) {
-        enemy_update_single(&manager->enemies[i], player_position, terrain, delta_time);
+        to_player->x[i] = player_position.x - manager->enemies[i].position.x;
+        to_player->y[i] = 0.0f;
+        to_player->z[i] = player_position.z - manager->enemies[i].position.z;
     }
+    to_player->count = manager->count;
+    
+    vec3_stream_length(manager->distances, to_player);
+    vec3_stream_normalize(to_player, to_player);
+    
+    EnemyUpdateJob job = {manager, terrain, delta_time};
+    job_system_parallel_for(manager->jobs, manager->count, ENEMY_UPDATE_BATCH,
+                            enemy_update_range, &job);
+    
+    PROFILE_END();
 }
 
 f32 enemy_manager_check_attacks(EnemyManager* manager, Vec3 player_position, f32 current_time) {
@@ -180,6 +261,106 @@ f32 enemy_manager_check_attacks(EnemyManager* manager, Vec3 player_position, f32
     return total_damage;
 }
 
+u32 enemy_manager_cull(EnemyManager* manager, const Frustum* frustum, f32 alpha) {
+    if (!manager) return 0;
+    
+    /* Gather world-space bounding spheres; dead enemies keep their slot but
+     * can never pass */
+    Vec3Stream* centers = &manager->bounds_centers;
+    for (u32 i = 0; i < manager->count; i++) {
+        const Enemy* enemy = &manager->enemies[i];
+        const Mesh* mesh = mesh_get(enemy->mesh);
+        Vec3 center = enemy->position;
+        f32 radius = enemy->enemy_radius;
+        if (mesh) {
+            Transform transform = enemy_get_interpolated_transform(enemy, alpha);
+            center = transform_point(&transform, mesh->bounds_center);
+            radius = mesh->bounds_radius;
+        }
+        vec3_stream_set(centers, i, center);
+        manager->bounds_radii[i] = enemy_is_alive(enemy) ? radius : CULL_REJECT;
+    }
+    centers->count = manager->count;
+    
+    manager->visible_count = cull_spheres(frustum, centers, manager->bounds_radii, manager->visible);
+    return manager->visible_count;
+}
+
+void enemy_manager_group_lods(EnemyManager* manager, const DrawList* list,
+                              Arena* frame_arena, u32 lod_counts[MESH_MAX_LODS]) {
+    for (u32 lod = 0; lod < MESH_MAX_LODS; lod++) lod_counts[lod] = 0;
+    if (!manager || manager->visible_count == 0) return;
+    
+    /* Without a mesh (or LODs) everything is LOD 0 already */
+    const Mesh* mesh = mesh_get(manager->shared_mesh);
+    if (!mesh || mesh->lod_count < 2) {
+        lod_counts[0] = manager->visible_count;
+        return;
+    }
+    
+    PROFILE_BEGIN("enemy_manager_group_lods");
+    u8* lods = arena_push_array(frame_arena, u8, manager->visible_count);
+    u32* grouped = arena_push_array(frame_arena, u32, manager->visible_count);
+    if (!lods || !grouped) {
+        lod_counts[0] = manager->visible_count;
+        PROFILE_END();
+        return;
+    }
+    
+    /* Culling left the bounding spheres in place */
+    for (u32 v = 0; v < manager->visible_count; v++) {
+        u32 i = manager->visible[v];
+        Vec3 center = vec3_stream_get(&manager->bounds_centers, i);
+        lods[v] = (u8)draw_list_select_lod(list, mesh, center, manager->bounds_radii[i]);
+        lod_counts[lods[v]]++;
+    }
+    
+    /* Counting sort, stable so each group keeps the culling order */
+    u32 offsets[MESH_MAX_LODS];
+    u32 sum = 0;
+    for (u32 lod = 0; lod < MESH_MAX_LODS; lod++) {
+        offsets[lod] = sum;
+        sum += lod_counts[lod];
+    }
+    for (u32 v = 0; v < manager->visible_count; v++) {
+        grouped[offsets[lods[v]]++] = manager->visible[v];
+    }
+    memcpy(manager->visible, grouped, manager->visible_count * sizeof(u32));
+    
+    PROFILE_END();
+}
+
+typedef struct {
+    const EnemyManager* manager;
+    f32 alpha;
+    Color color;
+    u32 first;
+    MeshInstance* instances;
+} EnemyInstanceJob;
+
+static void enemy_instance_range(void* data, u32 begin, u32 end) {
+    EnemyInstanceJob* job = (EnemyInstanceJob*)data;
+    const EnemyManager* manager = job->manager;
+    
+    for (u32 v = begin; v < end; v++) {
+        const Enemy* enemy = &manager->enemies[manager->visible[job->first + v]];
+        Transform transform = enemy_get_interpolated_transform(enemy, job->alpha);
+        job->instances[v].model = transform_to_mat3x4(&transform);
+        job->instances[v].color = job->color;
+    }
+}
+
+void enemy_manager_write_instances(const EnemyManager* manager, f32 alpha, Color color,
+                                   u32 first, u32 count, MeshInstance* instances) {
+    if (!manager || !instances) return;
+    
+    PROFILE_BEGIN("enemy_manager_write_instances");
+    EnemyInstanceJob job = {manager, alpha, color, first, instances};
+    job_system_parallel_for(manager->jobs, count, ENEMY_UPDATE_BATCH,
+                            enemy_instance_range, &job);
+    PROFILE_END();
+}
+
 u32 enemy_manager_alive_count(const EnemyManager* manager) {
     if (!manager) return 0;
     
@@ -204,8 +385,24 @@ bool enemy_is_alive(const Enemy* enemy) {
     return enemy->health > 0.0f && enemy->state != ENEMY_STATE_DEAD;
 }
 
+Transform enemy_get_transform(const Enemy* enemy) {
+    return transform_create(enemy->position, quat_rotate_y(enemy->yaw * M_PI / 180.0f),
+                            vec3_create(1.0f, 1.0f, 1.0f));
+}
+
+Transform enemy_get_interpolated_transform(const Enemy* enemy, f32 alpha) {
+    Transform previous = transform_create(enemy->previous_position,
+                                          quat_rotate_y(enemy->previous_yaw * M_PI / 180.0f),
+                                          vec3_create(1.0f, 1.0f, 1.0f));
+    Transform current = enemy_get_transform(enemy);
+    return transform_interpolate(&previous, &current, alpha);
+}
+
 Mat4 enemy_get_model_matrix(const Enemy* enemy) {
-    Mat4 translation = mat4_translate(enemy->position);
-    Mat4 rotation = mat4_rotate_y(enemy->yaw * M_PI / 180.0f);
-    return mat4_multiply(translation, rotation);
+    /* translate * rotate_y only fills in the translation column */
+    Mat4 model = mat4_rotate_y(enemy->yaw * M_PI / 180.0f);
+    model.m[12] = enemy->position.x;
+    model.m[13] = enemy->position.y;
+    model.m[14] = enemy->position.z;
+    return model;
 }
@@ -2,9 +2,15 @@
 #define ENEMY_H
 
 #include "../engine/core/types.h"
+#include "../engine/core/arena.h"
+#include "../engine/core/jobs.h"
 #include "../engine/math/vec3.h"
 #include "../engine/math/mat4.h"
+#include "../engine/math/vec3_stream.h"
+#include "../engine/math/transform.h"
+#include "../engine/renderer/culling.h"
 #include "../engine/renderer/mesh.h"
+#include "../engine/renderer/draw_list.h"
 #include "../engine/resource/terrain.h"
 
 /* Enemy state */
@@ -21,6 +27,9 @@ typedef struct {
     Vec3 position;
     Vec3 velocity;
     f32 yaw;
+    /* State at the start of the last tick, for render interpolation */
+    Vec3 previous_position;
+    f32 previous_yaw;
     f32 move_speed;
     f32 health;
     f32 max_health;
@@ -30,7 +39,7 @@ typedef struct {
     f32 attack_cooldown;
     f32 last_attack_time;
     EnemyState state;
-    Mesh* mesh;
+    MeshHandle mesh;
     f32 enemy_radius;
 } Enemy;
 
@@ -39,7 +48,16 @@ typedef struct {
     Enemy* enemies;
     u32 count;
     u32 capacity;
-    Mesh* shared_mesh;
+    MeshHandle shared_mesh;
+    JobSystem* jobs;  /* Optional; spreads large updates across threads */
+    /* Per-update batch scratch, sized with capacity */
+    Vec3Stream to_player;
+    f32* distances;
+    /* Culling scratch: world-space bounding spheres and visible indices */
+    Vec3Stream bounds_centers;
+    f32* bounds_radii;
+    u32* visible;
+    u32 visible_count;
 } EnemyManager;
 
 /* Create and destroy enemy manager */
@@ -56,6 +74,22 @@ void enemy_manager_update(EnemyManager* manager, Vec3 player_position,
 /* Check for attacks on player - returns damage dealt */
 f32 enemy_manager_check_attacks(EnemyManager* manager, Vec3 player_position, f32 current_time);
 
+/* Frustum-cull live enemies at their interpolated transforms; fills
+ * manager->visible and returns the count */
+u32 enemy_manager_cull(EnemyManager* manager, const Frustum* frustum, f32 alpha);
+
+/* Pick the shared mesh's LOD for each visible enemy from the list's camera
+ * and reorder manager->visible so each LOD's enemies are contiguous, in
+ * LOD order; lod_counts gets how many there are of each. The working
+ * arrays come from frame_arena and are left for its next reset */
+void enemy_manager_group_lods(EnemyManager* manager, const DrawList* list,
+                              Arena* frame_arena, u32 lod_counts[MESH_MAX_LODS]);
+
+/* Write the model transform at alpha and color of count enemies from
+ * manager->visible, starting at first, to instances */
+void enemy_manager_write_instances(const EnemyManager* manager, f32 alpha, Color color,
+                                   u32 first, u32 count, MeshInstance* instances);
+
 /* Get number of alive enemies */
 u32 enemy_manager_alive_count(const EnemyManager* manager);
 
@@ -63,8 +97,13 @@ u32 enemy_manager_alive_count(const EnemyManager* manager);
 void enemy_take_damage(Enemy* enemy, f32 damage);
 bool enemy_is_alive(const Enemy* enemy);
 Mat4 enemy_get_model_matrix(const Enemy* enemy);
+Transform enemy_get_transform(const Enemy* enemy);
+Transform enemy_get_interpolated_transform(const Enemy* enemy, f32 alpha);
 
 /* Set shared mesh for all enemies */
-void enemy_manager_set_mesh(EnemyManager* manager, Mesh* mesh);
+void enemy_manager_set_mesh(EnemyManager* manager, MeshHandle mesh);
+
+/* Run per-enemy updates on a job system (NULL = main thread only) */
+void enemy_manager_set_jobs(EnemyManager* manager, JobSystem* jobs);
 
 #endif /* ENEMY_H */
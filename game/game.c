@@ -1,60 +1,140 @@
 #include "game.h"
+#include "../engine/core/profiler.h"
+#include "../engine/core/timer.h"
 #include "../engine/input/input.h"
 #include "../engine/renderer/mesh.h"
 #include "../engine/renderer/camera.h"
+#include "../engine/renderer/frame_uniforms.h"
 #include "../engine/resource/obj_loader.h"
 #include <stdio.h>
 #include <stdlib.h>
 
-/* Shader sources */
+/* Compile-time shader features, bit i defining shader_features[i]; each
+ * draw asks for the variant with just the effects it shows */
+enum {
+    FEATURE_INSTANCING = 1u << 0,   /* Transform and color per instance (MeshInstance) */
+    FEATURE_SPECULAR = 1u << 1,
+    FEATURE_FOG = 1u << 2
+};
+static const char* const shader_features[] = { "INSTANCING", "SPECULAR", "FOG" };
+
+/* Instanced variants read attributes 3-6 instead of the per-object
+ * uniforms, so no other variant can stand in for them or they for it */
+#define INTERFACE_FEATURES FEATURE_INSTANCING
+
+/* Grass is matte; enemies shine */
+#define TERRAIN_FEATURES FEATURE_FOG
+#define ENEMY_FEATURES (FEATURE_INSTANCING | FEATURE_SPECULAR | FEATURE_FOG)
+
+/* Shader sources. Instanced normals go through the model's linear part,
+ * which is exact for the rotation and uniform scale instanced objects use;
+ * single objects get a normal matrix computed on the CPU. */
 static const char* vertex_shader_source = 
     "#version 330 core\n"
-    "layout (location = 0) in vec3 aPos;\n"
-    "layout (location = 1) in vec3 aNormal;\n"
-    "layout (location = 2) in vec2 aTexCoord;\n"
+    MESH_VERTEX_GLSL
+    "#ifdef INSTANCING\n"
+    "layout (location = 3) in vec4 aModelRow0;\n"
+    "layout (location = 4) in vec4 aModelRow1;\n"
+    "layout (location = 5) in vec4 aModelRow2;\n"
+    "layout (location = 6) in vec4 aColor;\n"
+    "#else\n"
+    "uniform mat3x4 model;\n"        /* packed affine rows, see Mat3x4 */
+    "uniform mat3 normalMatrix;\n"
+    "uniform vec4 objectColor;\n"
+    "#endif\n"
     "out vec3 FragPos;\n"
     "out vec3 Normal;\n"
     "out vec2 TexCoord;\n"
-    "uniform mat4 model;\n"
-    "uniform mat4 view;\n"
-    "uniform mat4 projection;\n"
+    "out vec4 Color;\n"
+    FRAME_UNIFORMS_GLSL
     "void main() {\n"
-    "    FragPos = vec3(model * vec4(aPos, 1.0));\n"
-    "    Normal = mat3(transpose(inverse(model))) * aNormal;\n"
+    "#ifdef INSTANCING\n"
+    "    mat3x4 model = mat3x4(aModelRow0, aModelRow1, aModelRow2);\n"
+    "    Normal = vec4(meshNormal(), 0.0) * model;\n"
+    "    Color = aColor;\n"
+    "#else\n"
+    "    Normal = normalMatrix * meshNormal();\n"
+    "    Color = objectColor;\n"
+    "#endif\n"
+    "    FragPos = vec4(meshPosition(), 1.0) * model;\n"
     "    TexCoord = aTexCoord;\n"
-    "    gl_Position = projection * view * vec4(FragPos, 1.0);\n"
+    "    gl_Position = viewProjection * vec4(FragPos, 1.0);\n"
+    "}\n";
+
+/* Terrain chunks: the grid mesh placed per node and raised from the height
+ * texture (see terrain.h) */
+static const char* terrain_vertex_shader_source = 
+    "#version 330 core\n"
+    MESH_VERTEX_GLSL
+    FRAME_UNIFORMS_GLSL
+    TERRAIN_VERTEX_GLSL
+    "out vec3 FragPos;\n"
+    "out vec3 Normal;\n"
+    "out vec2 TexCoord;\n"
+    "out vec4 Color;\n"
+    "void main() {\n"
+    "    terrainVertex(FragPos, Normal, TexCoord);\n"
+    "    Color = aColor;\n"
+    "    gl_Position = viewProjection * vec4(FragPos, 1.0);\n"
     "}\n";
 
+/* Fog fades to the engine's clear color */
 static const char* fragment_shader_source = 
     "#version 330 core\n"
     "out vec4 FragColor;\n"
     "in vec3 FragPos;\n"
     "in vec3 Normal;\n"
     "in vec2 TexCoord;\n"
-    "uniform vec3 lightDir;\n"
-    "uniform vec3 lightColor;\n"
-    "uniform vec4 objectColor;\n"
-    "uniform vec3 viewPos;\n"
+    "in vec4 Color;\n"
+    FRAME_UNIFORMS_GLSL
     "void main() {\n"
     "    // Ambient\n"
     "    float ambientStrength = 0.3;\n"
-    "    vec3 ambient = ambientStrength * lightColor;\n"
+    "    vec3 ambient = ambientStrength * lightColor.rgb;\n"
     "    // Diffuse\n"
     "    vec3 norm = normalize(Normal);\n"
-    "    float diff = max(dot(norm, -lightDir), 0.0);\n"
-    "    vec3 diffuse = diff * lightColor;\n"
-    "    // Specular\n"
+    "    float diff = max(dot(norm, -lightDir.xyz), 0.0);\n"
+    "    vec3 diffuse = diff * lightColor.rgb;\n"
+    "    vec3 lighting = ambient + diffuse;\n"
+    "#ifdef SPECULAR\n"
     "    float specularStrength = 0.5;\n"
-    "    vec3 viewDir = normalize(viewPos - FragPos);\n"
-    "    vec3 reflectDir = reflect(lightDir, norm);\n"
+    "    vec3 viewDir = normalize(viewPos.xyz - FragPos);\n"
+    "    vec3 reflectDir = reflect(lightDir.xyz, norm);\n"
     "    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);\n"
-    "    vec3 specular = specularStrength * spec * lightColor;\n"
+    "    lighting += specularStrength * spec * lightColor.rgb;\n"
+    "#endif\n"
     "    // Result\n"
-    "    vec3 result = (ambient + diffuse + specular) * objectColor.rgb;\n"
-    "    FragColor = vec4(result, objectColor.a);\n"
+    "    vec3 result = lighting * Color.rgb;\n"
+    "#ifdef FOG\n"
+    "    const vec3 fogColor = vec3(0.2, 0.3, 0.4);\n"
+    "    const float fogDensity = 0.01;\n"
+    "    float fogAmount = fogDensity * length(viewPos.xyz - FragPos);\n"
+    "    result = mix(fogColor, result, exp(-fogAmount * fogAmount));\n"
+    "#endif\n"
+    "    FragColor = vec4(result, Color.a);\n"
     "}\n";
 
+/* Rotate the recorded view by the cursor motion that arrived after the
+ * frame was simulated. Only the view changes: culling was done with the
+ * slightly older camera, which a few degrees of motion don't upset. */
+static void game_late_latch(void* user, f64 mouse_dx, f64 mouse_dy, DrawList* list) {
+    Game* game = (Game*)user;
+    if (game->game_over || (mouse_dx == 0.0 && mouse_dy == 0.0)) return;
+    
+    Camera camera = *player_get_camera(game->player);
+    camera_process_mouse(&camera, (f32)mouse_dx, (f32)(-mouse_dy), true);
+    Mat4 view = camera_get_view_matrix(&camera);
+    Mat4 projection = list->projection;
+    draw_list_set_camera(list, &view, &projection, camera.position);
+}
+
 Game* game_create(void) {
+    EngineConfig config = engine_default_config();
+    config.window_title = "3D Game - WASD to move, Mouse to look, Space to jump";
+    return game_create_with_config(&config);
+}
+
+Game* game_create_with_config(const EngineConfig* config) {
     Game* game = (Game*)malloc(sizeof(Game));
     if (!game) return NULL;
     
@@ -63,44 +143,58 @@ Game* game_create(void) {
     game->player = NULL;
     game->enemies = NULL;
     game->terrain = NULL;
-    game->shader = NULL;
-    game->player_mesh = NULL;
-    game->enemy_mesh = NULL;
+    game->shader = (ShaderHandle){INVALID_HANDLE};
+    game->terrain_shader = (ShaderHandle){INVALID_HANDLE};
+    game->player_mesh = (MeshHandle){INVALID_HANDLE};
+    game->enemy_mesh = (MeshHandle){INVALID_HANDLE};
     game->game_over = false;
     game->paused = false;
+    game->mouse_captured = false;
+    game->simulation_time = 0.0;
+    game->interpolation_alpha = 1.0f;
     
     /* Create engine */
-    EngineConfig config = engine_default_config();
-    config.window_title = "3D Game - WASD to move, Mouse to look, Space to jump";
-    game->engine = engine_create(&config);
+    game->engine = engine_create(config);
     if (!game->engine) {
         fprintf(stderr, "Failed to create engine\n");
         free(game);
         return NULL;
     }
     
-    /* Create shader */
-    game->shader = shader_create(vertex_shader_source, fragment_shader_source);
-    if (!game->shader) {
+    /* Create shaders; the enemies' variant compiles while the rest loads,
+     * on driver threads where the driver can */
+    u32 feature_count = sizeof(shader_features) / sizeof(shader_features[0]);
+    game->shader = shader_create_variants(vertex_shader_source, fragment_shader_source,
+                                          shader_features, feature_count, INTERFACE_FEATURES);
+    game->terrain_shader = shader_create_variants(terrain_vertex_shader_source,
+                                                  fragment_shader_source, shader_features,
+                                                  feature_count, INTERFACE_FEATURES);
+    if (!HANDLE_IS_VALID(game->shader) || !HANDLE_IS_VALID(game->terrain_shader)) {
         fprintf(stderr, "Failed to create shader\n");
+        shader_destroy(game->shader);
+        shader_destroy(game->terrain_shader);
         engine_destroy(game->engine);
         free(game);
         return NULL;
     }
+    const u32 enemy_features = ENEMY_FEATURES;
+    shader_prepare_variants(game->shader, &enemy_features, 1);
     
     /* Create terrain */
     game->terrain = terrain_create_procedural(64, 64, 2.0f, 10.0f, 2.0f);
     if (!game->terrain) {
         fprintf(stderr, "Failed to create terrain\n");
         shader_destroy(game->shader);
+        shader_destroy(game->terrain_shader);
         engine_destroy(game->engine);
         free(game);
         return NULL;
     }
+    terrain_setup_shader(game->terrain, game->terrain_shader, TERRAIN_FEATURES);
     
     /* Load or create player mesh */
     game->player_mesh = obj_loader_load("assets/models/player.obj");
-    if (!game->player_mesh) {
+    if (!HANDLE_IS_VALID(game->player_mesh)) {
         /* Create a simple cube as fallback */
         game->player_mesh = mesh_create_cube(1.0f);
     }
@@ -114,6 +208,7 @@ Game* game_create(void) {
         mesh_destroy(game->player_mesh);
         terrain_destroy(game->terrain);
         shader_destroy(game->shader);
+        shader_destroy(game->terrain_shader);
         engine_destroy(game->engine);
         free(game);
         return NULL;
@@ -122,16 +217,17 @@ Game* game_create(void) {
     /* Update camera aspect ratio */
     i32 width, height;
     engine_get_window_size(game->engine, &width, &height);
-    camera_set_aspect_ratio(game->player->camera, (f32)width / (f32)height);
+    camera_set_aspect_ratio(player_get_camera(game->player), (f32)width / (f32)height);
     
     /* Capture mouse for camera control */
+    game->mouse_captured = true;
     engine_set_mouse_captured(game->engine, true);
     
     /* Load or create enemy mesh */
     game->enemy_mesh = obj_loader_load("assets/models/enemy.obj");
-    if (!game->enemy_mesh) {
+    if (!HANDLE_IS_VALID(game->enemy_mesh)) {
         /* Create a simple sphere as fallback */
-        game->enemy_mesh = mesh_create_sphere(0.5f, 16, 16);
+        game->enemy_mesh = mesh_create_sphere(0.5f, 32, 32);
     }
     
     /* Create enemy manager and spawn enemies */
@@ -143,12 +239,15 @@ Game* game_create(void) {
         mesh_destroy(game->enemy_mesh);
         terrain_destroy(game->terrain);
         shader_destroy(game->shader);
+        shader_destroy(game->terrain_shader);
         engine_destroy(game->engine);
         free(game);
         return NULL;
     }
+    enemy_manager_set_jobs(game->enemies, engine_get_jobs(game->engine));
     
     enemy_manager_set_mesh(game->enemies, game->enemy_mesh);
+    engine_set_late_latch(game->engine, game_late_latch, game);
     
     /* Spawn some enemies around the terrain */
     f32 spawn_positions[][2] = {
@@ -182,40 +281,58 @@ Game* game_create(void) {
 void game_destroy(Game* game) {
     if (!game) return;
     
+    /* Meshes and shaders below are freed with GL calls on this thread */
+    if (game->engine) engine_finish_rendering(game->engine);
+    
     if (game->enemies) enemy_manager_destroy(game->enemies);
     if (game->player) player_destroy(game->player);
-    if (game->player_mesh) mesh_destroy(game->player_mesh);
-    if (game->enemy_mesh) mesh_destroy(game->enemy_mesh);
+    mesh_destroy(game->player_mesh);
+    mesh_destroy(game->enemy_mesh);
     if (game->terrain) terrain_destroy(game->terrain);
-    if (game->shader) shader_destroy(game->shader);
+    shader_destroy(game->shader);
+    shader_destroy(game->terrain_shader);
     if (game->engine) engine_destroy(game->engine);
     
     free(game);
 }
 
-void game_update(Game* game, f32 delta_time) {
-    if (!game || game->game_over) return;
+void game_handle_input(Game* game) {
+    if (!game) return;
     
     InputState* input = engine_get_input(game->engine);
     
     /* Check for escape key */
     if (input_key_pressed(input, KEY_ESCAPE)) {
-        /* Toggle mouse capture or quit */
-        static bool mouse_captured = true;
-        mouse_captured = !mouse_captured;
-        engine_set_mouse_captured(game->engine, mouse_captured);
+        /* Toggle mouse capture */
+        game->mouse_captured = !game->mouse_captured;
+        engine_set_mouse_captured(game->engine, game->mouse_captured);
     }
     
-    /* Update player */
-    player_update(game->player, input, game->terrain, delta_time);
-    
     /* Update camera aspect ratio if window was resized */
     i32 width, height;
     engine_get_window_size(game->engine, &width, &height);
-    camera_set_aspect_ratio(game->player->camera, (f32)width / (f32)height);
+    camera_set_aspect_ratio(player_get_camera(game->player), (f32)width / (f32)height);
+    
+    if (game->game_over) return;
     
-    /* Update enemies */
-    f64 current_time = engine_get_time(game->engine);
+    /* Mouse look runs at frame rate, movement at tick rate */
+    player_handle_input(game->player, input);
+}
+
+void game_update(Game* game, f32 delta_time) {
+    if (!game || game->game_over) return;
+    
+    PROFILE_BEGIN("game_update");
+    
+    InputState* input = engine_get_input(game->engine);
+    
+    /* Update player */
+    player_update(game->player, input, game->terrain, delta_time);
+    
+    /* Update enemies; attack cooldowns run on simulation time so they are
+     * independent of frame rate */
+    game->simulation_time += delta_time;
+    f64 current_time = game->simulation_time;
     enemy_manager_update(game->enemies, game->player->position, 
                          game->terrain, delta_time, (f32)current_time);
     
@@ -232,46 +349,59 @@ void game_update(Game* game, f32 delta_time) {
         game->game_over = true;
         printf("Game Over! You died.\n");
     }
+    
+    PROFILE_END();
 }
 
 void game_render(Game* game) {
     if (!game) return;
     
+    DrawList* list = engine_get_draw_list(game->engine);
+    if (!list) return;
+    
+    PROFILE_BEGIN("game_render");
+    
     Camera* camera = player_get_camera(game->player);
+    player_update_camera(game->player, game->interpolation_alpha);
     Mat4 view = camera_get_view_matrix(camera);
     Mat4 projection = camera_get_projection_matrix(camera);
+    const Frustum* frustum = camera_get_frustum(camera);
     
-    /* Use shader */
-    shader_use(game->shader);
-    shader_set_mat4(game->shader, "view", &view);
-    shader_set_mat4(game->shader, "projection", &projection);
+    /* Record the frame; the engine draws it, possibly on the render thread */
+    draw_list_set_camera(list, &view, &projection, camera->position);
     
     /* Set lighting */
     Vec3 light_dir = vec3_normalize(vec3_create(-0.5f, -1.0f, -0.5f));
-    shader_set_vec3(game->shader, "lightDir", light_dir);
-    shader_set_vec3(game->shader, "lightColor", vec3_create(1.0f, 1.0f, 0.9f));
-    shader_set_vec3(game->shader, "viewPos", camera->position);
-    
-    /* Draw terrain */
-    Mat4 terrain_model = mat4_identity();
-    shader_set_mat4(game->shader, "model", &terrain_model);
-    shader_set_color(game->shader, "objectColor", color_create(0.3f, 0.6f, 0.2f, 1.0f));
-    terrain_draw(game->terrain);
-    
-    /* Draw enemies */
-    shader_set_color(game->shader, "objectColor", color_create(0.8f, 0.2f, 0.2f, 1.0f));
-    for (u32 i = 0; i < game->enemies->count; i++) {
-        Enemy* enemy = &game->enemies->enemies[i];
-        if (!enemy_is_alive(enemy)) continue;
-        
-        Mat4 enemy_model = enemy_get_model_matrix(enemy);
-        shader_set_mat4(game->shader, "model", &enemy_model);
-        if (enemy->mesh) {
-            mesh_draw(enemy->mesh);
-        }
+    draw_list_set_light(list, light_dir, vec3_create(1.0f, 1.0f, 0.9f));
+    
+    /* The world is one layer; the render queue picks the draw order */
+    draw_list_begin_pass(list, "opaque");
+    
+    /* Draw the visible terrain chunks at the detail their distance needs */
+    terrain_draw(game->terrain, list, frustum, game->terrain_shader, TERRAIN_FEATURES,
+                 color_create(0.3f, 0.6f, 0.2f, 1.0f));
+    
+    /* Draw visible enemies; they share one mesh, so one instanced call per
+     * LOD in use */
+    Color enemy_color = color_create(0.8f, 0.2f, 0.2f, 1.0f);
+    enemy_manager_cull(game->enemies, frustum, game->interpolation_alpha);
+    u32 lod_counts[MESH_MAX_LODS];
+    enemy_manager_group_lods(game->enemies, list, engine_get_frame_arena(game->engine),
+                             lod_counts);
+    u32 first = 0;
+    for (u32 lod = 0; lod < MESH_MAX_LODS; lod++) {
+        if (lod_counts[lod] == 0) continue;
+        MeshInstance* instances = draw_list_add_instances(list, game->shader, ENEMY_FEATURES,
+                                                          game->enemies->shared_mesh, lod,
+                                                          lod_counts[lod]);
+        enemy_manager_write_instances(game->enemies, game->interpolation_alpha, enemy_color,
+                                      first, lod_counts[lod], instances);
+        first += lod_counts[lod];
     }
     
     /* Note: Player model is not drawn in first-person view */
+    
+    PROFILE_END();
 }
 
 void game_run(Game* game) {
@@ -281,15 +411,60 @@ void game_run(Game* game) {
         engine_poll_events(game->engine);
         engine_begin_frame(game->engine);
         
-        f32 delta_time = engine_get_delta_time(game->engine);
+        game_handle_input(game);
+        
+        /* Simulate in fixed ticks, render whatever fraction is left over */
+        u32 steps = engine_get_fixed_steps(game->engine);
+        f32 fixed_delta = engine_get_fixed_delta(game->engine);
+        u64 update_start = timer_now_ns();
+        for (u32 i = 0; i < steps; i++) {
+            game_update(game, fixed_delta);
+        }
+        frame_stats_record(engine_get_stats(game->engine), FRAME_STAT_UPDATE,
+                           (f64)(timer_now_ns() - update_start) * 1e-6);
+        game->interpolation_alpha = engine_get_interpolation_alpha(game->engine);
         
-        game_update(game, delta_time);
         game_render(game);
         
         engine_end_frame(game->engine);
+        
+        /* Nobody is watching a headless run, so it ends with the player */
+        if (game->game_over && engine_is_headless(game->engine)) {
+            engine_request_close(game->engine);
+        }
     }
 }
 
 bool game_is_running(Game* game) {
     return game && !game->game_over && !engine_should_close(game->engine);
 }
+
+/* FNV-1a over the raw bytes, so any bit of difference shows */
+static u64 hash_bytes(u64 hash, const void* data, size_t size) {
+    const u8* bytes = (const u8*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+u64 game_state_hash(const Game* game) {
+    u64 hash = 0xCBF29CE484222325ull;
+    const Player* player = game->player;
+    hash = hash_bytes(hash, &player->position, sizeof(player->position));
+    hash = hash_bytes(hash, &player->velocity, sizeof(player->velocity));
+    hash = hash_bytes(hash, &player->yaw, sizeof(player->yaw));
+    hash = hash_bytes(hash, &player->pitch, sizeof(player->pitch));
+    hash = hash_bytes(hash, &player->health, sizeof(player->health));
+    
+    for (u32 i = 0; i < game->enemies->count; i++) {
+        const Enemy* enemy = &game->enemies->enemies[i];
+        hash = hash_bytes(hash, &enemy->position, sizeof(enemy->position));
+        hash = hash_bytes(hash, &enemy->yaw, sizeof(enemy->yaw));
+        hash = hash_bytes(hash, &enemy->health, sizeof(enemy->health));
+        hash = hash_bytes(hash, &enemy->state, sizeof(enemy->state));
+    }
+    hash = hash_bytes(hash, &game->simulation_time, sizeof(game->simulation_time));
+    return hash;
+}
@@ -14,23 +14,33 @@ typedef struct {
     Player* player;
     EnemyManager* enemies;
     Terrain* terrain;
-    Shader* shader;
-    Mesh* player_mesh;
-    Mesh* enemy_mesh;
+    ShaderHandle shader;            /* Variants by the features in game.c */
+    ShaderHandle terrain_shader;    /* For terrain chunks, same features */
+    MeshHandle player_mesh;
+    MeshHandle enemy_mesh;
     bool game_over;
     bool paused;
+    bool mouse_captured;
+    f64 simulation_time;      /* Sum of fixed ticks simulated so far */
+    f32 interpolation_alpha;  /* Blend between the last two ticks for rendering */
 } Game;
 
 /* Game lifecycle */
 Game* game_create(void);
+Game* game_create_with_config(const EngineConfig* config);
 void game_destroy(Game* game);
 void game_run(Game* game);
 
 /* Game update and render */
-void game_update(Game* game, f32 delta_time);
-void game_render(Game* game);
+void game_handle_input(Game* game);            /* Once per rendered frame */
+void game_update(Game* game, f32 delta_time);  /* Once per fixed tick */
+void game_render(Game* game);                  /* Uses game->interpolation_alpha */
 
 /* Game state */
 bool game_is_running(Game* game);
 
+/* Hash of the simulation state (player and enemies); equal hashes after a
+ * recording and its replay show the session was reproduced exactly */
+u64 game_state_hash(const Game* game);
+
 #endif /* GAME_H */
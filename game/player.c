@@ -1,4 +1,5 @@
 #include "player.h"
+#include "../engine/core/profiler.h"
 #include <stdlib.h>
 #include <math.h>
 
@@ -6,11 +7,12 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-Player* player_create(Vec3 start_position, Mesh* mesh) {
+Player* player_create(Vec3 start_position, MeshHandle mesh) {
     Player* player = (Player*)malloc(sizeof(Player));
     if (!player) return NULL;
     
     player->position = start_position;
+    player->previous_position = start_position;
     player->velocity = vec3_create(0, 0, 0);
     player->yaw = -90.0f;
     player->pitch = 0.0f;
@@ -21,6 +23,7 @@ Player* player_create(Vec3 start_position, Mesh* mesh) {
     player->max_health = 100.0f;
     player->on_ground = false;
     player->is_jumping = false;
+    player->jump_requested = false;
     player->mesh = mesh;
     player->camera_height = 1.7f;
     player->player_radius = 0.5f;
@@ -28,12 +31,13 @@ Player* player_create(Vec3 start_position, Mesh* mesh) {
     /* Create camera */
     Vec3 camera_pos = vec3_add(start_position, vec3_create(0, player->camera_height, 0));
     player->camera = camera_create(camera_pos, player->yaw, player->pitch);
-    if (!player->camera) {
+    Camera* camera = camera_get(player->camera);
+    if (!camera) {
         free(player);
         return NULL;
     }
     
-    player->camera->move_speed = player->move_speed;
+    camera->move_speed = player->move_speed;
     
     return player;
 }
@@ -41,14 +45,12 @@ Player* player_create(Vec3 start_position, Mesh* mesh) {
 void player_destroy(Player* player) {
     if (!player) return;
     
-    if (player->camera) {
-        camera_destroy(player->camera);
-    }
-    /* Note: mesh is not destroyed here as it's owned by the resource manager */
+    camera_destroy(player->camera);
+    /* The mesh handle is shared and destroyed by its owner */
     free(player);
 }
 
-void player_update(Player* player, const InputState* input, const Terrain* terrain, f32 delta_time) {
+void player_handle_input(Player* player, const InputState* input) {
     if (!player || !input) return;
     
     /* Process mouse input for camera rotation */
@@ -56,14 +58,28 @@ void player_update(Player* player, const InputState* input, const Terrain* terra
     input_get_mouse_delta(input, &dx, &dy);
     
     if (dx != 0.0 || dy != 0.0) {
-        camera_process_mouse(player->camera, (f32)dx, (f32)(-dy), true);
-        player->yaw = player->camera->yaw;
-        player->pitch = player->camera->pitch;
+        Camera* camera = camera_get(player->camera);
+        camera_process_mouse(camera, (f32)dx, (f32)(-dy), true);
+        player->yaw = camera->yaw;
+        player->pitch = camera->pitch;
     }
     
+    if (input_key_pressed(input, KEY_SPACE)) {
+        player->jump_requested = true;
+    }
+}
+
+void player_update(Player* player, const InputState* input, const Terrain* terrain, f32 delta_time) {
+    if (!player || !input) return;
+    
+    PROFILE_BEGIN("player_update");
+    
+    player->previous_position = player->position;
+    
     /* Calculate movement direction based on camera */
-    Vec3 flat_front = camera_get_flat_front(player->camera);
-    Vec3 right = player->camera->right;
+    Camera* camera = camera_get(player->camera);
+    Vec3 flat_front = camera_get_flat_front(camera);
+    Vec3 right = camera->right;
     
     /* Horizontal movement */
     Vec3 move_dir = vec3_create(0, 0, 0);
@@ -91,9 +107,10 @@ void player_update(Player* player, const InputState* input, const Terrain* terra
     player->velocity.z = move_dir.z * player->move_speed;
     
     /* Jump */
-    if (input_key_pressed(input, KEY_SPACE) && player->on_ground) {
+    if (player->jump_requested && player->on_ground) {
         player_jump(player);
     }
+    player->jump_requested = false;
     
     /* Apply gravity */
     if (!player->on_ground) {
@@ -126,13 +143,32 @@ void player_update(Player* player, const InputState* input, const Terrain* terra
     }
     
     /* Update camera position */
-    player->camera->position = vec3_add(player->position, vec3_create(0, player->camera_height, 0));
+    camera->position = vec3_add(player->position, vec3_create(0, player->camera_height, 0));
+    
+    PROFILE_END();
+}
+
+Vec3 player_get_interpolated_position(const Player* player, f32 alpha) {
+    return vec3_lerp(player->previous_position, player->position, alpha);
+}
+
+void player_update_camera(Player* player, f32 alpha) {
+    Vec3 position = player_get_interpolated_position(player, alpha);
+    camera_get(player->camera)->position = vec3_add(position, vec3_create(0, player->camera_height, 0));
+}
+
+Transform player_get_transform(const Player* player) {
+    return transform_create(player->position, quat_rotate_y(player->yaw * M_PI / 180.0f),
+                            vec3_create(1.0f, 1.0f, 1.0f));
 }
 
 Mat4 player_get_model_matrix(const Player* player) {
-    Mat4 translation = mat4_translate(player->position);
-    Mat4 rotation = mat4_rotate_y(player->yaw * M_PI / 180.0f);
-    return mat4_multiply(translation, rotation);
+    /* translate * rotate_y only fills in the translation column */
+    Mat4 model = mat4_rotate_y(player->yaw * M_PI / 180.0f);
+    model.m[12] = player->position.x;
+    model.m[13] = player->position.y;
+    model.m[14] = player->position.z;
+    return model;
 }
 
 void player_jump(Player* player) {
@@ -155,5 +191,5 @@ bool player_is_alive(const Player* player) {
 }
 
 Camera* player_get_camera(const Player* player) {
-    return player->camera;
+    return camera_get(player->camera);
 }
@@ -3,6 +3,7 @@
 
 #include "../engine/core/types.h"
 #include "../engine/math/vec3.h"
+#include "../engine/math/transform.h"
 #include "../engine/renderer/mesh.h"
 #include "../engine/renderer/camera.h"
 #include "../engine/input/input.h"
@@ -11,6 +12,7 @@
 /* Player state */
 typedef struct {
     Vec3 position;
+    Vec3 previous_position; /* Position at the start of the last tick */
     Vec3 velocity;
     f32 yaw;
     f32 pitch;
@@ -21,21 +23,31 @@ typedef struct {
     f32 max_health;
     bool on_ground;
     bool is_jumping;
-    Mesh* mesh;
-    Camera* camera;
+    bool jump_requested;    /* Latched per frame, consumed by the next tick */
+    MeshHandle mesh;
+    CameraHandle camera;
     f32 camera_height;
     f32 player_radius;
 } Player;
 
 /* Create and destroy player */
-Player* player_create(Vec3 start_position, Mesh* mesh);
+Player* player_create(Vec3 start_position, MeshHandle mesh);
 void player_destroy(Player* player);
 
-/* Update player */
+/* Per-frame input: mouse look and latching edge-triggered actions, so they
+ * are neither lost nor repeated however many ticks run this frame */
+void player_handle_input(Player* player, const InputState* input);
+
+/* Fixed-step simulation tick */
 void player_update(Player* player, const InputState* input, const Terrain* terrain, f32 delta_time);
 
+/* Place the camera at the position interpolated between the last two ticks */
+Vec3 player_get_interpolated_position(const Player* player, f32 alpha);
+void player_update_camera(Player* player, f32 alpha);
+
 /* Get player transform matrix */
 Mat4 player_get_model_matrix(const Player* player);
+Transform player_get_transform(const Player* player);
 
 /* Player actions */
 void player_jump(Player* player);
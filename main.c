@@ -1,19 +1,91 @@
 #include "game/game.h"
+#include "engine/core/timer.h"
+#include "engine/renderer/gpu_profiler.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void print_usage(const char* program) {
+    printf("Usage: %s [--headless] [--frames N] [--profile-budget MS] [--no-render-thread]\n"
+           "       [--render-queue N] [--late-latch] [--lod-bias X] [--stats-csv PATH]\n"
+           "       [--record PATH] [--replay PATH] [--shader-cache DIR] [--no-shader-cache]\n", program);
+    printf("  --headless           Run without a window or GL context, as fast as possible\n");
+    printf("  --frames N           Exit after N frames\n");
+    printf("  --profile-budget MS  Write a profiler trace when a frame takes longer\n");
+    printf("  --no-render-thread   Issue GL calls from the main thread\n");
+    printf("  --render-queue N     Frames the game may run ahead of the render thread (1-3)\n");
+    printf("  --late-latch         Re-aim the view with mouse input polled just before submission\n");
+    printf("  --lod-bias X         Scale the screen error mesh LODs may show (default 1, higher = coarser)\n");
+    printf("  --stats-csv PATH     Write per-frame frame/update/render/input times to a CSV file\n");
+    printf("  --record PATH        Record input and frame times for replay\n");
+    printf("  --replay PATH        Play back a recording as fast as possible, then exit\n");
+    printf("  --shader-cache DIR   Keep linked shader binaries in DIR (default shader_cache)\n");
+    printf("  --no-shader-cache    Compile every shader from source\n");
+}
 
 int main(int argc, char* argv[]) {
-    (void)argc;
-    (void)argv;
+    EngineConfig config = engine_default_config();
+    config.window_title = "3D Game - WASD to move, Mouse to look, Space to jump";
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            config.headless = true;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            config.max_frames = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--profile-budget") == 0 && i + 1 < argc) {
+            config.profile_budget_ms = (f32)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--no-render-thread") == 0) {
+            config.render_thread = false;
+        } else if (strcmp(argv[i], "--render-queue") == 0 && i + 1 < argc) {
+            config.render_queue_depth = (u32)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--stats-csv") == 0 && i + 1 < argc) {
+            config.stats_csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            config.record_path = argv[++i];
+        } else if (strcmp(argv[i], "--late-latch") == 0) {
+            config.late_latch = true;
+        } else if (strcmp(argv[i], "--lod-bias") == 0 && i + 1 < argc) {
+            config.lod_bias = (f32)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            config.replay_path = argv[++i];
+            /* Frame times come from the recording; don't wait on the display */
+            config.vsync = false;
+        } else if (strcmp(argv[i], "--shader-cache") == 0 && i + 1 < argc) {
+            config.shader_cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--no-shader-cache") == 0) {
+            config.shader_cache_dir = NULL;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
     
     printf("Starting 3D Game Engine...\n");
     
-    Game* game = game_create();
+    Game* game = game_create_with_config(&config);
     if (!game) {
         fprintf(stderr, "Failed to create game\n");
         return 1;
     }
+    if (config.replay_path && !engine_is_replaying(game->engine)) {
+        game_destroy(game);
+        return 1;
+    }
     
+    f64 start = timer_now_seconds();
     game_run(game);
+    f64 elapsed = timer_now_seconds() - start;
+    
+    if (config.headless) {
+        u64 frames = engine_get_frame_count(game->engine);
+        printf("Headless run: %llu frames in %.3f s (%.0f frames/s)\n",
+               (unsigned long long)frames, elapsed, elapsed > 0.0 ? frames / elapsed : 0.0);
+    }
+    frame_stats_print(engine_get_stats(game->engine), FRAME_STATS_TOTAL);
+    gpu_profiler_print();
+    if (engine_is_recording(game->engine) || engine_is_replaying(game->engine)) {
+        printf("Simulation state hash: %016llx\n", (unsigned long long)game_state_hash(game));
+    }
     
     game_destroy(game);
     